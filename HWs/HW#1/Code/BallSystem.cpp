@@ -0,0 +1,590 @@
+#include "BallSystem.h"
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#define BALL_EVENT_WALL 0 // reaches a wall
+#define BALL_EVENT_STOP 1 // sliding speed drops to zero, static friction may hold it
+#define BALL_EVENT_TURN 2 // sliding direction is taken again when other forces turn the velocity
+
+void BallSystem::reset(const BallScene& scene, int count) {
+	count = std::max(count, 1);
+	for (auto* v : { &px, &py, &pz, &vx, &vy, &vz, &invMass, &radius, &ax, &ay, &az, &nx, &ny, &nz, &nvx, &nvy, &nvz, &fraction })
+		v->assign(count, 0.0f);
+	restSteps.assign(count, 0);
+	resting.assign(count, 0);
+	restWall.assign(count, BALL_NO_WALL);
+	wall.assign(count, BALL_NO_WALL);
+	pinned.assign(count, 0);
+	since.assign(count, 0.0);
+
+	// the same scene always spreads its balls the same way
+	std::mt19937 rng(12345);
+	float limit = std::max(scene.cubeSize / 2.0f - scene.radius, 0.0f);
+	std::uniform_real_distribution<float> spread(-limit, limit);
+	for (int i = 0; i < count; i++) {
+		glm::vec3 p = i == 0 ? scene.position : glm::vec3(spread(rng), spread(rng), spread(rng));
+		px[i] = p.x;
+		py[i] = p.y;
+		pz[i] = p.z;
+		vx[i] = scene.velocity.x;
+		vy[i] = scene.velocity.y;
+		vz[i] = scene.velocity.z;
+		invMass[i] = 1.0f / scene.m;
+		radius[i] = scene.radius;
+	}
+	awake = count;
+	bounces = 0;
+	t = 0.0f;
+	setForces(scene);
+}
+
+// resting balls need no wake up here, wake() checks them against the new forces next step
+void BallSystem::setForces(const BallScene& scene) {
+	forces.build(scene);
+}
+
+void BallSystem::setRadius(float r) {
+	std::fill(radius.begin(), radius.end(), r);
+	// a ball resting against a wall that moved has to fall again
+	std::fill(resting.begin(), resting.end(), 0);
+	std::fill(restSteps.begin(), restSteps.end(), 0);
+}
+
+double BallSystem::energy(const BallScene& scene) const {
+	double e = 0.0;
+	int n = size();
+	for (int i = 0; i < n; i++) {
+		double v2 = (double)vx[i] * vx[i] + (double)vy[i] * vy[i] + (double)vz[i] * vz[i];
+		double height = (double)scene.gravity.x * px[i] + (double)scene.gravity.y * py[i] + (double)scene.gravity.z * pz[i];
+		e += (0.5 * v2 - height) / invMass[i];
+	}
+	return e;
+}
+
+void BallSystem::step(const BallScene& scene) {
+	float h = scene.timestep;
+	setAcceleration();
+	wake(scene);
+	integrate(h);
+	checkCollision(scene);
+	findFraction(scene);
+	collResponse(scene, h);
+	collideBalls(scene, h);
+	settle(scene);
+	t += h;
+}
+
+// all fields over all balls, resting ones included since wake() needs their net force
+void BallSystem::setAcceleration() {
+	BallBatch b;
+	b.px = px.data();
+	b.py = py.data();
+	b.pz = pz.data();
+	b.vx = vx.data();
+	b.vy = vy.data();
+	b.vz = vz.data();
+	b.invMass = invMass.data();
+	b.ax = ax.data();
+	b.ay = ay.data();
+	b.az = az.data();
+	b.n = size();
+	forces.apply(b);
+}
+
+// a resting ball stays put while the net force presses it into its wall and friction
+// can hold the tangential part
+void BallSystem::wake(const BallScene& scene) {
+	int n = size();
+	for (int i = 0; i < n; i++) {
+		if (!resting[i])
+			continue;
+		int w = restWall[i];
+		float a[3] = { ax[i], ay[i], az[i] };
+		float sign = (w & 1) ? 1.0f : -1.0f; // the normal points back into the cube
+		float an = a[w / 2] * sign;
+		float at2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2] - an * an;
+		if (an > 0.0f || at2 > scene.mu * scene.mu * an * an) {
+			resting[i] = 0;
+			restSteps[i] = 0;
+		}
+	}
+}
+
+// explicit euler, the position moves with the velocity from the start of the step
+void BallSystem::integrate(float h) {
+	int n = size();
+	for (int i = 0; i < n; i++) {
+		float live = resting[i] ? 0.0f : 1.0f;
+		nx[i] = px[i] + live * vx[i] * h;
+		ny[i] = py[i] + live * vy[i] * h;
+		nz[i] = pz[i] + live * vz[i] * h;
+		nvx[i] = live * (vx[i] + ax[i] * h);
+		nvy[i] = live * (vy[i] + ay[i] * h);
+		nvz[i] = live * (vz[i] + az[i] * h);
+	}
+}
+
+// the first wall the end position is past, in x, y, z order
+void BallSystem::checkCollision(const BallScene& scene) {
+	float half = scene.cubeSize / 2.0f;
+	int n = size();
+	for (int i = 0; i < n; i++) {
+		float hitPoint = half - radius[i];
+		int8_t w = BALL_NO_WALL;
+		if (nx[i] > hitPoint) w = 0;
+		else if (nx[i] < -hitPoint) w = 1;
+		else if (ny[i] > hitPoint) w = 2;
+		else if (ny[i] < -hitPoint) w = 3;
+		else if (nz[i] > hitPoint) w = 4;
+		else if (nz[i] < -hitPoint) w = 5;
+		wall[i] = resting[i] ? BALL_NO_WALL : w;
+	}
+}
+
+// part of the step taken before the ball touches its wall
+void BallSystem::findFraction(const BallScene& scene) {
+	float half = scene.cubeSize / 2.0f;
+	int n = size();
+	for (int i = 0; i < n; i++) {
+		int w = wall[i];
+		if (w == BALL_NO_WALL)
+			continue;
+		const float* cur = w < 2 ? &px[i] : w < 4 ? &py[i] : &pz[i];
+		const float* next = w < 2 ? &nx[i] : w < 4 ? &ny[i] : &nz[i];
+		// distances measured towards the wall so both sides give a positive fraction
+		float side = (w & 1) ? -1.0f : 1.0f;
+		float toWall = (half - radius[i]) - side * *cur;
+		float travel = side * (*next - *cur);
+		fraction[i] = travel > 0.0f ? glm::clamp(toWall / travel, 0.0f, 1.0f) : 0.0f;
+	}
+}
+
+// velocity leaving wall w, the normal part scaled by the elasticity and the tangential part
+// slowed by friction, a is the acceleration of the ball where it meets the wall
+static glm::vec3 bounce(const BallScene& scene, int w, glm::vec3 v, glm::vec3 a, float h) {
+	glm::vec3 normal(0.0f);
+	normal[w / 2] = (w & 1) ? 1.0f : -1.0f;
+	glm::vec3 VN = normal * glm::dot(v, normal);
+	glm::vec3 VT = v - VN;
+	float vn = glm::length(VN);
+	float an = -glm::dot(a, normal);
+	// a ball lying on the wall meets it with no normal speed, friction also takes what pressing
+	// it into the wall over the step adds
+	float press = vn + std::fmax(an, 0.0f) * h;
+	glm::vec3 nextVT = VT;
+	float vt = glm::length(VT);
+	if (vt > 0.01f)
+		nextVT = VT - (VT / vt) * std::fmin(scene.mu * press, vt);
+	glm::vec3 nextVN = -scene.elas * VN;
+	// explicit euler gains about a * h of speed over a short flight, a small bounce losing
+	// less than that never settles, it ends in contact instead so friction and rest take over
+	if (an > 0.0f && (1.0f - scene.elas) * vn <= an * h && scene.elas * vn <= 4.0f * an * h)
+		nextVN = glm::vec3(0.0f);
+	return nextVT + nextVN;
+}
+
+// the ball is moved to where it touched the wall and its velocity there is reflected
+void BallSystem::collResponse(const BallScene& scene, float h) {
+	int n = size();
+	for (int i = 0; i < n; i++) {
+		int w = wall[i];
+		if (w == BALL_NO_WALL)
+			continue;
+		float dt = fraction[i] * h;
+		nx[i] = px[i] + vx[i] * dt;
+		ny[i] = py[i] + vy[i] * dt;
+		nz[i] = pz[i] + vz[i] * dt;
+		glm::vec3 v(vx[i] + ax[i] * dt, vy[i] + ay[i] * dt, vz[i] + az[i] * dt);
+		glm::vec3 nextV = bounce(scene, w, v, glm::vec3(ax[i], ay[i], az[i]), h);
+		if (nextV[w / 2] != 0.0f)
+			bounces++;
+		nvx[i] = nextV.x;
+		nvy[i] = nextV.y;
+		nvz[i] = nextV.z;
+	}
+}
+
+// pairs from the sweep are tested with their motion over the step, the fraction of the step at
+// which the centers are one radius sum apart is found like findFraction does for walls, both
+// balls are moved there and exchange an impulse along the line between them
+// a resting ball only wakes for a hit faster than the rest velocity, otherwise it is held in place
+void BallSystem::collideBalls(const BallScene& scene, float h) {
+	int n = size();
+	candidates = contacts = 0;
+	if (n < 2)
+		return;
+	const float* start[3] = { px.data(), py.data(), pz.data() };
+	const float* end[3] = { nx.data(), ny.data(), nz.data() };
+	broadPhase.findPairs(start, end, radius.data(), n, pairs);
+	candidates = (int)pairs.size();
+
+	float half = scene.cubeSize / 2.0f;
+	for (const auto& pair : pairs) {
+		int i = pair.first, j = pair.second;
+		glm::vec3 pi(px[i], py[i], pz[i]), pj(px[j], py[j], pz[j]);
+		glm::vec3 d0 = pi - pj;
+		glm::vec3 dd = glm::vec3(nx[i], ny[i], nz[i]) - pi - (glm::vec3(nx[j], ny[j], nz[j]) - pj);
+		float reach = radius[i] + radius[j];
+
+		// |d0 + dd * s| = reach, the earlier root is where they first touch
+		float a = glm::dot(dd, dd);
+		float b = 2.0f * glm::dot(d0, dd);
+		float c = glm::dot(d0, d0) - reach * reach;
+		if (b >= 0.0f)
+			continue; // not closing in over the step, even when they touch at its start
+		float s = 0.0f; // already touching at the start of the step
+		if (c > 0.0f) {
+			float disc = b * b - 4.0f * a * c;
+			if (disc < 0.0f)
+				continue;
+			s = (-b - std::sqrt(disc)) / (2.0f * a);
+			if (s > 1.0f)
+				continue;
+		}
+		contacts++;
+
+		glm::vec3 ci = pi + (glm::vec3(nx[i], ny[i], nz[i]) - pi) * s;
+		glm::vec3 cj = pj + (glm::vec3(nx[j], ny[j], nz[j]) - pj) * s;
+		glm::vec3 delta = ci - cj;
+		float dist = glm::length(delta);
+		glm::vec3 normal = dist > 1e-6f ? delta / dist : glm::vec3(0.0f, 0.0f, 1.0f);
+
+		glm::vec3 vi(nvx[i], nvy[i], nvz[i]), vj(nvx[j], nvy[j], nvz[j]);
+		// a ball held at its wall keeps its velocity but does not move, the approach is taken from
+		// whichever of the velocities and the motion over the step closes in faster
+		float vn = std::fmin(glm::dot(vi - vj, normal), glm::dot(dd, normal) / h);
+		for (int k : { i, j }) {
+			if (resting[k] && -vn > scene.restVelocity) {
+				resting[k] = 0;
+				restSteps[k] = 0;
+			}
+		}
+		float wi = resting[i] ? 0.0f : invMass[i];
+		float wj = resting[j] ? 0.0f : invMass[j];
+		if (wi + wj <= 0.0f)
+			continue;
+
+		// overlap left from the spawn or an earlier pair is pushed apart by inverse mass
+		float overlap = reach - dist;
+		if (overlap > 0.0f) {
+			ci += normal * (overlap * wi / (wi + wj));
+			cj -= normal * (overlap * wj / (wi + wj));
+		}
+
+		if (vn < 0.0f) {
+			// slow contacts are inelastic so balls lying against each other do not keep bouncing
+			float elas = -vn > scene.restVelocity ? scene.elas : 0.0f;
+			float impulse = -(1.0f + elas) * vn / (wi + wj);
+			glm::vec3 VT = vi - vj - normal * glm::dot(vi - vj, normal);
+			float vt = glm::length(VT);
+			glm::vec3 J = normal * impulse;
+			if (vt > 0.01f)
+				J -= (VT / vt) * std::fmin(scene.mu * impulse, vt / (wi + wj));
+			vi += J * wi;
+			vj -= J * wj;
+		}
+		nvx[i] = vi.x; nvy[i] = vi.y; nvz[i] = vi.z;
+		nvx[j] = vj.x; nvy[j] = vj.y; nvz[j] = vj.z;
+
+		// unlike at a wall the rest of the step is taken with the new velocities, dropping it would
+		// hold balls sliding along each other in place while gravity keeps adding up
+		float remain = (1.0f - s) * h;
+		glm::vec3 lo(-half), hi(half);
+		ci = glm::clamp(ci + vi * remain, lo + radius[i], hi - radius[i]);
+		cj = glm::clamp(cj + vj * remain, lo + radius[j], hi - radius[j]);
+		nx[i] = ci.x; ny[i] = ci.y; nz[i] = ci.z;
+		nx[j] = cj.x; ny[j] = cj.y; nz[j] = cj.z;
+	}
+}
+
+// slow steps touching a wall count towards rest, slow steps in the air keep the count
+void BallSystem::settle(const BallScene& scene) {
+	float rest2 = scene.restVelocity * scene.restVelocity;
+	int n = size();
+	int moving = 0;
+	for (int i = 0; i < n; i++) {
+		if (!resting[i]) {
+			float speed2 = nvx[i] * nvx[i] + nvy[i] * nvy[i] + nvz[i] * nvz[i];
+			bool contact = wall[i] != BALL_NO_WALL;
+			if (contact)
+				restWall[i] = wall[i];
+			if (speed2 > rest2)
+				restSteps[i] = 0;
+			else if (contact)
+				restSteps[i]++;
+			if (restSteps[i] >= scene.restSteps) {
+				resting[i] = 1;
+				nvx[i] = nvy[i] = nvz[i] = 0.0f;
+			}
+			else {
+				moving++;
+			}
+		}
+		px[i] = nx[i];
+		py[i] = ny[i];
+		pz[i] = nz[i];
+		vx[i] = nvx[i];
+		vy[i] = nvy[i];
+		vz[i] = nvz[i];
+	}
+	awake = moving;
+}
+
+// motion along one axis under dv/dt = c - k v, exact for any time
+struct Flight {
+	double x0 = 0.0, v0 = 0.0, c = 0.0, k = 0.0;
+
+	double position(double t) const {
+		if (k < 1e-9)
+			return x0 + v0 * t + 0.5 * c * t * t;
+		double terminal = c / k;
+		return x0 + terminal * t + (v0 - terminal) * (1.0 - std::exp(-k * t)) / k;
+	}
+	double velocity(double t) const {
+		if (k < 1e-9)
+			return v0 + c * t;
+		double terminal = c / k;
+		return terminal + (v0 - terminal) * std::exp(-k * t);
+	}
+	// when the velocity passes zero, negative if it never does
+	double turn() const {
+		if (k < 1e-9)
+			return v0 * c < 0.0 ? -v0 / c : -1.0;
+		double terminal = c / k;
+		if (v0 == terminal)
+			return -1.0;
+		double ratio = -terminal / (v0 - terminal);
+		return ratio > 0.0 && ratio < 1.0 ? -std::log(ratio) / k : -1.0;
+	}
+};
+
+// first time in [0, horizon] the position reaches side * x = limit while moving that way, or -1
+// the velocity changes sign at most once so the motion splits in two monotonic pieces, the
+// crossing in a piece is found by bisection
+static double firstCrossing(const Flight& f, double side, double limit, double horizon) {
+	double pieces[3] = { 0.0, horizon, horizon };
+	double turn = f.turn();
+	if (turn > 0.0 && turn < horizon)
+		pieces[1] = turn;
+	for (int p = 0; p < 2; p++) {
+		double a = pieces[p], b = pieces[p + 1];
+		if (b <= a || side * f.velocity(0.5 * (a + b)) <= 0.0)
+			continue;
+		if (side * f.position(a) - limit >= 0.0)
+			return a;
+		if (side * f.position(b) - limit < 0.0)
+			continue;
+		for (int it = 0; it < 64 && b - a > 1e-12 * (1.0 + b); it++) {
+			double m = 0.5 * (a + b);
+			if (side * f.position(m) - limit < 0.0)
+				a = m;
+			else
+				b = m;
+		}
+		return b;
+	}
+	return -1.0;
+}
+
+static bool later(const BallEvent& a, const BallEvent& b) {
+	return a.time > b.time;
+}
+
+// the motion of one ball until its next event, free axes fly, the axes of pinned walls stay on
+// the wall, and the walls pressed against slow the free motion down by friction
+struct BallSystem::Segment {
+	Flight axis[3];
+	uint8_t pinned = 0;
+	double press = 0.0; // acceleration into the pinned walls
+	double pull = 0.0; // free acceleration without friction, static friction holds against up to mu * press
+	Flight speed; // along the sliding direction, zero at the stop
+	bool turns = false; // free acceleration is not along the sliding direction
+	int restWall = BALL_NO_WALL; // pinned wall pressed against the hardest
+};
+
+BallSystem::Segment BallSystem::segment(const BallScene& scene, int i) const {
+	Segment seg;
+	glm::vec3 constant;
+	float drag;
+	forces.linear(position(i), invMass[i], constant, drag);
+	double k = drag;
+	double c[3] = { constant.x, constant.y, constant.z };
+	double x[3] = { px[i], py[i], pz[i] };
+	double v[3] = { vx[i], vy[i], vz[i] };
+	seg.pinned = pinned[i];
+
+	bool free[3];
+	double hardest = 0.0;
+	for (int a = 0; a < 3; a++) {
+		free[a] = (seg.pinned & (3 << (2 * a))) == 0;
+		for (int w = 2 * a; w < 2 * a + 2; w++) {
+			if (!(seg.pinned & (1 << w)))
+				continue;
+			double an = (w & 1) ? -c[a] : c[a];
+			seg.press += an;
+			if (an > hardest) {
+				hardest = an;
+				seg.restWall = w;
+			}
+		}
+	}
+
+	if (seg.press > 0.0) {
+		double u = 0.0, pull2 = 0.0;
+		for (int a = 0; a < 3; a++) {
+			if (free[a]) {
+				u += v[a] * v[a];
+				pull2 += c[a] * c[a];
+			}
+		}
+		u = std::sqrt(u);
+		seg.pull = std::sqrt(pull2);
+		// friction acts against the velocity, a ball starting from rest slides along the pull
+		double dir[3] = { 0.0, 0.0, 0.0 };
+		double norm = u > 1e-9 ? u : seg.pull;
+		for (int a = 0; a < 3; a++)
+			if (free[a] && norm > 0.0)
+				dir[a] = (u > 1e-9 ? v[a] : c[a]) / norm;
+		double along = 0.0;
+		for (int a = 0; a < 3; a++)
+			along += c[a] * dir[a];
+		seg.turns = pull2 - along * along > 1e-12 * (1.0 + pull2);
+		double friction = scene.mu * seg.press;
+		for (int a = 0; a < 3; a++)
+			c[a] -= friction * dir[a];
+		seg.speed = { 0.0, u, along - friction, k };
+	}
+
+	for (int a = 0; a < 3; a++) {
+		if (free[a])
+			seg.axis[a] = { x[a], v[a], c[a], k };
+		else
+			seg.axis[a] = { x[a], 0.0, 0.0, 0.0 };
+	}
+	return seg;
+}
+
+void BallSystem::moveTo(const Segment& seg, int i, double time) {
+	double dt = time - since[i];
+	float* p[3] = { &px[i], &py[i], &pz[i] };
+	float* v[3] = { &vx[i], &vy[i], &vz[i] };
+	for (int a = 0; a < 3; a++) {
+		*p[a] = (float)seg.axis[a].position(dt);
+		*v[a] = (float)seg.axis[a].velocity(dt);
+	}
+	since[i] = time;
+}
+
+// lets go of walls the forces no longer press into, then finds the earliest wall, stop or turn
+// before the horizon
+void BallSystem::schedule(const BallScene& scene, int i, double horizon) {
+	glm::vec3 c;
+	float k;
+	forces.linear(position(i), invMass[i], c, k);
+	for (int w = 0; w < 6; w++) {
+		if ((pinned[i] & (1 << w)) && ((w & 1) ? -c[w / 2] : c[w / 2]) <= 0.0f)
+			pinned[i] &= ~(1 << w);
+	}
+	Segment seg = segment(scene, i);
+	if (seg.press > 0.0 && seg.speed.v0 <= 1e-9 && seg.pull <= scene.mu * seg.press) {
+		resting[i] = 1;
+		restWall[i] = seg.restWall;
+		vx[i] = vy[i] = vz[i] = 0.0f;
+		return;
+	}
+
+	double limit = scene.cubeSize / 2.0f - radius[i];
+	double left = horizon - since[i];
+	BallEvent next = { horizon + 1.0, i, BALL_EVENT_WALL, BALL_NO_WALL };
+	for (int a = 0; a < 3; a++) {
+		if (seg.pinned & (3 << (2 * a)))
+			continue;
+		for (int side = 0; side < 2; side++) {
+			double t = firstCrossing(seg.axis[a], side ? -1.0 : 1.0, limit, left);
+			if (t >= 0.0 && since[i] + t < next.time)
+				next = { since[i] + t, i, BALL_EVENT_WALL, (int8_t)(2 * a + side) };
+		}
+	}
+	if (seg.press > 0.0) {
+		double stop = seg.speed.turn();
+		if (stop >= 0.0 && since[i] + stop < next.time)
+			next = { since[i] + stop, i, BALL_EVENT_STOP, BALL_NO_WALL };
+		if (seg.turns && since[i] + scene.timestep < next.time)
+			next = { since[i] + scene.timestep, i, BALL_EVENT_TURN, BALL_NO_WALL };
+	}
+	if (next.time <= horizon) {
+		queue.push_back(next);
+		std::push_heap(queue.begin(), queue.end(), later);
+	}
+}
+
+// the same response as the stepped mode at a wall, a bounce too small to keep the ball in the air
+// pins it to the wall, that also ends the endless series of ever smaller bounces
+void BallSystem::handle(const BallScene& scene, const BallEvent& event, double horizon) {
+	int i = event.ball;
+	moveTo(segment(scene, i), i, event.time);
+	events++;
+	if (event.kind == BALL_EVENT_WALL) {
+		int w = event.wall;
+		int a = w / 2;
+		float limit = scene.cubeSize / 2.0f - radius[i];
+		float* p[3] = { &px[i], &py[i], &pz[i] };
+		*p[a] = (w & 1) ? -limit : limit;
+		glm::vec3 v(vx[i], vy[i], vz[i]);
+		glm::vec3 c;
+		float k;
+		forces.linear(position(i), invMass[i], c, k);
+		glm::vec3 acc = c - k * v;
+		v = bounce(scene, w, v, acc, scene.timestep);
+		if (v[a] == 0.0f)
+			pinned[i] |= 1 << w;
+		else
+			bounces++;
+		vx[i] = v.x;
+		vy[i] = v.y;
+		vz[i] = v.z;
+	}
+	else if (event.kind == BALL_EVENT_STOP) {
+		vx[i] = vy[i] = vz[i] = 0.0f;
+	}
+	schedule(scene, i, horizon);
+}
+
+void BallSystem::advance(const BallScene& scene, double duration) {
+	setAcceleration();
+	wake(scene);
+	int n = size();
+	events = 0;
+	queue.clear();
+	float half = scene.cubeSize / 2.0f;
+	for (int i = 0; i < n; i++) {
+		since[i] = 0.0;
+		// the stepped mode or a changed cube may have moved the ball off a wall it was sliding on
+		float p[3] = { px[i], py[i], pz[i] };
+		float v[3] = { vx[i], vy[i], vz[i] };
+		for (int w = 0; w < 6; w++) {
+			float side = (w & 1) ? -1.0f : 1.0f;
+			if ((pinned[i] & (1 << w)) && (side * p[w / 2] != half - radius[i] || v[w / 2] != 0.0f))
+				pinned[i] &= ~(1 << w);
+		}
+		if (!resting[i])
+			schedule(scene, i, duration);
+	}
+	while (!queue.empty()) {
+		std::pop_heap(queue.begin(), queue.end(), later);
+		BallEvent event = queue.back();
+		queue.pop_back();
+		handle(scene, event, duration);
+	}
+	int moving = 0;
+	for (int i = 0; i < n; i++) {
+		if (resting[i])
+			continue;
+		moveTo(segment(scene, i), i, duration);
+		moving++;
+	}
+	awake = moving;
+	t += (float)duration;
+}
@@ -0,0 +1,99 @@
+#ifndef BALLSYSTEM_H
+#define BALLSYSTEM_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+#include "ForceField.h"
+#include "SweepAndPrune.h"
+
+#define BALL_NO_WALL -1 // wall index when a ball touches none, walls are 2 * axis + (1 on the negative side)
+
+// next thing that changes the motion of one ball in the event driven mode
+struct BallEvent {
+	double time;
+	int ball;
+	int8_t kind; // BALL_EVENT_*
+	int8_t wall;
+};
+
+// all balls of the cube as structure of arrays, every kernel runs over the whole set once per step
+// the dynamic state is kept apart from the per ball constants and the step scratch, the forces
+// come from a registry of fields built from the scene
+class BallSystem {
+
+public:
+	// ball 0 starts where the scene says, the others at seeded random spots inside the cube
+	void reset(const BallScene& scene, int count);
+	void setRadius(float radius);
+	// rebuilds the force fields after the forces of the scene were edited, reset does it too
+	void setForces(const BallScene& scene);
+	void step(const BallScene& scene);
+	// event driven, between wall impacts the motion under constant force and linear drag has a
+	// closed form, so each ball jumps from one impact to the next and the balls do not see each other
+	// the fields are those at the start of each flight, a ball flying into a localized field
+	// only feels it from its next event on
+	void advance(const BallScene& scene, double duration);
+
+	int size() const { return (int)px.size(); }
+	glm::vec3 position(int i) const { return glm::vec3(px[i], py[i], pz[i]); }
+	glm::vec3 velocity(int i) const { return glm::vec3(vx[i], vy[i], vz[i]); }
+	int sortMoves() const { return broadPhase.lastSwaps(); }
+	// kinetic plus potential energy of all balls, the potential is zero at the center of the cube
+	// and only comes from the scene wide gravity
+	double energy(const BallScene& scene) const;
+
+	// dynamic state
+	std::vector<float> px, py, pz;
+	std::vector<float> vx, vy, vz;
+	std::vector<int> restSteps;
+	std::vector<uint8_t> resting; // integration and collision are skipped until it is disturbed
+	std::vector<int8_t> restWall;
+
+	// per ball constants
+	std::vector<float> invMass;
+	std::vector<float> radius;
+
+	int awake = 0; // balls that moved in the last step
+	int candidates = 0; // pairs the broad phase reported in the last step
+	int contacts = 0; // of those, pairs that touched
+	int events = 0; // impacts and contact changes handled in the last advance
+	int bounces = 0; // wall impacts a ball came back off since the reset, landing to slide does not count
+	float t = 0.0f;
+
+private:
+	void setAcceleration();
+	void wake(const BallScene& scene);
+	void integrate(float h);
+	void checkCollision(const BallScene& scene);
+	void findFraction(const BallScene& scene);
+	void collResponse(const BallScene& scene, float h);
+	void collideBalls(const BallScene& scene, float h);
+	void settle(const BallScene& scene);
+
+	struct Segment;
+	Segment segment(const BallScene& scene, int i) const;
+	void schedule(const BallScene& scene, int i, double horizon);
+	void handle(const BallScene& scene, const BallEvent& event, double horizon);
+	void moveTo(const Segment& segment, int i, double time);
+
+	// step scratch
+	std::vector<float> ax, ay, az;
+	std::vector<float> nx, ny, nz; // position at the end of the step
+	std::vector<float> nvx, nvy, nvz;
+	std::vector<int8_t> wall; // wall crossed in this step
+	std::vector<float> fraction; // of the step before the wall was reached
+
+	ForceFieldRegistry forces;
+	SweepAndPrune broadPhase;
+	std::vector<std::pair<int, int>> pairs;
+
+	// event driven state
+	std::vector<uint8_t> pinned; // walls a ball lies against and slides along, bit w for wall w
+	std::vector<double> since; // time in the current advance the state of each ball is from
+	std::vector<BallEvent> queue; // heap with the earliest event on top
+};
+
+#endif
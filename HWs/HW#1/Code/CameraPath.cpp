@@ -0,0 +1,30 @@
+#include "CameraPath.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// at 2.5 times the half diagonal the enclosing sphere fills a little less than the view
+void CameraPath::fit(const glm::vec3& lo, const glm::vec3& hi) {
+	center = 0.5f * (lo + hi);
+	radius = std::max(2.5f * 0.5f * glm::length(hi - lo), 1.0f);
+}
+
+void CameraPath::frame(int f, glm::vec3& pos, glm::vec3& front) const {
+	float phase = 6.28318531f * (float)(f % period) / (float)period;
+	if (type == CAMERA_ORBIT)
+		pos = center + radius * glm::vec3(std::cos(phase), std::sin(phase), 0.5f);
+	else if (type == CAMERA_DOLLY)
+		pos = center + radius * (1.0f + 0.6f * std::cos(phase)) * glm::normalize(glm::vec3(1.0f, 1.0f, 0.6f));
+	else
+		return;
+	front = glm::normalize(center - pos);
+}
+
+int CameraPath::parse(const char* name) {
+	static const char* names[] = { "fixed", "orbit", "dolly" };
+	for (int t = CAMERA_FIXED; t <= CAMERA_DOLLY; t++)
+		if (strcmp(name, names[t]) == 0)
+			return t;
+	return -1;
+}
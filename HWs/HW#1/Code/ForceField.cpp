@@ -0,0 +1,127 @@
+#include "ForceField.h"
+
+#include <algorithm>
+
+void ForceField::setRegion(glm::vec3 lo, glm::vec3 hi) {
+	bmin = lo;
+	bmax = hi;
+}
+
+bool ForceField::overlaps(const BallBatch& b) const {
+	return b.bmin.x <= bmax.x && b.bmax.x >= bmin.x &&
+		b.bmin.y <= bmax.y && b.bmax.y >= bmin.y &&
+		b.bmin.z <= bmax.z && b.bmax.z >= bmin.z;
+}
+
+bool ForceField::contains(const BallBatch& b) const {
+	return inside(b.bmin.x, b.bmin.y, b.bmin.z) && inside(b.bmax.x, b.bmax.y, b.bmax.z);
+}
+
+void UniformField::apply(const BallBatch& b) const {
+	forEach(b, [&](int i) {
+		b.ax[i] += g.x;
+		b.ay[i] += g.y;
+		b.az[i] += g.z;
+	});
+}
+
+void UniformField::linear(float, glm::vec3& c, float&) const {
+	c += g;
+}
+
+void WindField::apply(const BallBatch& b) const {
+	glm::vec3 f = windFactor * wind;
+	forEach(b, [&](int i) {
+		b.ax[i] += f.x * b.invMass[i];
+		b.ay[i] += f.y * b.invMass[i];
+		b.az[i] += f.z * b.invMass[i];
+	});
+}
+
+void WindField::linear(float invMass, glm::vec3& c, float&) const {
+	c += windFactor * wind * invMass;
+}
+
+void DragField::apply(const BallBatch& b) const {
+	forEach(b, [&](int i) {
+		float k = airResistanceFactor * b.invMass[i];
+		b.ax[i] -= k * b.vx[i];
+		b.ay[i] -= k * b.vy[i];
+		b.az[i] -= k * b.vz[i];
+	});
+}
+
+void DragField::linear(float invMass, glm::vec3&, float& k) const {
+	k += airResistanceFactor * invMass;
+}
+
+void ForceFieldRegistry::build(const BallScene& scene) {
+	fields.clear();
+	localized = false;
+	// scene wide forces that are zero are left out, most scenes only have gravity
+	if (scene.gravity != glm::vec3(0.0f))
+		add<UniformField>(scene.gravity);
+	if (scene.windFactor * scene.wind != glm::vec3(0.0f))
+		add<WindField>(scene.wind, scene.windFactor);
+	if (scene.airResistanceFactor != 0.0f)
+		add<DragField>(scene.airResistanceFactor);
+	for (int f = 0; f < scene.fieldCount; f++) {
+		const SceneField& sf = scene.fields[f];
+		ForceField* field;
+		if (sf.type == FIELD_GRAVITY)
+			field = add<UniformField>(sf.v);
+		else if (sf.type == FIELD_WIND)
+			field = add<WindField>(sf.v, sf.f);
+		else if (sf.type == FIELD_DRAG)
+			field = add<DragField>(sf.f);
+		else
+			continue;
+		field->enabled = sf.enabled != 0;
+		field->setRegion(sf.bmin, sf.bmax);
+		localized = true;
+	}
+}
+
+void ForceFieldRegistry::apply(const BallBatch& b) const {
+	for (int start = 0; start < b.n; start += FORCE_BATCH_SIZE) {
+		BallBatch chunk = b;
+		chunk.px += start;
+		chunk.py += start;
+		chunk.pz += start;
+		chunk.vx += start;
+		chunk.vy += start;
+		chunk.vz += start;
+		chunk.invMass += start;
+		chunk.ax += start;
+		chunk.ay += start;
+		chunk.az += start;
+		chunk.n = std::min(FORCE_BATCH_SIZE, b.n - start);
+		for (int i = 0; i < chunk.n; i++) {
+			chunk.ax[i] = 0.0f;
+			chunk.ay[i] = 0.0f;
+			chunk.az[i] = 0.0f;
+		}
+		// without a localized field any point passes for the bounds, every field holds it
+		chunk.bmin = glm::vec3(chunk.px[0], chunk.py[0], chunk.pz[0]);
+		chunk.bmax = chunk.bmin;
+		for (int i = 1; i < chunk.n && localized; i++) {
+			glm::vec3 p(chunk.px[i], chunk.py[i], chunk.pz[i]);
+			chunk.bmin = glm::min(chunk.bmin, p);
+			chunk.bmax = glm::max(chunk.bmax, p);
+		}
+
+		for (const auto& field : fields) {
+			if (field->enabled && field->overlaps(chunk))
+				field->apply(chunk);
+		}
+	}
+}
+
+void ForceFieldRegistry::linear(const glm::vec3& p, float invMass, glm::vec3& c, float& k) const {
+	c = glm::vec3(0.0f);
+	k = 0.0f;
+	for (const auto& field : fields) {
+		if (field->enabled && field->inside(p.x, p.y, p.z))
+			field->linear(invMass, c, k);
+	}
+}
@@ -0,0 +1,126 @@
+#ifndef FORCEFIELD_H
+#define FORCEFIELD_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+
+#define FORCE_BATCH_SIZE 1024
+
+// view over a contiguous range of ball columns, fields read position, velocity and inverse mass
+// and accumulate into the acceleration
+struct BallBatch {
+	const float* px;
+	const float* py;
+	const float* pz;
+	const float* vx;
+	const float* vy;
+	const float* vz;
+	const float* invMass;
+	float* ax;
+	float* ay;
+	float* az;
+	int n;
+	glm::vec3 bmin; // bounds of the positions in the batch
+	glm::vec3 bmax;
+};
+
+// a field is evaluated once per batch, the per ball loop lives inside apply so stacking fields
+// costs one virtual call per field per batch instead of one per ball
+// every field is a constant force plus linear drag inside its region, so the event driven mode
+// keeps its closed form flights
+class ForceField {
+
+public:
+	ForceField(const char* name) : name(name) {};
+	virtual ~ForceField() {};
+
+	virtual void apply(const BallBatch& b) const = 0;
+	// adds the field as a = c - k * v for a ball with the given inverse mass
+	virtual void linear(float invMass, glm::vec3& c, float& k) const = 0;
+
+	std::string name;
+	bool enabled = true;
+	// region of influence, unbounded by default
+	glm::vec3 bmin = glm::vec3(-FLT_MAX);
+	glm::vec3 bmax = glm::vec3(FLT_MAX);
+
+	void setRegion(glm::vec3 lo, glm::vec3 hi);
+	bool overlaps(const BallBatch& b) const;
+	bool contains(const BallBatch& b) const;
+	bool inside(float x, float y, float z) const {
+		return x >= bmin.x && y >= bmin.y && z >= bmin.z &&
+			x <= bmax.x && y <= bmax.y && z <= bmax.z;
+	}
+
+protected:
+	// runs f on every ball of the batch that is inside the region, the region test is dropped
+	// when the whole batch is inside it
+	template <class F>
+	void forEach(const BallBatch& b, F f) const {
+		if (contains(b)) {
+			for (int i = 0; i < b.n; i++)
+				f(i);
+		}
+		else {
+			for (int i = 0; i < b.n; i++)
+				if (inside(b.px[i], b.py[i], b.pz[i]))
+					f(i);
+		}
+	}
+};
+
+// constant acceleration, gravity
+class UniformField : public ForceField {
+public:
+	UniformField(glm::vec3 g) : ForceField("Gravity"), g(g) {};
+	void apply(const BallBatch& b) const override;
+	void linear(float invMass, glm::vec3& c, float& k) const override;
+	glm::vec3 g;
+};
+
+// constant force scaled by the wind factor, heavier balls are pushed less
+class WindField : public ForceField {
+public:
+	WindField(glm::vec3 wind, float windFactor) : ForceField("Wind"), wind(wind), windFactor(windFactor) {};
+	void apply(const BallBatch& b) const override;
+	void linear(float invMass, glm::vec3& c, float& k) const override;
+	glm::vec3 wind;
+	float windFactor;
+};
+
+// linear air resistance, -k * v
+class DragField : public ForceField {
+public:
+	DragField(float airResistanceFactor) : ForceField("Drag"), airResistanceFactor(airResistanceFactor) {};
+	void apply(const BallBatch& b) const override;
+	void linear(float invMass, glm::vec3& c, float& k) const override;
+	float airResistanceFactor;
+};
+
+class ForceFieldRegistry {
+
+public:
+	template <class T, class... Args>
+	T* add(Args&&... args) {
+		T* field = new T(std::forward<Args>(args)...);
+		fields.emplace_back(field);
+		return field;
+	}
+	// the scene wide gravity, wind and air resistance, then the localized fields of the scene
+	void build(const BallScene& scene);
+
+	// clears a and accumulates every enabled field in batches of FORCE_BATCH_SIZE
+	void apply(const BallBatch& b) const;
+	// sum of the enabled fields whose region holds p, as a = c - k * v
+	void linear(const glm::vec3& p, float invMass, glm::vec3& c, float& k) const;
+
+	std::vector<std::unique_ptr<ForceField>> fields;
+	bool localized = false; // some field has a region, batches need their bounds
+};
+
+#endif
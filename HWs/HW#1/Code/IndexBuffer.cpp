@@ -0,0 +1,38 @@
+#include "IndexBuffer.h"
+#include <glad/glad.h>
+
+
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : count(count), capacity(count)
+{
+	glGenBuffers(1, &rendererID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_DYNAMIC_DRAW);
+}
+
+IndexBuffer::~IndexBuffer()
+{
+	glDeleteBuffers(1, &rendererID);
+}
+
+void IndexBuffer::Bind() const
+{
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID);
+}
+
+void IndexBuffer::Unbind() const
+{
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// binds the buffer to the element target, a vertex array bound at the time records it
+void IndexBuffer::UpdateData(const unsigned int* data, unsigned int count)
+{
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID);
+	if (count > capacity) {
+		capacity = count > 2 * capacity ? count : 2 * capacity;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, capacity * sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+	}
+	if (count > 0)
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, count * sizeof(unsigned int), data);
+	this->count = count;
+}
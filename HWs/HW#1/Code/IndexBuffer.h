@@ -0,0 +1,20 @@
+#pragma once
+
+// element buffer of unsigned int indices, grows like VertexBuffer
+class IndexBuffer {
+
+private: 
+	unsigned int rendererID;
+	unsigned int count;
+	unsigned int capacity; // indices
+public:
+	IndexBuffer(const unsigned int* data, unsigned int count );
+	~IndexBuffer();
+
+	void Bind() const;
+	void Unbind() const;
+	void UpdateData(const unsigned int* data, unsigned int count);
+
+	inline unsigned int getCount() const { return count; }
+	inline unsigned int getCapacity() const { return capacity; }
+};
@@ -0,0 +1,265 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#define JSON_MAX_DEPTH 64
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+	if (type != Object)
+		return nullptr;
+	for (const auto& m : members)
+		if (m.first == key)
+			return &m.second;
+	return nullptr;
+}
+
+// recursive descent over the whole buffer, stops at the first error
+struct JsonParser {
+	const char* s;
+	const char* end;
+	int line = 1;
+	std::string error;
+
+	bool fail(const char* what) {
+		if (error.empty())
+			error = "line " + std::to_string(line) + ": " + what;
+		return false;
+	}
+
+	void skipSpace() {
+		while (s < end && (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n')) {
+			if (*s == '\n')
+				line++;
+			s++;
+		}
+	}
+
+	bool literal(const char* word) {
+		size_t len = strlen(word);
+		if ((size_t)(end - s) < len || memcmp(s, word, len) != 0)
+			return fail("unexpected token");
+		s += len;
+		return true;
+	}
+
+	static void appendUtf8(std::string& out, unsigned int cp) {
+		if (cp < 0x80) {
+			out += (char)cp;
+		}
+		else if (cp < 0x800) {
+			out += (char)(0xC0 | (cp >> 6));
+			out += (char)(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000) {
+			out += (char)(0xE0 | (cp >> 12));
+			out += (char)(0x80 | ((cp >> 6) & 0x3F));
+			out += (char)(0x80 | (cp & 0x3F));
+		}
+		else {
+			out += (char)(0xF0 | (cp >> 18));
+			out += (char)(0x80 | ((cp >> 12) & 0x3F));
+			out += (char)(0x80 | ((cp >> 6) & 0x3F));
+			out += (char)(0x80 | (cp & 0x3F));
+		}
+	}
+
+	bool hex4(unsigned int& cp) {
+		if (end - s < 4)
+			return fail("truncated \\u escape");
+		cp = 0;
+		for (int i = 0; i < 4; i++) {
+			char c = *s++;
+			cp <<= 4;
+			if (c >= '0' && c <= '9') cp |= c - '0';
+			else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+			else return fail("bad \\u escape");
+		}
+		return true;
+	}
+
+	bool parseString(std::string& out) {
+		s++; // opening quote
+		while (s < end && *s != '"') {
+			char c = *s++;
+			if (c == '\n')
+				return fail("newline in string");
+			if (c != '\\') {
+				out += c;
+				continue;
+			}
+			if (s >= end)
+				break;
+			c = *s++;
+			switch (c) {
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				unsigned int cp = 0;
+				if (!hex4(cp))
+					return false;
+				// surrogate pair
+				if (cp >= 0xD800 && cp < 0xDC00 && end - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+					s += 2;
+					unsigned int lo = 0;
+					if (!hex4(lo))
+						return false;
+					cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+				}
+				appendUtf8(out, cp);
+				break;
+			}
+			default:
+				return fail("bad escape in string");
+			}
+		}
+		if (s >= end)
+			return fail("unterminated string");
+		s++; // closing quote
+		return true;
+	}
+
+	bool parseNumber(double& out) {
+		// validate the json grammar first, strtod accepts more than json does
+		const char* p = s;
+		if (p < end && *p == '-')
+			p++;
+		if (p >= end || *p < '0' || *p > '9')
+			return fail("bad number");
+		while (p < end && *p >= '0' && *p <= '9')
+			p++;
+		if (p < end && *p == '.') {
+			p++;
+			if (p >= end || *p < '0' || *p > '9')
+				return fail("bad number");
+			while (p < end && *p >= '0' && *p <= '9')
+				p++;
+		}
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			p++;
+			if (p < end && (*p == '+' || *p == '-'))
+				p++;
+			if (p >= end || *p < '0' || *p > '9')
+				return fail("bad number");
+			while (p < end && *p >= '0' && *p <= '9')
+				p++;
+		}
+		std::string text(s, p);
+		out = strtod(text.c_str(), nullptr);
+		s = p;
+		return true;
+	}
+
+	bool parseValue(JsonValue& v, int depth) {
+		if (depth > JSON_MAX_DEPTH)
+			return fail("nesting too deep");
+		skipSpace();
+		if (s >= end)
+			return fail("unexpected end of file");
+		v.line = line;
+		switch (*s) {
+		case '{': {
+			v.type = JsonValue::Object;
+			s++;
+			skipSpace();
+			if (s < end && *s == '}') {
+				s++;
+				return true;
+			}
+			while (true) {
+				skipSpace();
+				if (s >= end || *s != '"')
+					return fail("expected a member name");
+				std::string key;
+				if (!parseString(key))
+					return false;
+				if (v.find(key))
+					return fail(("duplicate member \"" + key + "\"").c_str());
+				skipSpace();
+				if (s >= end || *s != ':')
+					return fail("expected ':'");
+				s++;
+				v.members.emplace_back(key, JsonValue());
+				if (!parseValue(v.members.back().second, depth + 1))
+					return false;
+				skipSpace();
+				if (s < end && *s == ',') {
+					s++;
+					continue;
+				}
+				if (s < end && *s == '}') {
+					s++;
+					return true;
+				}
+				return fail("expected ',' or '}'");
+			}
+		}
+		case '[': {
+			v.type = JsonValue::Array;
+			s++;
+			skipSpace();
+			if (s < end && *s == ']') {
+				s++;
+				return true;
+			}
+			while (true) {
+				v.array.emplace_back();
+				if (!parseValue(v.array.back(), depth + 1))
+					return false;
+				skipSpace();
+				if (s < end && *s == ',') {
+					s++;
+					continue;
+				}
+				if (s < end && *s == ']') {
+					s++;
+					return true;
+				}
+				return fail("expected ',' or ']'");
+			}
+		}
+		case '"':
+			v.type = JsonValue::String;
+			return parseString(v.string);
+		case 't':
+			v.type = JsonValue::Bool;
+			v.boolean = true;
+			return literal("true");
+		case 'f':
+			v.type = JsonValue::Bool;
+			v.boolean = false;
+			return literal("false");
+		case 'n':
+			v.type = JsonValue::Null;
+			return literal("null");
+		default:
+			v.type = JsonValue::Number;
+			return parseNumber(v.number);
+		}
+	}
+};
+
+bool parseJson(const char* data, size_t size, JsonValue& out, std::string& error) {
+	JsonParser parser;
+	parser.s = data;
+	parser.end = data + size;
+	// utf-8 byte order mark
+	if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+		parser.s += 3;
+	out = JsonValue();
+	bool ok = parser.parseValue(out, 0);
+	if (ok) {
+		parser.skipSpace();
+		if (parser.s != parser.end)
+			ok = parser.fail("trailing characters after the document");
+	}
+	error = parser.error;
+	return ok;
+}
@@ -0,0 +1,34 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <vector>
+#include <string>
+#include <utility>
+
+// parsed json document, only as much as the scene files need
+class JsonValue {
+
+public:
+	enum Type { Null, Bool, Number, String, Array, Object };
+
+	Type type = Null;
+	bool boolean = false;
+	double number = 0.0;
+	std::string string;
+	std::vector<JsonValue> array;
+	std::vector<std::pair<std::string, JsonValue>> members; // object members in file order
+	int line = 0; // where the value starts, for error messages
+
+	bool isNumber() const { return type == Number; }
+	bool isString() const { return type == String; }
+	bool isArray() const { return type == Array; }
+	bool isObject() const { return type == Object; }
+
+	// member lookup, nullptr when missing or when this is not an object
+	const JsonValue* find(const std::string& key) const;
+};
+
+// on failure error is "line N: what went wrong"
+bool parseJson(const char* data, size_t size, JsonValue& out, std::string& error);
+
+#endif
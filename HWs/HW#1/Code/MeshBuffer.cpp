@@ -0,0 +1,69 @@
+#include "MeshBuffer.h"
+#include <glad/glad.h>
+
+MeshBuffer::MeshBuffer()
+{
+	glGenVertexArrays(1, &vao);
+}
+
+MeshBuffer::~MeshBuffer()
+{
+	glDeleteVertexArrays(1, &vao);
+}
+
+int MeshBuffer::AddAttribute(unsigned int location, int components, const void* data, unsigned int size)
+{
+	glBindVertexArray(vao);
+	buffers.emplace_back(new VertexBuffer(data, size));
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, components * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	this->components.push_back(components);
+	return (int)buffers.size() - 1;
+}
+
+int MeshBuffer::AddInstanceAttribute(unsigned int location, int components, const void* data, unsigned int size)
+{
+	int buffer = AddAttribute(location, components, data, size);
+	glBindVertexArray(vao);
+	glVertexAttribDivisor(location, 1);
+	glBindVertexArray(0);
+	return buffer;
+}
+
+void MeshBuffer::SetIndices(const unsigned int* data, unsigned int count)
+{
+	// the element binding is part of the vertex array state
+	glBindVertexArray(vao);
+	if (indices)
+		indices->UpdateData(data, count);
+	else
+		indices.reset(new IndexBuffer(data, count));
+	glBindVertexArray(0);
+}
+
+void MeshBuffer::UpdateAttribute(int buffer, const void* data, unsigned int size)
+{
+	buffers[buffer]->UpdateData(data, size);
+	buffers[buffer]->Unbind();
+}
+
+unsigned int MeshBuffer::getCount() const
+{
+	if (indices)
+		return indices->getCount();
+	if (buffers.empty())
+		return 0;
+	return buffers[0]->getSize() / (components[0] * sizeof(float));
+}
+
+void MeshBuffer::Bind() const
+{
+	glBindVertexArray(vao);
+}
+
+void MeshBuffer::Unbind() const
+{
+	glBindVertexArray(0);
+}
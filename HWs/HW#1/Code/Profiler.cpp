@@ -0,0 +1,199 @@
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+#include <glad/glad.h>
+#include <imgui/imgui.h>
+
+Profiler& Profiler::get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+void Profiler::initGpu() {
+	glGenQueries(PROFILE_GPU_LATENCY * PROFILE_MAX_STAGES, &queries[0][0]);
+	memset(issued, 0, sizeof(issued));
+	memset(issuedFrame, 0, sizeof(issuedFrame));
+	gpuAvailable = true;
+}
+
+void Profiler::shutdownGpu() {
+	if (!gpuAvailable)
+		return;
+	glDeleteQueries(PROFILE_GPU_LATENCY * PROFILE_MAX_STAGES, &queries[0][0]);
+	gpuAvailable = false;
+}
+
+int Profiler::stage(const char* name) {
+	for (int i = 0; i < stageCount; i++)
+		if (strcmp(names[i], name) == 0)
+			return i;
+	if (stageCount == PROFILE_MAX_STAGES)
+		return PROFILE_MAX_STAGES - 1; // out of stages, the last one collects the rest
+	names[stageCount] = name;
+	for (auto& f : history)
+		f.cpu[stageCount] = f.gpu[stageCount] = -1.0f;
+	return stageCount++;
+}
+
+void Profiler::beginFrame() {
+	Frame& f = history[frame % PROFILE_HISTORY];
+	for (int i = 0; i < PROFILE_MAX_STAGES; i++)
+		f.cpu[i] = f.gpu[i] = -1.0f;
+	f.cpuTotal = 0.0f;
+	f.gpuTotal = -1.0f;
+	frameStart = clock::now();
+	if (gpuAvailable && enabled)
+		readQueries((int)(frame % PROFILE_GPU_LATENCY));
+}
+
+void Profiler::endFrame() {
+	Frame& f = history[frame % PROFILE_HISTORY];
+	f.cpuTotal = std::chrono::duration<float, std::milli>(clock::now() - frameStart).count();
+	frame++;
+}
+
+void Profiler::beginCpu(int stage) {
+	if (enabled)
+		cpuStart[stage] = clock::now();
+}
+
+void Profiler::endCpu(int stage) {
+	if (!enabled)
+		return;
+	float ms = std::chrono::duration<float, std::milli>(clock::now() - cpuStart[stage]).count();
+	float& slot = history[frame % PROFILE_HISTORY].cpu[stage];
+	slot = slot < 0.0f ? ms : slot + ms;
+}
+
+void Profiler::beginGpu(int stage) {
+	if (!gpuAvailable || !enabled || openGpu >= 0)
+		return;
+	int slot = (int)(frame % PROFILE_GPU_LATENCY);
+	// a stage timed twice in a frame only keeps its first query
+	if (issued[slot][stage])
+		return;
+	glBeginQuery(GL_TIME_ELAPSED, queries[slot][stage]);
+	issued[slot][stage] = true;
+	issuedFrame[slot] = frame;
+	openGpu = stage;
+}
+
+void Profiler::endGpu() {
+	if (openGpu < 0)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	openGpu = -1;
+}
+
+// the queries of the frame that used this slot PROFILE_GPU_LATENCY frames ago, results that
+// are still not available are dropped instead of stalling the pipeline
+void Profiler::readQueries(int slot) {
+	long long old = issuedFrame[slot];
+	if (frame - old >= PROFILE_HISTORY) {
+		memset(issued[slot], 0, sizeof(issued[slot]));
+		return;
+	}
+	Frame& f = history[old % PROFILE_HISTORY];
+	float total = 0.0f;
+	bool any = false;
+	for (int i = 0; i < stageCount; i++) {
+		if (!issued[slot][i])
+			continue;
+		issued[slot][i] = false;
+		GLint available = 0;
+		glGetQueryObjectiv(queries[slot][i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(queries[slot][i], GL_QUERY_RESULT, &ns);
+		f.gpu[i] = (float)(ns / 1.0e6);
+		total += f.gpu[i];
+		any = true;
+	}
+	if (any)
+		f.gpuTotal = total;
+}
+
+int Profiler::gather(int stage, bool gpu, float* out) const {
+	int count = 0;
+	long long first = std::max(0ll, frame - PROFILE_HISTORY);
+	for (long long i = first; i < frame; i++) {
+		const Frame& f = history[i % PROFILE_HISTORY];
+		float v = stage < 0 ? (gpu ? f.gpuTotal : f.cpuTotal) : (gpu ? f.gpu[stage] : f.cpu[stage]);
+		if (v >= 0.0f)
+			out[count++] = v;
+	}
+	return count;
+}
+
+void Profiler::percentiles(const float* values, int count, float& p50, float& p99) const {
+	p50 = p99 = 0.0f;
+	if (count == 0)
+		return;
+	float sorted[PROFILE_HISTORY];
+	std::copy(values, values + count, sorted);
+	std::sort(sorted, sorted + count);
+	p50 = sorted[count / 2];
+	p99 = sorted[std::min(count - 1, (int)(count * 0.99f))];
+}
+
+void Profiler::gui() {
+	ImGui::Begin("Profiler");
+	ImGui::Checkbox("Enabled", &enabled);
+	if (!gpuAvailable)
+		ImGui::Text("GPU timer queries unavailable");
+
+	float values[PROFILE_HISTORY];
+	float gpuValues[PROFILE_HISTORY];
+	float p50, p99, gp50, gp99;
+	int n = gather(-1, false, values);
+	int gn = gather(-1, true, gpuValues);
+	percentiles(values, n, p50, p99);
+	percentiles(gpuValues, gn, gp50, gp99);
+	ImGui::Text("Frame  CPU p50 %.3f p99 %.3f ms   GPU p50 %.3f p99 %.3f ms", p50, p99, gp50, gp99);
+	// whichever side takes longer bounds the frame
+	if (gn > 0)
+		ImGui::Text(gp50 > p50 ? "GPU bound" : "CPU bound");
+	ImGui::PlotLines("CPU ms", values, n, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+	if (gn > 0)
+		ImGui::PlotLines("GPU ms", gpuValues, gn, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+	ImGui::Separator();
+
+	for (int i = 0; i < stageCount; i++) {
+		ImGui::PushID(i);
+		n = gather(i, false, values);
+		percentiles(values, n, p50, p99);
+		gn = gather(i, true, gpuValues);
+		percentiles(gpuValues, gn, gp50, gp99);
+		if (gn > 0)
+			ImGui::Text("%-10s CPU p50 %.3f p99 %.3f   GPU p50 %.3f p99 %.3f", names[i], p50, p99, gp50, gp99);
+		else
+			ImGui::Text("%-10s CPU p50 %.3f p99 %.3f", names[i], p50, p99);
+		ImGui::PlotLines("##cpu", values, n, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 30.0f));
+		if (gn > 0)
+			ImGui::PlotLines("GPU", gpuValues, gn, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 30.0f));
+		ImGui::PopID();
+	}
+	ImGui::End();
+}
+
+// gpu columns only for stages that were timed on the gpu
+void Profiler::printSummary() const {
+	float values[PROFILE_HISTORY];
+	float p50, p99, gp50, gp99;
+	for (int i = -1; i < stageCount; i++) {
+		int n = gather(i, false, values);
+		percentiles(values, n, p50, p99);
+		int gn = gather(i, true, values);
+		percentiles(values, gn, gp50, gp99);
+		printf("%-12s p50 %8.4f ms  p99 %8.4f ms", i < 0 ? "frame" : names[i], p50, p99);
+		if (gn > 0)
+			printf("  gpu p50 %8.4f ms  p99 %8.4f ms", gp50, gp99);
+		if (i < 0)
+			printf("  (last %d frames)", n);
+		printf("\n");
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+
+#define PROFILE_MAX_STAGES 16
+#define PROFILE_HISTORY 240 // frames kept for the graphs and percentiles
+#define PROFILE_GPU_LATENCY 4 // frames a timer query gets before it is read back
+
+// per stage CPU timers and GL_TIME_ELAPSED queries, every frame is one entry of a ring buffer
+// stages are registered once by name, a stage timed several times in a frame accumulates
+class Profiler {
+
+public:
+	static Profiler& get();
+
+	// GL timer queries need a context, without one only the CPU side is measured
+	void initGpu();
+	void shutdownGpu();
+
+	int stage(const char* name);
+
+	void beginFrame();
+	void endFrame();
+
+	void beginCpu(int stage);
+	void endCpu(int stage);
+	// time elapsed queries can not nest, only one GPU stage may be open at a time
+	void beginGpu(int stage);
+	void endGpu();
+
+	void gui();
+	// p50 and p99 of every stage, for runs without a window
+	void printSummary() const;
+
+	bool enabled = true;
+
+private:
+	typedef std::chrono::steady_clock clock;
+
+	struct Frame {
+		float cpu[PROFILE_MAX_STAGES]; // ms
+		float gpu[PROFILE_MAX_STAGES]; // ms, negative until the query was read back
+		float cpuTotal;
+		float gpuTotal;
+	};
+
+	void readQueries(int slot);
+	void percentiles(const float* values, int count, float& p50, float& p99) const;
+	int gather(int stage, bool gpu, float* out) const; // valid history of a stage, oldest first
+
+	const char* names[PROFILE_MAX_STAGES];
+	int stageCount = 0;
+
+	Frame history[PROFILE_HISTORY];
+	long long frame = 0; // index of the frame being recorded
+	clock::time_point frameStart;
+	clock::time_point cpuStart[PROFILE_MAX_STAGES];
+
+	bool gpuAvailable = false;
+	unsigned int queries[PROFILE_GPU_LATENCY][PROFILE_MAX_STAGES];
+	bool issued[PROFILE_GPU_LATENCY][PROFILE_MAX_STAGES];
+	long long issuedFrame[PROFILE_GPU_LATENCY];
+	int openGpu = -1;
+};
+
+// times the enclosing block, the GPU variant also wraps it in a timer query
+class ProfileScope {
+
+public:
+	ProfileScope(int stage, bool gpu = false) : stage(stage), gpu(gpu) {
+		Profiler& p = Profiler::get();
+		p.beginCpu(stage);
+		if (gpu)
+			p.beginGpu(stage);
+	}
+	~ProfileScope() {
+		Profiler& p = Profiler::get();
+		if (gpu)
+			p.endGpu();
+		p.endCpu(stage);
+	}
+
+private:
+	int stage;
+	bool gpu;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+	static const int PROFILE_CONCAT(profileStage, __LINE__) = Profiler::get().stage(name); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileStage, __LINE__))
+#define PROFILE_GPU_SCOPE(name) \
+	static const int PROFILE_CONCAT(profileStage, __LINE__) = Profiler::get().stage(name); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileStage, __LINE__), true)
+
+#endif
@@ -0,0 +1,255 @@
+#include "Scene.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <initializer_list>
+#include <filesystem>
+
+#define SCENE_CACHE_MAGIC 0x43534342 // "BCSC"
+#define SCENE_CACHE_VERSION 3
+
+struct SceneCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t hash;
+	int64_t mtime;
+	uint64_t fileSize;
+};
+
+static uint64_t hashBytes(const char* data, size_t size) {
+	uint64_t h = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+		h = (h ^ (unsigned char)data[i]) * 1099511628211ull;
+	return h;
+}
+
+static bool fail(std::string& error, const JsonValue& v, const std::string& what) {
+	error = "line " + std::to_string(v.line) + ": " + what;
+	return false;
+}
+
+static bool getFloat(const JsonValue& obj, const char* key, float& out, float lo, float hi, std::string& error) {
+	const JsonValue* v = obj.find(key);
+	if (!v)
+		return true;
+	if (!v->isNumber())
+		return fail(error, *v, std::string(key) + " must be a number");
+	if (v->number < lo || v->number > hi)
+		return fail(error, *v, std::string(key) + " must be in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+	out = (float)v->number;
+	return true;
+}
+
+static bool getInt(const JsonValue& obj, const char* key, int& out, int lo, int hi, std::string& error) {
+	const JsonValue* v = obj.find(key);
+	if (!v)
+		return true;
+	if (!v->isNumber() || v->number != (double)(long long)v->number)
+		return fail(error, *v, std::string(key) + " must be an integer");
+	if (v->number < lo || v->number > hi)
+		return fail(error, *v, std::string(key) + " must be in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+	out = (int)v->number;
+	return true;
+}
+
+static bool getVec3(const JsonValue& obj, const char* key, glm::vec3& out, std::string& error) {
+	const JsonValue* v = obj.find(key);
+	if (!v)
+		return true;
+	if (!v->isArray() || v->array.size() != 3 ||
+		!v->array[0].isNumber() || !v->array[1].isNumber() || !v->array[2].isNumber())
+		return fail(error, *v, std::string(key) + " must be an array of 3 numbers");
+	out = glm::vec3((float)v->array[0].number, (float)v->array[1].number, (float)v->array[2].number);
+	return true;
+}
+
+static bool checkMembers(const JsonValue& obj, std::initializer_list<const char*> allowed, std::string& error) {
+	for (const auto& m : obj.members) {
+		if (std::find_if(allowed.begin(), allowed.end(), [&](const char* a) { return m.first == a; }) == allowed.end())
+			return fail(error, m.second, "unknown member \"" + m.first + "\"");
+	}
+	return true;
+}
+
+// {"type": "gravity" | "wind" | "drag", "region": {"center", "halfExtent"}, "enabled"} with g,
+// wind and windFactor, or factor
+static bool compileField(const JsonValue& fv, SceneField& field, std::string& error) {
+	if (!fv.isObject())
+		return fail(error, fv, "field must be an object");
+	const JsonValue* type = fv.find("type");
+	if (!type || type->type != JsonValue::String)
+		return fail(error, fv, "field needs a type");
+	field = SceneField();
+	field.enabled = 1;
+	field.bmin = glm::vec3(-FLT_MAX);
+	field.bmax = glm::vec3(FLT_MAX);
+	bool ok;
+	if (type->string == "gravity") {
+		field.type = FIELD_GRAVITY;
+		ok = checkMembers(fv, { "type", "enabled", "region", "g" }, error) &&
+			getVec3(fv, "g", field.v, error);
+	}
+	else if (type->string == "wind") {
+		field.type = FIELD_WIND;
+		field.f = 1.0f;
+		ok = checkMembers(fv, { "type", "enabled", "region", "wind", "windFactor" }, error) &&
+			getVec3(fv, "wind", field.v, error) &&
+			getFloat(fv, "windFactor", field.f, -FLT_MAX, FLT_MAX, error);
+	}
+	else if (type->string == "drag") {
+		field.type = FIELD_DRAG;
+		ok = checkMembers(fv, { "type", "enabled", "region", "factor" }, error) &&
+			getFloat(fv, "factor", field.f, 0.0f, FLT_MAX, error);
+	}
+	else {
+		return fail(error, *type, "unknown field type \"" + type->string + "\"");
+	}
+	if (!ok)
+		return false;
+
+	if (const JsonValue* enabled = fv.find("enabled")) {
+		if (enabled->type != JsonValue::Bool)
+			return fail(error, *enabled, "enabled must be true or false");
+		field.enabled = enabled->boolean ? 1 : 0;
+	}
+	if (const JsonValue* region = fv.find("region")) {
+		glm::vec3 center(0.0f), halfExtent(-1.0f);
+		if (!region->isObject())
+			return fail(error, *region, "region must be an object");
+		if (!checkMembers(*region, { "center", "halfExtent" }, error) ||
+			!getVec3(*region, "center", center, error) ||
+			!getVec3(*region, "halfExtent", halfExtent, error))
+			return false;
+		if (halfExtent.x < 0.0f || halfExtent.y < 0.0f || halfExtent.z < 0.0f)
+			return fail(error, *region, "region needs a halfExtent that is not negative");
+		field.bmin = center - halfExtent;
+		field.bmax = center + halfExtent;
+	}
+	return true;
+}
+
+bool compileScene(const JsonValue& root, BallScene& scene, std::string& error) {
+	if (!root.isObject())
+		return fail(error, root, "scene must be an object");
+	static const char* const allowed[] = { "name", "cubeSize", "radius", "mass", "gravity",
+		"position", "velocity", "wind", "windFactor", "airResistance", "elasticity", "friction", "timestep",
+		"restVelocity", "restSteps", "count", "fields" };
+	for (const auto& m : root.members) {
+		if (std::find_if(std::begin(allowed), std::end(allowed), [&](const char* a) { return m.first == a; }) == std::end(allowed))
+			return fail(error, m.second, "unknown member \"" + m.first + "\"");
+	}
+
+	scene = BallScene();
+	if (const JsonValue* name = root.find("name")) {
+		if (!name->isString() || name->string.size() >= SCENE_MAX_NAME)
+			return fail(error, *name, "name must be a string shorter than " + std::to_string(SCENE_MAX_NAME));
+		memcpy(scene.name, name->string.c_str(), name->string.size() + 1);
+	}
+	if (!getFloat(root, "cubeSize", scene.cubeSize, 0.01f, 1000.0f, error) ||
+		!getFloat(root, "radius", scene.radius, 0.01f, 1000.0f, error) ||
+		!getFloat(root, "mass", scene.m, 1e-6f, FLT_MAX, error) ||
+		!getVec3(root, "gravity", scene.gravity, error) ||
+		!getVec3(root, "position", scene.position, error) ||
+		!getVec3(root, "velocity", scene.velocity, error) ||
+		!getVec3(root, "wind", scene.wind, error) ||
+		!getFloat(root, "windFactor", scene.windFactor, -FLT_MAX, FLT_MAX, error) ||
+		!getFloat(root, "airResistance", scene.airResistanceFactor, 0.0f, FLT_MAX, error) ||
+		!getFloat(root, "elasticity", scene.elas, 0.0f, 1.0f, error) ||
+		!getFloat(root, "friction", scene.mu, 0.0f, FLT_MAX, error) ||
+		!getFloat(root, "timestep", scene.timestep, 1e-5f, 0.5f, error) ||
+		!getFloat(root, "restVelocity", scene.restVelocity, 0.0f, FLT_MAX, error) ||
+		!getInt(root, "restSteps", scene.restSteps, 1, 1 << 20, error) ||
+		!getInt(root, "count", scene.count, 1, 1 << 20, error))
+		return false;
+
+	if (const JsonValue* fields = root.find("fields")) {
+		if (!fields->isArray() || fields->array.size() > SCENE_MAX_FIELDS)
+			return fail(error, *fields, "fields must be an array of at most " + std::to_string(SCENE_MAX_FIELDS) + " fields");
+		for (const JsonValue& fv : fields->array)
+			if (!compileField(fv, scene.fields[scene.fieldCount++], error))
+				return false;
+	}
+
+	// the ball has to start inside the cube
+	float limit = scene.cubeSize / 2.0f - scene.radius;
+	if (limit <= 0.0f)
+		return fail(error, root, "radius does not fit in the cube");
+	glm::vec3 p = glm::abs(scene.position);
+	if (p.x > limit || p.y > limit || p.z > limit)
+		return fail(error, *root.find("position"), "position puts the ball outside the cube");
+	return true;
+}
+
+bool loadScene(const std::string& path, BallScene& scene, bool useCache) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::cout << "ERROR: Scene File Reading Failed: " << path << std::endl;
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	std::error_code ec;
+	SceneCacheHeader header = {};
+	header.magic = SCENE_CACHE_MAGIC;
+	header.version = SCENE_CACHE_VERSION;
+	header.hash = hashBytes(text.data(), text.size());
+	header.mtime = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	header.fileSize = text.size();
+	std::string cachePath = path + ".scache";
+
+	if (useCache) {
+		std::ifstream cache(cachePath, std::ios::binary);
+		SceneCacheHeader cached;
+		BallScene s;
+		if (cache.read((char*)&cached, sizeof(cached)) && cache.read((char*)&s, sizeof(s)) &&
+			cache.peek() == EOF && memcmp(&cached, &header, sizeof(header)) == 0) {
+			s.name[SCENE_MAX_NAME - 1] = '\0';
+			scene = s;
+			return true;
+		}
+	}
+
+	JsonValue root;
+	std::string error;
+	if (!parseJson(text.data(), text.size(), root, error) || !compileScene(root, scene, error)) {
+		std::cout << "ERROR: Scene Invalid: " << path << " " << error << std::endl;
+		return false;
+	}
+
+	if (useCache) {
+		// write to a temporary and rename so a crash never leaves a half written cache behind
+		std::string tmp = cachePath + ".tmp";
+		std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+		if (out) {
+			out.write((const char*)&header, sizeof(header));
+			out.write((const char*)&scene, sizeof(scene));
+			out.close();
+			std::filesystem::rename(tmp, cachePath, ec);
+			if (ec)
+				std::filesystem::remove(tmp, ec);
+		}
+	}
+	return true;
+}
+
+std::vector<std::string> listScenes(const std::string& dir) {
+	std::vector<std::string> paths;
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+		if (entry.path().extension() == ".json")
+			paths.push_back(entry.path().string());
+	}
+	// numbered files sort by their number so 10_ comes after 9_
+	auto number = [](const std::string& p) { return atoi(std::filesystem::path(p).filename().string().c_str()); };
+	std::sort(paths.begin(), paths.end(), [&](const std::string& a, const std::string& b) {
+		int na = number(a), nb = number(b);
+		return na != nb ? na < nb : a < b;
+	});
+	return paths;
+}
@@ -0,0 +1,58 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "Json.h"
+
+#define SCENE_MAX_NAME 64
+#define SCENE_MAX_FIELDS 16
+
+enum SceneFieldType { FIELD_GRAVITY = 0, FIELD_WIND = 1, FIELD_DRAG = 2 };
+
+// a force limited to a box, on top of the scene wide gravity, wind and air resistance
+struct SceneField {
+	int type;
+	int enabled;
+	glm::vec3 v; // gravity or wind
+	float f; // wind factor or air resistance
+	glm::vec3 bmin;
+	glm::vec3 bmax;
+};
+
+// bouncing ball setup, plain data so the cache is this struct written as it is
+// the first ball starts at position, the other count - 1 are spread through the cube
+struct BallScene {
+	char name[SCENE_MAX_NAME] = "Scene";
+	float cubeSize = 10.0f;
+	float radius = 0.5f;
+	float m = 1.0f;
+	glm::vec3 gravity = glm::vec3(0.0f, 0.0f, -10.0f);
+	glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
+	glm::vec3 velocity = glm::vec3(0.0f);
+	glm::vec3 wind = glm::vec3(0.0f);
+	float windFactor = 0.0f;
+	float airResistanceFactor = 0.0f;
+	float elas = 0.1f;
+	float mu = 0.4f;
+	float timestep = 0.01f;
+	float restVelocity = 0.25f;
+	int restSteps = 30;
+	int count = 1;
+	SceneField fields[SCENE_MAX_FIELDS] = {};
+	int fieldCount = 0;
+};
+
+// loads a json scene, the validated result is cached next to it as <path>.scache and reused
+// as long as the file size, mtime and content hash match
+bool loadScene(const std::string& path, BallScene& scene, bool useCache = true);
+
+// unknown members are errors so typos do not go unnoticed
+bool compileScene(const JsonValue& root, BallScene& scene, std::string& error);
+
+// every .json in dir, sorted by the number their file name starts with, then by name
+std::vector<std::string> listScenes(const std::string& dir);
+
+#endif
@@ -0,0 +1,333 @@
+#include "Sweep.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+#include "BallSystem.h"
+
+// scene members a sweep may vary, named as in the scene files, with the bounds compileScene checks
+struct SweepMember {
+	const char* name;
+	int components;
+	float lo, hi;
+	float* (*field)(BallScene& scene);
+};
+
+static const SweepMember members[] = {
+	{ "cubeSize", 1, 0.01f, 1000.0f, [](BallScene& s) { return &s.cubeSize; } },
+	{ "radius", 1, 0.01f, 1000.0f, [](BallScene& s) { return &s.radius; } },
+	{ "mass", 1, 1e-6f, FLT_MAX, [](BallScene& s) { return &s.m; } },
+	{ "gravity", 3, -FLT_MAX, FLT_MAX, [](BallScene& s) { return &s.gravity.x; } },
+	{ "position", 3, -FLT_MAX, FLT_MAX, [](BallScene& s) { return &s.position.x; } },
+	{ "velocity", 3, -FLT_MAX, FLT_MAX, [](BallScene& s) { return &s.velocity.x; } },
+	{ "wind", 3, -FLT_MAX, FLT_MAX, [](BallScene& s) { return &s.wind.x; } },
+	{ "windFactor", 1, -FLT_MAX, FLT_MAX, [](BallScene& s) { return &s.windFactor; } },
+	{ "airResistance", 1, 0.0f, FLT_MAX, [](BallScene& s) { return &s.airResistanceFactor; } },
+	{ "elasticity", 1, 0.0f, 1.0f, [](BallScene& s) { return &s.elas; } },
+	{ "friction", 1, 0.0f, FLT_MAX, [](BallScene& s) { return &s.mu; } },
+	{ "timestep", 1, 1e-5f, 0.5f, [](BallScene& s) { return &s.timestep; } },
+	{ "restVelocity", 1, 0.0f, FLT_MAX, [](BallScene& s) { return &s.restVelocity; } },
+};
+
+// a grid member has its list of values, a random one its range
+struct SweepAxis {
+	const SweepMember* member;
+	std::vector<glm::vec3> values;
+	float lo = 0.0f, hi = 0.0f;
+};
+
+static bool fail(std::string& error, const JsonValue& v, const std::string& what) {
+	error = "line " + std::to_string(v.line) + ": " + what;
+	return false;
+}
+
+static const SweepMember* findMember(const std::string& name) {
+	for (const SweepMember& m : members)
+		if (name == m.name)
+			return &m;
+	return nullptr;
+}
+
+static bool getValue(const JsonValue& v, const SweepMember& m, glm::vec3& out, std::string& error) {
+	if (m.components == 1) {
+		if (!v.isNumber())
+			return fail(error, v, std::string(m.name) + " values must be numbers");
+		if (v.number < m.lo || v.number > m.hi)
+			return fail(error, v, std::string(m.name) + " must be in [" + std::to_string(m.lo) + ", " + std::to_string(m.hi) + "]");
+		out = glm::vec3((float)v.number, 0.0f, 0.0f);
+		return true;
+	}
+	if (!v.isArray() || v.array.size() != 3 ||
+		!v.array[0].isNumber() || !v.array[1].isNumber() || !v.array[2].isNumber())
+		return fail(error, v, std::string(m.name) + " values must be arrays of 3 numbers");
+	out = glm::vec3((float)v.array[0].number, (float)v.array[1].number, (float)v.array[2].number);
+	return true;
+}
+
+static bool getAxes(const JsonValue& root, const char* key, bool grid, std::vector<SweepAxis>& axes, std::string& error) {
+	const JsonValue* obj = root.find(key);
+	if (!obj)
+		return true;
+	if (!obj->isObject())
+		return fail(error, *obj, std::string(key) + " must be an object");
+	for (const auto& entry : obj->members) {
+		SweepAxis axis;
+		axis.member = findMember(entry.first);
+		if (!axis.member)
+			return fail(error, entry.second, "\"" + entry.first + "\" can not be swept");
+		for (const SweepAxis& a : axes)
+			if (a.member == axis.member)
+				return fail(error, entry.second, entry.first + " is swept twice");
+		const JsonValue& v = entry.second;
+		if (!v.isArray() || v.array.empty())
+			return fail(error, v, entry.first + " must be a non empty array");
+		if (grid) {
+			axis.values.resize(v.array.size());
+			for (size_t k = 0; k < v.array.size(); k++)
+				if (!getValue(v.array[k], *axis.member, axis.values[k], error))
+					return false;
+		}
+		else {
+			// a vector member is drawn as a length, so its range is a pair of numbers too
+			if (v.array.size() != 2 || !v.array[0].isNumber() || !v.array[1].isNumber() || v.array[0].number > v.array[1].number)
+				return fail(error, v, entry.first + " must be a range [lo, hi]");
+			axis.lo = (float)v.array[0].number;
+			axis.hi = (float)v.array[1].number;
+			float lo = axis.member->components == 1 ? axis.member->lo : 0.0f;
+			float hi = axis.member == findMember("position") ? 1.0f : axis.member->hi;
+			if (axis.lo < lo || axis.hi > hi)
+				return fail(error, v, entry.first + " range must be in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+		}
+		axes.push_back(axis);
+	}
+	return true;
+}
+
+static bool getInt(const JsonValue& obj, const char* key, int& out, int lo, int hi, std::string& error) {
+	const JsonValue* v = obj.find(key);
+	if (!v)
+		return true;
+	if (!v->isNumber() || v->number != (double)(long long)v->number || v->number < lo || v->number > hi)
+		return fail(error, *v, std::string(key) + " must be an integer in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+	out = (int)v->number;
+	return true;
+}
+
+// the grid is walked like a number whose digits are the value index of each axis, the random
+// draws come from one generator in scenario order so a sweep file always gives the same runs
+static bool generate(const JsonValue& root, Sweep& sweep, const std::vector<SweepAxis>& grid,
+	const std::vector<SweepAxis>& random, int samples, unsigned seed, std::string& error) {
+	// checked at every axis, the full product of many long axes would overflow first
+	long long combinations = 1;
+	for (const SweepAxis& a : grid) {
+		combinations *= (long long)a.values.size();
+		if (combinations > SWEEP_MAX_SCENARIOS / samples)
+			return fail(error, root, "more than " + std::to_string(SWEEP_MAX_SCENARIOS) + " scenarios");
+	}
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> normal;
+	sweep.scenarios.reserve((size_t)(combinations * samples));
+	std::vector<size_t> digit(grid.size(), 0);
+	for (long long c = 0; c < combinations; c++) {
+		for (int s = 0; s < samples; s++) {
+			BallScene scene = sweep.base;
+			for (size_t a = 0; a < grid.size(); a++) {
+				float* f = grid[a].member->field(scene);
+				for (int k = 0; k < grid[a].member->components; k++)
+					f[k] = grid[a].values[digit[a]][k];
+			}
+			for (const SweepAxis& a : random) {
+				float* f = a.member->field(scene);
+				float value = a.lo + (a.hi - a.lo) * unit(rng);
+				if (a.member->components == 1) {
+					f[0] = value;
+					continue;
+				}
+				glm::vec3 dir(normal(rng), normal(rng), normal(rng));
+				float len = glm::length(dir);
+				dir = len > 0.0f ? dir / len : glm::vec3(0.0f, 0.0f, 1.0f);
+				if (a.member == findMember("position"))
+					value *= std::max(scene.cubeSize / 2.0f - scene.radius, 0.0f);
+				for (int k = 0; k < 3; k++)
+					f[k] = dir[k] * value;
+			}
+
+			// grid values may move the walls past a position that was fine in the scene
+			float limit = scene.cubeSize / 2.0f - scene.radius;
+			if (limit <= 0.0f)
+				return fail(error, root, "radius does not fit in the cube in scenario " + std::to_string(sweep.scenarios.size()));
+			scene.position = glm::clamp(scene.position, glm::vec3(-limit), glm::vec3(limit));
+			sweep.scenarios.push_back(scene);
+		}
+		for (size_t a = grid.size(); a-- > 0;) {
+			if (++digit[a] < grid[a].values.size())
+				break;
+			digit[a] = 0;
+		}
+	}
+
+	for (const std::vector<SweepAxis>* axes : { &grid, &random }) {
+		for (const SweepAxis& a : *axes) {
+			if (a.member->components == 1) {
+				sweep.columns.push_back(a.member->name);
+				continue;
+			}
+			for (const char* suffix : { "X", "Y", "Z" })
+				sweep.columns.push_back(std::string(a.member->name) + suffix);
+		}
+	}
+	return true;
+}
+
+static bool compileSweep(const JsonValue& root, const std::string& path, Sweep& sweep, std::string& error) {
+	if (!root.isObject())
+		return fail(error, root, "sweep must be an object");
+	static const char* const allowed[] = { "scene", "grid", "random", "samples", "seed", "steps", "events" };
+	for (const auto& m : root.members) {
+		if (std::find_if(std::begin(allowed), std::end(allowed), [&](const char* a) { return m.first == a; }) == std::end(allowed))
+			return fail(error, m.second, "unknown member \"" + m.first + "\"");
+	}
+
+	sweep = Sweep();
+	const JsonValue* scene = root.find("scene");
+	if (!scene)
+		return fail(error, root, "scene is missing");
+	if (scene->isString()) {
+		// relative to the sweep file
+		std::filesystem::path scenePath = std::filesystem::path(path).parent_path() / scene->string;
+		if (!loadScene(scenePath.string(), sweep.base))
+			return fail(error, *scene, "scene " + scene->string + " did not load");
+	}
+	else if (!compileScene(*scene, sweep.base, error)) {
+		return false;
+	}
+
+	int samples = 1, seed = 1;
+	std::vector<SweepAxis> grid, random;
+	if (!getAxes(root, "grid", true, grid, error) ||
+		!getAxes(root, "random", false, random, error) ||
+		!getInt(root, "samples", samples, 1, SWEEP_MAX_SCENARIOS, error) ||
+		!getInt(root, "seed", seed, 0, 0x7fffffff, error) ||
+		!getInt(root, "steps", sweep.steps, 1, 1 << 30, error))
+		return false;
+	// a random position is scaled by the room the other members leave, so it is drawn last
+	std::stable_partition(random.begin(), random.end(), [](const SweepAxis& a) { return a.member != findMember("position"); });
+	for (const SweepAxis& a : grid)
+		for (const SweepAxis& b : random)
+			if (a.member == b.member)
+				return fail(error, root, std::string(a.member->name) + " is both in grid and random");
+	if (const JsonValue* events = root.find("events")) {
+		if (events->type != JsonValue::Bool)
+			return fail(error, *events, "events must be true or false");
+		sweep.events = events->boolean;
+	}
+	return generate(root, sweep, grid, random, samples, (unsigned)seed, error);
+}
+
+bool loadSweep(const std::string& path, Sweep& sweep) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::cout << "ERROR: Sweep File Reading Failed: " << path << std::endl;
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	JsonValue root;
+	std::string error;
+	if (!parseJson(text.data(), text.size(), root, error) || !compileSweep(root, path, sweep, error)) {
+		std::cout << "ERROR: Sweep Invalid: " << path << " " << error << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// a scene with constant forces never wakes a ball again once all rest, so the run stops there
+static SweepResult simulate(const BallScene& scene, int steps, bool events) {
+	SweepResult r;
+	BallSystem balls;
+	balls.reset(scene, scene.count);
+	r.startEnergy = balls.energy(scene);
+	while (r.steps < steps && balls.awake > 0) {
+		if (events)
+			balls.advance(scene, scene.timestep);
+		else
+			balls.step(scene);
+		r.steps++;
+	}
+	if (balls.awake == 0)
+		r.timeToRest = balls.t;
+	r.bounces = balls.bounces;
+	r.finalEnergy = balls.energy(scene);
+	r.position = balls.position(0);
+	return r;
+}
+
+// runs differ a lot in length, so each thread takes the next few scenarios whenever it is done
+// instead of a fixed share
+void runSweep(const Sweep& sweep, int threads, std::vector<SweepResult>& results) {
+	int n = (int)sweep.scenarios.size();
+	results.assign(n, SweepResult());
+	if (threads <= 0)
+		threads = (int)std::max(std::thread::hardware_concurrency(), 1u);
+	threads = std::max(std::min(threads, n), 1);
+	const int chunk = 16;
+	std::atomic<int> next(0);
+	auto work = [&]() {
+		for (int first = next.fetch_add(chunk); first < n; first = next.fetch_add(chunk)) {
+			int last = std::min(first + chunk, n);
+			for (int i = first; i < last; i++)
+				results[i] = simulate(sweep.scenarios[i], sweep.steps, sweep.events);
+		}
+	};
+	std::vector<std::thread> pool;
+	for (int k = 1; k < threads; k++)
+		pool.emplace_back(work);
+	work();
+	for (std::thread& t : pool)
+		t.join();
+}
+
+bool writeSweepCsv(const std::string& path, const Sweep& sweep, const std::vector<SweepResult>& results) {
+	FILE* out = fopen(path.c_str(), "w");
+	if (!out) {
+		std::cout << "ERROR: Sweep Result Writing Failed: " << path << std::endl;
+		return false;
+	}
+	fprintf(out, "scenario");
+	for (const std::string& c : sweep.columns)
+		fprintf(out, ",%s", c.c_str());
+	fprintf(out, ",steps,bounces,timeToRest,startEnergy,finalEnergy,finalX,finalY,finalZ\n");
+
+	// the values are read back from the scenario so clamped positions show as they were run
+	for (size_t i = 0; i < results.size(); i++) {
+		BallScene scene = sweep.scenarios[i];
+		fprintf(out, "%zu", i);
+		for (const std::string& c : sweep.columns) {
+			const SweepMember* m = findMember(c);
+			int k = 0;
+			if (!m) {
+				m = findMember(c.substr(0, c.size() - 1));
+				k = c.back() - 'X';
+			}
+			fprintf(out, ",%.9g", m->field(scene)[k]);
+		}
+		const SweepResult& r = results[i];
+		fprintf(out, ",%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", r.steps, r.bounces, r.timeToRest,
+			r.startEnergy, r.finalEnergy, r.position.x, r.position.y, r.position.z);
+	}
+	bool ok = !ferror(out);
+	fclose(out);
+	if (!ok)
+		std::cout << "ERROR: Sweep Result Writing Failed: " << path << std::endl;
+	return ok;
+}
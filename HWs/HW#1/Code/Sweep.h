@@ -0,0 +1,49 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+
+#define SWEEP_MAX_SCENARIOS (1 << 24)
+
+// many independent runs of one scene with some of its members varied, for stability studies
+// {
+//   "scene": { ... } or "path/to/scene.json",
+//   "grid": { "elasticity": [0.1, 0.5, 0.9], "wind": [[0, 0, 0], [1, 0, 0]] },
+//   "random": { "friction": [0, 1], "velocity": [0, 5] },
+//   "samples": 100, "seed": 1, "steps": 2000, "events": false
+// }
+// every combination of the grid values is run samples times with the random members drawn
+// uniformly from their ranges, a vector member draws a random direction with a length in the
+// range, for the position the length is a fraction of how far the ball can get from the center
+struct Sweep {
+	BallScene base;
+	std::vector<BallScene> scenarios; // grid combination major, then sample
+	std::vector<std::string> columns; // swept members in the order their values are written
+	int steps = 1000; // limit, a run ends earlier once every ball rests
+	bool events = false; // advance() by one timestep at a time instead of step()
+};
+
+// what one run ended with
+struct SweepResult {
+	int steps = 0;
+	int bounces = 0;
+	float timeToRest = -1.0f; // -1 when a ball still moved at the end
+	double startEnergy = 0.0;
+	double finalEnergy = 0.0;
+	glm::vec3 position = glm::vec3(0.0f); // of the first ball
+};
+
+// errors are printed like the scene loader does, the scenarios are generated here
+bool loadSweep(const std::string& path, Sweep& sweep);
+
+// the runs are shared out over threads, 0 uses every core, results are in scenario order
+void runSweep(const Sweep& sweep, int threads, std::vector<SweepResult>& results);
+
+// one row per scenario, its swept values then the results
+bool writeSweepCsv(const std::string& path, const Sweep& sweep, const std::vector<SweepResult>& results);
+
+#endif
@@ -0,0 +1,171 @@
+#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+#define SAP_MAX_SLABS 1024 // the slabs are made wider before there are more of them than this
+
+// the sweep runs along the axis the balls are spread the most, the slabs cut the one of the other
+// two that moved the least in the step so few boxes change slab, a change of either means a full sort
+void SweepAndPrune::chooseAxes(const float* const start[3], const float* const end[3], int count) {
+	double variance[3];
+	for (int a = 0; a < 3; a++) {
+		double sum = 0.0, sum2 = 0.0;
+		for (int i = 0; i < count; i++) {
+			sum += start[a][i];
+			sum2 += (double)start[a][i] * start[a][i];
+		}
+		double mean = sum / count;
+		variance[a] = sum2 / count - mean * mean;
+	}
+	int best = (int)(std::max_element(variance, variance + 3) - variance);
+	bool better = sweepAxis < 0 || variance[best] > 1.5 * variance[sweepAxis];
+	if (better && best != sweepAxis) {
+		sweepAxis = best;
+		sorted = false;
+	}
+	if (sorted)
+		return;
+
+	int a0 = (sweepAxis + 1) % 3, a1 = (sweepAxis + 2) % 3;
+	double motion0 = 0.0, motion1 = 0.0;
+	for (int i = 0; i < count; i++) {
+		motion0 += std::fabs(end[a0][i] - start[a0][i]);
+		motion1 += std::fabs(end[a1][i] - start[a1][i]);
+	}
+	slabAxis = motion0 <= motion1 ? a0 : a1;
+}
+
+void SweepAndPrune::findPairs(const float* const start[3], const float* const end[3], const float* radius, int count,
+	std::vector<std::pair<int, int>>& pairs) {
+	pairs.clear();
+	swaps = 0;
+	if (count < 2)
+		return;
+	if ((int)boxes.size() != count)
+		sorted = false;
+	chooseAxes(start, end, count);
+
+	int crossAxis = 3 - sweepAxis - slabAxis;
+	double extent = 0.0;
+	float lowestLo = INFINITY, highestHi = -INFINITY;
+	boxes.resize(count);
+	for (int i = 0; i < count; i++) {
+		Box& box = boxes[i];
+		box.lo = std::min(start[sweepAxis][i], end[sweepAxis][i]) - radius[i];
+		box.hi = std::max(start[sweepAxis][i], end[sweepAxis][i]) + radius[i];
+		box.slabLo = std::min(start[slabAxis][i], end[slabAxis][i]) - radius[i];
+		box.slabHi = std::max(start[slabAxis][i], end[slabAxis][i]) + radius[i];
+		box.crossLo = std::min(start[crossAxis][i], end[crossAxis][i]) - radius[i];
+		box.crossHi = std::max(start[crossAxis][i], end[crossAxis][i]) + radius[i];
+		box.ball = i;
+		extent += box.slabHi - box.slabLo;
+		lowestLo = std::min(lowestLo, box.slabLo);
+		highestHi = std::max(highestHi, box.slabHi);
+	}
+
+	// slabs about twice the average box keep most boxes in one or two lists, the few fast balls
+	// with long boxes go in every slab they cross
+	float average = (float)(extent / count);
+	float narrowest = (highestHi - lowestLo) / SAP_MAX_SLABS;
+	if (average > slabWidth || 4.0f * average < slabWidth || narrowest > slabWidth) {
+		slabWidth = std::max(2.0f * average, narrowest);
+		sorted = false;
+	}
+	int lowest = slabOf(lowestLo);
+	int highest = slabOf(highestHi);
+	if (lowest < firstSlab || highest >= firstSlab + (int)slabs.size())
+		sorted = false;
+
+	if (sorted) {
+		update(count);
+	}
+	else {
+		rebuild(count, lowest, highest);
+		sorted = true;
+	}
+
+	for (size_t k = 0; k < slabs.size(); k++)
+		sweep(slabs[k], firstSlab + (int)k, pairs);
+}
+
+// every box sorted into its slabs from scratch, with a slab of room on both ends so balls
+// drifting out of the current range do not force the next step to do it again
+void SweepAndPrune::rebuild(int count, int lowest, int highest) {
+	firstSlab = lowest - 1;
+	slabs.resize(highest - lowest + 3);
+	for (auto& list : slabs)
+		list.clear();
+	spanFirst.resize(count);
+	spanLast.resize(count);
+	for (int i = 0; i < count; i++) {
+		spanFirst[i] = slabOf(boxes[i].slabLo);
+		spanLast[i] = slabOf(boxes[i].slabHi);
+		for (int s = spanFirst[i]; s <= spanLast[i]; s++)
+			slabs[s - firstSlab].push_back(boxes[i]);
+	}
+	for (auto& list : slabs)
+		std::sort(list.begin(), list.end(), [](const Box& a, const Box& b) { return a.lo < b.lo; });
+}
+
+// boxes are refreshed in place and dropped from the slabs they left, each list is fixed with an
+// insertion sort, each ball only moves past the few it overtook since the last step, then the
+// boxes go into the slabs they reached where a binary search puts them
+void SweepAndPrune::update(int count) {
+	entering.clear();
+	for (int i = 0; i < count; i++) {
+		int first = slabOf(boxes[i].slabLo);
+		int last = slabOf(boxes[i].slabHi);
+		for (int s = first; s <= last; s++)
+			if (s < spanFirst[i] || s > spanLast[i])
+				entering.emplace_back(i, s);
+		spanFirst[i] = first;
+		spanLast[i] = last;
+	}
+
+	for (size_t k = 0; k < slabs.size(); k++) {
+		auto& list = slabs[k];
+		int s = firstSlab + (int)k;
+		int kept = 0;
+		for (const Box& old : list) {
+			int ball = old.ball;
+			if (s >= spanFirst[ball] && s <= spanLast[ball])
+				list[kept++] = boxes[ball];
+		}
+		list.resize(kept);
+
+		for (int m = 1; m < kept; m++) {
+			Box box = list[m];
+			int j = m - 1;
+			while (j >= 0 && list[j].lo > box.lo) {
+				list[j + 1] = list[j];
+				j--;
+				swaps++;
+			}
+			list[j + 1] = box;
+		}
+	}
+
+	for (const auto& enter : entering) {
+		const Box& box = boxes[enter.first];
+		auto& list = slabs[enter.second - firstSlab];
+		auto at = std::upper_bound(list.begin(), list.end(), box.lo, [](float key, const Box& b) { return key < b.lo; });
+		list.insert(at, box);
+	}
+}
+
+// each box is tested against the boxes after it that start before it ends, a pair of boxes
+// sharing several slabs is only reported by the slab their overlap starts in
+void SweepAndPrune::sweep(const std::vector<Box>& list, int s, std::vector<std::pair<int, int>>& pairs) const {
+	int n = (int)list.size();
+	for (int k = 0; k < n; k++) {
+		const Box& p = list[k];
+		for (int m = k + 1; m < n && list[m].lo <= p.hi; m++) {
+			const Box& q = list[m];
+			if (q.slabHi < p.slabLo || q.slabLo > p.slabHi || q.crossHi < p.crossLo || q.crossLo > p.crossHi)
+				continue;
+			if (slabOf(std::max(p.slabLo, q.slabLo)) != s)
+				continue;
+			pairs.emplace_back(std::min(p.ball, q.ball), std::max(p.ball, q.ball));
+		}
+	}
+}
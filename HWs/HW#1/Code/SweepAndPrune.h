@@ -0,0 +1,54 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include <vector>
+#include <utility>
+#include <cmath>
+
+// broad phase for ball against ball, the swept bounds of every ball over a step are sorted along
+// one axis and a sweep reports the pairs whose bounds overlap on all three axes
+// the order of the previous step is kept and fixed with an insertion sort, balls move little
+// between steps so that is close to linear instead of a full sort
+// a single sorted list makes every ball test all the balls level with it on the sweep axis, so
+// space is first cut in slabs along a second axis, each slab keeps its own sorted list of the
+// boxes reaching into it and is swept on its own
+class SweepAndPrune {
+
+public:
+	// start and end positions of the step as x, y, z arrays
+	void findPairs(const float* const start[3], const float* const end[3], const float* radius, int count,
+		std::vector<std::pair<int, int>>& pairs);
+
+	int lastSwaps() const { return swaps; } // insertion sort moves of the last step
+
+private:
+	// swept bounds on the sweep axis, the slab axis and the remaining one
+	struct Box {
+		float lo, hi;
+		float slabLo, slabHi;
+		float crossLo, crossHi;
+		int ball;
+	};
+
+	void chooseAxes(const float* const start[3], const float* const end[3], int count);
+	int slabOf(float x) const { return (int)std::floor(x / slabWidth); }
+	void rebuild(int count, int lowest, int highest);
+	void update(int count);
+	void sweep(const std::vector<Box>& list, int s, std::vector<std::pair<int, int>>& pairs) const;
+
+	// copies of the boxes sorted by lo, list k holds slab firstSlab + k, the sweep reads them in order
+	std::vector<std::vector<Box>> slabs;
+	int firstSlab = 0;
+	bool sorted = false; // lists are from an earlier step, false after an axis, the width or the count changed
+
+	std::vector<Box> boxes; // by ball index
+	std::vector<int> spanFirst, spanLast; // slabs each box reaches into
+	std::vector<std::pair<int, int>> entering; // ball and slab it reaches into since this step
+
+	int sweepAxis = -1;
+	int slabAxis = -1;
+	float slabWidth = 0.0f;
+	int swaps = 0;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "VertexBuffer.h"
+#include <glad/glad.h>
+
+VertexBuffer::VertexBuffer(const void* data, unsigned int size) : capacity(size), size(size)
+{
+	glGenBuffers(1, &rendererID);
+	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
+	glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
+}
+
+VertexBuffer::~VertexBuffer()
+{
+	glDeleteBuffers(1, &rendererID);
+}
+
+void VertexBuffer::Bind() const
+{
+	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
+}
+
+void VertexBuffer::Unbind() const
+{
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// the buffer name stays the same when it grows, so vertex array state pointing at it stays valid
+void VertexBuffer::UpdateData(const void* data, unsigned int size)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
+	if (size > capacity) {
+		capacity = size > 2 * capacity ? size : 2 * capacity;
+		glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_DYNAMIC_DRAW);
+	}
+	if (size > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+	this->size = size;
+}
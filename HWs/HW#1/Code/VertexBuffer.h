@@ -0,0 +1,21 @@
+#pragma once
+
+// array buffer that keeps its storage, updates that fit are written in place and
+// larger ones grow the storage geometrically so repeated uploads stop reallocating
+class VertexBuffer {
+
+private: 
+	unsigned int rendererID;
+	unsigned int capacity; // bytes
+	unsigned int size; // bytes of valid data
+public:
+	VertexBuffer(const void* data, unsigned int size);
+	~VertexBuffer();
+
+	void Bind() const;
+	void Unbind() const;
+	void UpdateData(const void* data, unsigned int size);
+
+	inline unsigned int getSize() const { return size; }
+	inline unsigned int getCapacity() const { return capacity; }
+};
@@ -4,6 +4,10 @@
 #include <string>
 #include <chrono>
 #include <random>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <cstdlib>
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -17,9 +21,17 @@
 #include <glm/gtc/random.hpp>
 #include <cmath>
 #include "shader.h"
+#include "CameraBuffer.h"
 #include "Sphere.h"
+#include "BallSystem.h"
+#include "MeshBuffer.h"
+#include "Scene.h"
+#include "Sweep.h"
+#include "Profiler.h"
+#include "GLContext.h"
+#include "CameraPath.h"
 
-int main();
+int main(int argc, char** argv);
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -43,100 +55,43 @@ float deltaTimeFrame = .0f;
 float lastFrame = .0f;
 bool timeToSimulate = false;
 
-struct state {
-    float m;
-    glm::vec3 position;
-    glm::vec3 velocity;
-    float windFactor;
-    glm::vec3 wind;
-    float airResistanceFactor;
-    glm::vec3 gravity;
-};
-
-void setInitConditions(state& cur, state& init) {
-    cur = init;
-}
-
-void setAcceleration(state& curState, glm::vec3& acc) {
-    glm::vec3 gravity = curState.m * curState.gravity;
-    glm::vec3 airResistance = -curState.airResistanceFactor * curState.velocity;
-    glm::vec3 totalForce = gravity + curState.windFactor * curState.wind + airResistance;
-    acc = totalForce / curState.m;
-}
-
-void integrate(state& curState, state& nextState, glm::vec3& acc, float& h) {
-    nextState.m = curState.m;
-    nextState.airResistanceFactor = curState.airResistanceFactor;
-    nextState.gravity = curState.gravity;
-    nextState.wind = curState.wind;
-    nextState.windFactor = curState.windFactor;
-    nextState.velocity = curState.velocity + acc * h;
-    nextState.position = curState.position + curState.velocity * h;
-}
-
-bool checkCollision(state& curState, state& nextState, const float radius, const float cubeSize, glm::vec3& hitNormal) {
-    float hitPoint = (cubeSize / 2) - radius;
-    if (nextState.position.x > hitPoint) {
-        hitNormal = glm::vec3(-1.0, 0.0, 0.0);
-    }
-    else if (nextState.position.x < -hitPoint) {
-        hitNormal = glm::vec3(1.0, 0.0, 0.0);
-    }
-    else if (nextState.position.y > hitPoint) {
-        hitNormal = glm::vec3(0.0, -1.0, 0.0);
-    }
-    else if (nextState.position.y < -hitPoint) {
-        hitNormal = glm::vec3(0.0, 1.0, 0.0);
-    }
-    else if (nextState.position.z > hitPoint) {
-        hitNormal = glm::vec3(0.0, 0.0, -1.0);
-    }
-    else if (nextState.position.z < -hitPoint) {
-        hitNormal = glm::vec3(0.0, 0.0, 1.0);
-    }
-    else { return false; }
-    return true;
-}
-
-void findFraction(state& curState, state& nextState, const float radius, const float cubeSize, float& fraction) {
-    float hitPoint = (cubeSize / 2) - radius;
-    float curHeight;
-    if (abs(nextState.position.x) > hitPoint) {
-        curHeight = hitPoint - abs(curState.position.x);
-        fraction = curHeight / (nextState.position.x - curState.position.x);
-    }
-    else if (abs(nextState.position.y) > hitPoint) {
-        curHeight = hitPoint - abs(curState.position.y);
-        fraction = curHeight / (nextState.position.y - curState.position.y);
-    }
-    else if (abs(nextState.position.z) > hitPoint) {
-        curHeight = hitPoint - abs(curState.position.z);
-        fraction = curHeight / (nextState.position.z - curState.position.z);
-    }
-#ifdef _DEBUG
-    printf("Current Distance from Surface: %f, fraction time: %f\n", curHeight, fraction);
-#endif // DEBUG
-
-
+// runs the scene without a window and prints where the first ball ended up
+// with events the same span of time is covered by one event driven advance
+int runHeadless(const BallScene& scene, int steps, int count, bool events) {
+    BallSystem balls;
+    balls.reset(scene, count);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (events)
+        balls.advance(scene, (double)steps * scene.timestep);
+    else
+        for (int i = 0; i < steps; i++)
+            balls.step(scene);
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    glm::vec3 p = balls.position(0);
+    glm::vec3 v = balls.velocity(0);
+    printf("steps: %d balls: %d time: %.3f ms (%.3f ms per step) sim time: %.3f\n", steps, balls.size(), ms, ms / std::max(steps, 1), balls.t);
+    printf("position: %f %f %f velocity: %f %f %f resting: %d awake: %d\n", p.x, p.y, p.z, v.x, v.y, v.z, balls.resting[0], balls.awake);
+    if (events)
+        printf("events: %d\n", balls.events);
+    else
+        printf("pairs: %d candidates %d contacts %d sort moves in the last step\n", balls.candidates, balls.contacts, balls.sortMoves());
+    return 0;
 }
 
-void collResponse(state& collState, state& nextState, glm::vec3 hitNormal, float& elas, float& mu) {
-    nextState.position = collState.position;
-    glm::vec3 VN = hitNormal * glm::dot(collState.velocity, hitNormal);
-    glm::vec3 VT = collState.velocity - VN;
-    glm::vec3 nextVT = VT;
-    if (glm::length(VT) > 0.01)
-        glm::vec3 nextVT = VT - glm::normalize(VT) * fmin(mu * glm::length(VN), glm::length(VT));
-    glm::vec3 nextVN = -elas * VN;
-
-#ifdef _DEBUG
-    printf("    VT: %f,%f,%f\n", VT.x, VT.y, VT.z);
-    printf("    VN: %f,%f,%f\n", VN.x, VN.y, VN.z);
-    printf("    Next VT: %f,%f,%f\n", nextVT.x, nextVT.y, nextVT.z);
-    printf("    Next VN: %f,%f,%f\n", nextVN.x, nextVN.y, nextVN.z);
-#endif // _DEBUG
-
-    nextState.velocity = nextVT + nextVN;
+// runs every scenario of a sweep file and writes one csv row per scenario
+int runSweepFile(const char* sweepPath, const char* outPath, int threads) {
+    Sweep sweep;
+    if (!loadSweep(sweepPath, sweep))
+        return -1;
+    std::vector<SweepResult> results;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    runSweep(sweep, threads, results);
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    int rested = 0;
+    for (const SweepResult& r : results)
+        rested += r.timeToRest >= 0.0f;
+    printf("scenarios: %d time: %.3f ms rested: %d\n", (int)results.size(), ms, rested);
+    return writeSweepCsv(outPath, sweep, results) ? 0 : -1;
 }
 
 void generateWireframeCube(float cubeSize, float* vertices) {
@@ -190,75 +145,109 @@ void processInput(GLFWwindow* window)
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 
-int main() {
-
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // opengl version 3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); //opengil version 3.3
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); //using core profile of opengl
-    //glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-
-    GLFWwindow* window = glfwCreateWindow(1920, 1080, "LearnOpenGL", NULL, NULL);
-    //glfwSetWindowMonitor(window, glfwGetPrimaryMonitor(), 0, 0, 1920, 1080, GLFW_DONT_CARE);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+int main(int argc, char** argv) {
+
+    // main [scene.json] [--headless] [--steps N] [--balls N] [--events]
+    // main --sweep sweep.json [--out results.csv] [--threads N]
+    // main [scene.json] [--backend window|egl|osmesa] [--size WxH] [--bench N] [--camera fixed|orbit|dolly]
+    const char* scenePath = nullptr;
+    const char* sweepPath = nullptr;
+    const char* outPath = "sweep.csv";
+    int threads = 0; // every core
+    bool headless = false;
+    bool headlessEvents = false;
+    int headlessSteps = 1000;
+    int ballCount = 0; // 0 keeps the count of the scene
+    int backend = CONTEXT_WINDOW;
+    int size[2] = { 1920, 1080 };
+    int benchFrames = 0; // 0 runs until the window is closed
+    CameraPath cameraPath;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+            headlessSteps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc)
+            ballCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--events") == 0)
+            headlessEvents = true;
+        else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc)
+            sweepPath = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            backend = GLContext::parseBackend(argv[++i]);
+            if (backend < 0) {
+                std::cout << "ERROR: Unknown Backend: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &size[0], &size[1]) != 2 || size[0] <= 0 || size[1] <= 0) {
+                std::cout << "ERROR: Invalid Size: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+            benchFrames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--camera") == 0 && i + 1 < argc) {
+            cameraPath.type = CameraPath::parse(argv[++i]);
+            if (cameraPath.type < 0) {
+                std::cout << "ERROR: Unknown Camera Path: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else
+            scenePath = argv[i];
+    }
+    if (sweepPath)
+        return runSweepFile(sweepPath, outPath, threads);
+    BallScene scene;
+    if (scenePath && !loadScene(scenePath, scene)) {
+        if (headless)
+            return -1;
+        scene = BallScene();
+    }
+    if (ballCount > 0)
+        scene.count = ballCount;
+    if (headless)
+        return runHeadless(scene, headlessSteps, scene.count, headlessEvents);
+
+    // without a display there is nothing to close, the offscreen backends always run a benchmark
+    if (backend != CONTEXT_WINDOW && benchFrames <= 0)
+        benchFrames = 600;
+
+    // the preset buttons, one per file in the scenes folder
+    std::vector<BallScene> presets;
+    for (const std::string& path : listScenes("../../../HWs/HW#1/Code/scenes")) {
+        BallScene preset;
+        if (loadScene(path, preset))
+            presets.push_back(preset);
     }
-    glfwMakeContextCurrent(window);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    std::unique_ptr<GLContext> context = GLContext::create(backend, size[0], size[1], "LearnOpenGL");
+    if (!context)
         return -1;
+    GLFWwindow* window = context->window();
+    if (window) {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     }
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    glViewport(0, 0, 1920, 1080);
+    glViewport(0, 0, size[0], size[1]);
     int dims[2] = { 32, 64 };
-    float radius = .5f;
-    Sphere ball = Sphere(dims[0], dims[1], true, radius);
-
-    unsigned int VAO_sphere;
-    glGenVertexArrays(1, &VAO_sphere);
-
-    unsigned int VBO_pos;
-    glGenBuffers(1, &VBO_pos);
-
-    unsigned int VBO_normal;
-    glGenBuffers(1, &VBO_normal);
-
-    unsigned int EBO;
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO_sphere);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-    glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-    glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    float& radius = scene.radius;
+    // the ball is drawn from a chain of unit sphere levels scaled by its radius
+    SphereCache spheres;
+    spheres.setLevels(dims[0], dims[1], true);
 
     // TODO: add a plane at the bottom
-    unsigned int VAO_plane;
-    glGenVertexArrays(1, &VAO_plane);
 
     float planeVertices[] = {
         100.0f,100.0f,0.0f,
@@ -278,49 +267,34 @@ int main() {
         .0f,.0f,1.0f
     };
 
-    unsigned int VBO_pos_p;
-    glGenBuffers(1, &VBO_pos_p);
-
-    unsigned int VBO_normal_p;
-    glGenBuffers(1, &VBO_normal_p);
-
-    glBindVertexArray(VAO_plane);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_pos_p);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), &planeVertices[0], GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_p);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeNormal), &planeNormal[0], GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    MeshBuffer plane;
+    plane.AddAttribute(0, 3, planeVertices, sizeof(planeVertices));
+    plane.AddAttribute(1, 3, planeNormal, sizeof(planeNormal));
 
-
-    unsigned int VAO_cube;
-    glGenVertexArrays(1, &VAO_cube);
-
-    unsigned int VBO_cube;
-    glGenBuffers(1, &VBO_cube);
-
-    glBindVertexArray(VAO_cube);
-
-
-    float cubeSize = 10.0f;
+    float& cubeSize = scene.cubeSize;
     float  cubevertices[48];
     generateWireframeCube(cubeSize, cubevertices);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    MeshBuffer cube;
+    int cubePositions = cube.AddAttribute(0, 3, cubevertices, sizeof(cubevertices));
 
     Shader primitiveShader("../../../HWs/HW#1/Code/shaders/vertex_shader_prim.glsl", "../../../HWs/HW#1/Code/shaders/fragment_shader_prim.glsl");
     Shader sperspective("../../../HWs/HW#1/Code/shaders/vert.glsl", "../../../HWs/HW#1/Code/shaders/frag.glsl");
     Shader fperspective("../../../HWs/HW#1/Code/shaders/vert_flat.glsl", "../../../HWs/HW#1/Code/shaders/frag_flat.glsl");
+    // the balls are instances, center and radius come from a per instance attribute
+    Shader sinstanced("../../../HWs/HW#1/Code/shaders/vert_instanced.glsl", "../../../HWs/HW#1/Code/shaders/frag.glsl");
+    Shader finstanced("../../../HWs/HW#1/Code/shaders/vert_flat_instanced.glsl", "../../../HWs/HW#1/Code/shaders/frag_flat.glsl");
+
+    // the camera is uploaded once per frame into a buffer all programs read
+    CameraBuffer camera;
+    for (Shader* s : { &sperspective, &fperspective, &sinstanced, &finstanced })
+        s->bindBlock(CAMERA_BLOCK, CAMERA_BINDING);
+
+    // uniform locations are resolved once, the draw loop only sets values
+    // both programs declare model, the handle of the bound one is used
+    Uniform<glm::mat4> smoothModel = sperspective.uniform<glm::mat4>("model");
+    Uniform<glm::mat4> flatModel = fperspective.uniform<glm::mat4>("model");
+    bool flatShading = false;
 
     sperspective.use();
 
@@ -334,562 +308,232 @@ int main() {
 
 
     int width, height;
-    float h = 0.01f;
-    float f;
-    float t = 0.0f;
+    float& h = scene.timestep;
     float t_max = 120.0f;
-    state curState;
-    state nextState;
-    state collState;
-
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    ImGui::StyleColorsDark();
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 330");
-
-    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-
-    state init;
-    init.m = 1.0f;
-    init.airResistanceFactor = 0;
-    init.gravity = glm::vec3(0.0, 0.0, -10.0);
-    init.position = glm::vec3(0.0, 0.0, 3.0);
-    init.velocity = glm::vec3(0.0, 0.0, 0.0);
-    init.wind = glm::vec3(0.0, 0.0, 0.0);
-    init.windFactor = 0;
-
-    float timestep = h;
-    setInitConditions(curState, init);
+
+    // the gui is left out of benchmarks, it would be most of what a small scene draws
+    bool gui = window && benchFrames == 0;
+    if (gui) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO(); (void)io;
+        ImGui::StyleColorsDark();
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init("#version 330");
+
+        io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    }
+
+    BallSystem balls;
+    balls.reset(scene, scene.count);
+    // balls of every sphere level, refilled each frame and drawn with one call per level
+    std::vector<std::vector<glm::vec4>> lodInstances;
     bool stepSim = false;
+    bool eventDriven = false; // advance from wall impact to wall impact, balls pass through each other
     float timeToDraw = 0.0f;
     glm::vec3 posBuf;
 
-    float elas = 0.1f;
-    float mu = 0.4f;
+    float& elas = scene.elas;
+    float& mu = scene.mu;
+    float& restVelocity = scene.restVelocity;
+    int& restStepCount = scene.restSteps;
     std::chrono::steady_clock::time_point t_sim = std::chrono::steady_clock::now();
-    while (!glfwWindowShouldClose(window))
+    Profiler& profiler = Profiler::get();
+    profiler.initGpu();
+
+    // a benchmark steps the simulation once per frame with the camera on a path around the cube,
+    // so every run draws the same frames, each frame waits for the gpu so its time includes the draw
+    int frameIndex = 0;
+    if (benchFrames > 0) {
+        timeToSimulate = true;
+        cameraPath.fit(glm::vec3(-cubeSize / 2), glm::vec3(cubeSize / 2));
+    }
+    std::chrono::steady_clock::time_point benchStart = std::chrono::steady_clock::now();
+
+    while (!context->closing() && (benchFrames <= 0 || frameIndex < benchFrames))
     {
-        // time handling for input, should not interfere with this
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTimeFrame = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        processInput(window);
+        profiler.beginFrame();
+        if (window) {
+            // time handling for input, should not interfere with this
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTimeFrame = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+        }
+        if (benchFrames > 0)
+            cameraPath.frame(frameIndex, camPos, camFront);
 
         glClearColor(0.6f, 1.0f, 0.9f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         //start of imgui init stuff
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
+        if (gui) {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+        }
         //end of imgui init stuff
 
         glm::mat4 view = glm::lookAt(camPos, camPos + camFront, camUp);
-        sperspective.setMat4("view", view);
 
-        glfwGetWindowSize(window, &width, &height);
+        context->getSize(width, height);
 
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 400.0f);
-        sperspective.setMat4("projection", projection);
-
-        glBindVertexArray(VAO_plane);
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, -cubeSize / 2));
-        glUniformMatrix4fv(glGetUniformLocation(sperspective.ID, "model"), 1, GL_FALSE, &model[0][0]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        glBindVertexArray(VAO_sphere);
-        model = glm::mat4(1.0f);
-
-        model = glm::translate(model, curState.position);
-        sperspective.setMat4("model", model);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ball.indices.size()), GL_UNSIGNED_INT, 0);
-
-        model = glm::mat4(1.0f);
-        sperspective.setMat4("model", model);
-
-        glBindVertexArray(VAO_cube);
-        glDrawArrays(GL_LINE_STRIP, 0, 16);
-
-        // all drawings done lets do some imgui stuff
-
-        ImGui::Begin("Object Settings");
-        bool sliderDim = ImGui::SliderInt2("Stacks and Sectors", dims, 3, 128);
-        bool sliderRad = ImGui::SliderFloat("Radius", &radius, .01f, 20.f);
-        bool sliderCube = ImGui::SliderFloat("Cube Size", &cubeSize, .01f, 20.f);
-        ImGui::End();
-
-        ImGui::Begin("Render Setting");
-        bool sliderPS = ImGui::SliderFloat("Point Size", &pointSize, .01f, 10.0f);
-        bool sliderLS = ImGui::SliderFloat("Line Size", &lineSize, .01f, 10.0f);
-        if (ImGui::Button("Flat Shading")) {
-            fperspective.use();
-        }
-        if (ImGui::Button("Smooth Shading")) {
-            sperspective.use();
-        }
-        ImGui::End();
-
-        ImGui::Begin("Simulation Setting");
-        if (ImGui::Button("Start/Pause Simulation")) {
-            timeToSimulate = !timeToSimulate;
-            stepSim = false;
-        }
-        if (ImGui::Button("Step Simulation")) {
-            stepSim = true;
-        }
-        if (ImGui::Button("Reset")) {
-            setInitConditions(curState, init);
-            t = 0;
-            t_sim = std::chrono::steady_clock::now();
-        }
-        ImGui::Text("Integration");
-        ImGui::SliderFloat("Timestep", &h, .005f, 0.5f);
-        ImGui::Text("Initial Conditions");
-        ImGui::InputFloat("Mass", &init.m);
-        ImGui::InputFloat3("Gravity", glm::value_ptr(init.gravity));
-        ImGui::InputFloat3("Position", glm::value_ptr(init.position));
-        ImGui::InputFloat3("Velocity", glm::value_ptr(init.velocity));
-        ImGui::InputFloat3("Wind", glm::value_ptr(init.wind));
-        ImGui::InputFloat("Wind Factor", &init.windFactor);
-        ImGui::InputFloat("Air Resistance Factor", &init.airResistanceFactor);
-        ImGui::InputFloat("Elasticity", &elas);
-        ImGui::InputFloat("Friction", &mu);
-        if (ImGui::Button("Randomize")) {
-            cubeSize = glm::linearRand(0.1f, 30.0f);
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = glm::linearRand(0.01f, cubeSize / 5.0f);
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.position = glm::ballRand<float>(cubeSize / 2.0f);
-            init.velocity = glm::ballRand<float>(5.0f);
-            init.wind = glm::ballRand<float>(5.0f);
-            init.airResistanceFactor = glm::linearRand(0.0f, 1.0f);
-            init.windFactor = glm::linearRand(0.0f, 1.0f);
-            elas = glm::linearRand(0.0f, 1.0f);
-            mu = glm::linearRand(0.0f, 1.0f);
-            setInitConditions(curState, init);
-        }
-        if (ImGui::Button("Bottom Collision")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, 0.0f, -10.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 3.0f);
-            init.velocity = glm::vec3(0.0f);
-            init.wind = glm::vec3(0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
-        if (ImGui::Button("Top Collision")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, 0.0f, 10.0f);
-            init.position = glm::vec3(0.0f, 0.0f, -3.0f);
-            init.velocity = glm::vec3(0.0f);
-            init.wind = glm::vec3(0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
-
-        if (ImGui::Button("Side 1 Collision")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, 10.0f, 0.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 3.0f);
-            init.velocity = glm::vec3(0.0f);
-            init.wind = glm::vec3(0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
+        camera.update(view, projection, camPos, (float)width, (float)height, 0.1f, 400.0f);
 
-        if (ImGui::Button("Side 2 Collision")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(10.0f, 0.0f, 0.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 3.0f);
-            init.velocity = glm::vec3(0.0f);
-            init.wind = glm::vec3(0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
-
-        if (ImGui::Button("Side 3 Collision")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, -10.0f, 0.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 3.0f);
-            init.velocity = glm::vec3(0.0f);
-            init.wind = glm::vec3(0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
+        {
+            PROFILE_GPU_SCOPE("Draw");
+            const Uniform<glm::mat4>& modelUniform = flatShading ? flatModel : smoothModel;
+            (flatShading ? fperspective : sperspective).use();
+            plane.Bind();
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(0.0f, 0.0f, -cubeSize / 2));
+            modelUniform.set(model);
+            glDrawArrays(GL_TRIANGLES, 0, plane.getCount());
+
+            model = glm::mat4(1.0f);
+            modelUniform.set(model);
+
+            cube.Bind();
+            glDrawArrays(GL_LINE_STRIP, 0, cube.getCount());
+
+            lodInstances.resize(spheres.levelCount());
+            for (auto& level : lodInstances)
+                level.clear();
+            for (int i = 0; i < balls.size(); i++) {
+                glm::vec3 p = balls.position(i);
+                int lod = spheres.selectLevel(balls.radius[i], glm::length(p - camPos), glm::radians(45.0f), (float)height);
+                lodInstances[lod].push_back(glm::vec4(p, balls.radius[i]));
+            }
+            (flatShading ? finstanced : sinstanced).use();
+            for (int lod = 0; lod < spheres.levelCount(); lod++)
+                spheres.drawInstanced(lod, lodInstances[lod]);
         }
 
-        if (ImGui::Button("Side 4 Collision")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(-10.0f, 0.0f, 0.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 3.0f);
-            init.velocity = glm::vec3(0.0f);
-            init.wind = glm::vec3(0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
+        // all drawings done lets do some imgui stuff
 
-        if (ImGui::Button("Wind")) {
-            cubeSize = 40.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, 0.0f, 0.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 0.0f);
-            init.velocity = glm::vec3(0.0f, 0.0f, 4.0f);
-            init.wind = glm::vec3(3.0f, 1.0f, 0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 1.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
-        if (ImGui::Button("Air Resistance")) {
-            cubeSize = 40.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 2.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, 0.0f, 0.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 0.0f);
-            init.velocity = glm::vec3(0.0f, 0.0f, 4.0f);
-            init.wind = glm::vec3(0.0f, 0.0f, 0.0f);
-            init.airResistanceFactor = 0.2f;
-            init.windFactor = 0.0f;
-            elas = 0.7f;
-            mu = 0.1f;
-            setInitConditions(curState, init);
-        }
+        bool sliderDim = false;
+        bool sliderRad = false;
+        bool sliderCube = false;
+        bool sliderPS = false;
+        bool sliderLS = false;
+        bool shadingChanged = false;
+        bool sceneChanged = false;
+        if (gui) {
+            ImGui::Begin("Object Settings");
+            sliderDim = ImGui::SliderInt2("Stacks and Sectors", dims, 3, 128);
+            sliderRad = ImGui::SliderFloat("Radius", &radius, .01f, 20.f);
+            sliderCube = ImGui::SliderFloat("Cube Size", &cubeSize, .01f, 20.f);
+            ImGui::End();
+
+            ImGui::Begin("Render Setting");
+            sliderPS = ImGui::SliderFloat("Point Size", &pointSize, .01f, 10.0f);
+            sliderLS = ImGui::SliderFloat("Line Size", &lineSize, .01f, 10.0f);
+            if (ImGui::Button("Flat Shading")) {
+                flatShading = true;
+                shadingChanged = true;
+            }
+            if (ImGui::Button("Smooth Shading")) {
+                flatShading = false;
+                shadingChanged = true;
+            }
+            ImGui::End();
 
-        if (ImGui::Button("Example Case 1")) {
-            cubeSize = 20.0f;
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            radius = 3.0f;
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-
-            init.gravity = glm::vec3(0.0f, 0.0f, -10.0f);
-            init.position = glm::vec3(0.0f, 0.0f, 5.0f);
-            init.velocity = glm::vec3(30.0f, 40.0f, 4.0f);
-            init.wind = glm::vec3(0.0f, 0.0f, 0.0f);
-            init.airResistanceFactor = 0.0f;
-            init.windFactor = 0.0f;
-            elas = 0.6f;
-            mu = 0.8f;
-            setInitConditions(curState, init);
+            ImGui::Begin("Simulation Setting");
+            if (ImGui::Button("Start/Pause Simulation")) {
+                timeToSimulate = !timeToSimulate;
+                stepSim = false;
+            }
+            if (ImGui::Button("Step Simulation")) {
+                stepSim = true;
+            }
+            if (ImGui::Button("Reset")) {
+                balls.reset(scene, scene.count);
+                t_sim = std::chrono::steady_clock::now();
+            }
+            ImGui::Text("Integration");
+            ImGui::SliderFloat("Timestep", &h, .005f, 0.5f);
+            ImGui::Checkbox("Event Driven", &eventDriven);
+            ImGui::Text("Initial Conditions");
+            ImGui::InputInt("Balls", &scene.count);
+            ImGui::InputFloat("Mass", &scene.m);
+            bool forcesChanged = ImGui::InputFloat3("Gravity", glm::value_ptr(scene.gravity));
+            ImGui::InputFloat3("Position", glm::value_ptr(scene.position));
+            ImGui::InputFloat3("Velocity", glm::value_ptr(scene.velocity));
+            forcesChanged |= ImGui::InputFloat3("Wind", glm::value_ptr(scene.wind));
+            forcesChanged |= ImGui::InputFloat("Wind Factor", &scene.windFactor);
+            forcesChanged |= ImGui::InputFloat("Air Resistance Factor", &scene.airResistanceFactor);
+            if (forcesChanged)
+                balls.setForces(scene);
+            ImGui::InputFloat("Elasticity", &elas);
+            ImGui::InputFloat("Friction", &mu);
+            ImGui::InputFloat("Rest Velocity", &restVelocity);
+            ImGui::InputInt("Rest Steps", &restStepCount);
+            ImGui::Text("%d of %d balls moving, t = %.2f", balls.awake, balls.size(), balls.t);
+            if (eventDriven)
+                ImGui::Text("%d events", balls.events);
+            else
+                ImGui::Text("%d candidate pairs, %d contacts", balls.candidates, balls.contacts);
+            if (ImGui::Button("Randomize")) {
+                cubeSize = glm::linearRand(0.1f, 30.0f);
+                radius = glm::linearRand(0.01f, cubeSize / 5.0f);
+                scene.position = glm::ballRand<float>(cubeSize / 2.0f - radius);
+                scene.velocity = glm::ballRand<float>(5.0f);
+                scene.wind = glm::ballRand<float>(5.0f);
+                scene.airResistanceFactor = glm::linearRand(0.0f, 1.0f);
+                scene.windFactor = glm::linearRand(0.0f, 1.0f);
+                elas = glm::linearRand(0.0f, 1.0f);
+                mu = glm::linearRand(0.0f, 1.0f);
+                balls.reset(scene, scene.count);
+                sceneChanged = true;
+            }
+            for (int i = 0; i < (int)presets.size(); i++) {
+                ImGui::PushID(i);
+                if (ImGui::Button(presets[i].name)) {
+                    scene = presets[i];
+                    balls.reset(scene, scene.count);
+                    sceneChanged = true;
+                }
+                ImGui::PopID();
+            }
+            ImGui::End();
         }
 
-        ImGui::End();
-
         //TODO: Simulation Part
         // first determine whether it is time to simulate by checking t and now
         std::chrono::duration<float> secPassed = std::chrono::steady_clock::now() - t_sim;
         //printf("Second Passed from last sim: %f\n ,simTime in sim: %f\n", secPassed, t);
 
-        if (secPassed.count() >= h && (timeToSimulate || stepSim)) {
+        if ((benchFrames > 0 || secPassed.count() >= h) && (timeToSimulate || stepSim)) {
 #ifdef _DEBUG
             //printf("simulating, Time: %f, t_sim: %f, deltaFrameTime: %f\n", t, t_sim.time_since_epoch(), deltaTimeFrame);
-            //printf("    Current Pos: %f, %f, %f     Current Velocity: %f, %f, %f",curState.position.x, curState.position.y, curState.position.z, curState.velocity.x, curState.velocity.y, curState.velocity.z);
-#endif // _DEBUG
-
-            glm::vec3 acc_ball = glm::vec3(0.0, 0.0, 0.0);
-            setAcceleration(curState, acc_ball);
-
-            timestep = h;
-            integrate(curState, nextState, acc_ball, timestep);
-
-            glm::vec3 hitNormal = glm::vec3(1.0, 0.0, 0.0);
-
-            if (checkCollision(curState, nextState, radius, cubeSize, hitNormal)) { //for checking collision we can create a collider class with taking vertices of the shape
-                findFraction(curState, nextState, radius, cubeSize, f);
-                timestep = f * h;
-                integrate(curState, collState, acc_ball, timestep);
-
-#ifdef _DEBUG
-                printf("There is a collision at: %f,%f,%f, fraction timestep: %f\n", collState.position.x, collState.position.y, collState.position.z, f);
 #endif // _DEBUG
 
-                collResponse(collState, nextState, hitNormal, elas, mu);
-                t += timestep;
-            }
-            else {
-                t += timestep;
+            {
+                PROFILE_SCOPE("Simulate");
+                if (eventDriven)
+                    balls.advance(scene, h);
+                else
+                    balls.step(scene);
             }
-            curState = nextState;
             stepSim = false;
             t_sim = std::chrono::steady_clock::now();
         }
 
-        if (sliderDim || sliderRad) {
-            ball.setDims(dims[0], dims[1], radius);
-
-            glBindVertexArray(VAO_sphere);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_pos);
-            glBufferData(GL_ARRAY_BUFFER, ball.vertices.size() * sizeof(float), &ball.vertices[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_normal);
-            glBufferData(GL_ARRAY_BUFFER, ball.normals.size() * sizeof(float), &ball.normals[0], GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, ball.indices.size() * sizeof(float), &ball.indices[0], GL_DYNAMIC_DRAW);
-        }
+        if (sliderRad || sliderCube)
+            balls.setRadius(radius);
 
-        if (sliderCube) {
-            generateWireframeCube(cubeSize, cubevertices);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(cubevertices), cubevertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(0);
+        {
+            PROFILE_GPU_SCOPE("Upload");
+            // the radius is only a scale, a new tessellation builds the levels it is missing
+            if (sliderDim || shadingChanged)
+                spheres.setLevels(dims[0], dims[1], !flatShading);
+
+            if (sliderCube || sceneChanged) {
+                generateWireframeCube(cubeSize, cubevertices);
+                // same size every time, written in place
+                cube.UpdateAttribute(cubePositions, cubevertices, sizeof(cubevertices));
+            }
         }
 
         if (sliderPS) {
@@ -899,22 +543,37 @@ int main() {
             glLineWidth(lineSize);
         }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (gui) {
+            profiler.gui();
+
+            PROFILE_GPU_SCOPE("ImGui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        context->present();
+        if (benchFrames > 0)
+            glFinish();
+        profiler.endFrame();
+        frameIndex++;
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (benchFrames > 0) {
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - benchStart).count();
+        printf("backend: %s size: %dx%d renderer: %s\n", GLContext::backendName(context->getBackend()), width, height, (const char*)glGetString(GL_RENDERER));
+        printf("frames: %d time: %.3f ms (%.2f fps) balls: %d\n", frameIndex, ms, frameIndex > 0 ? 1000.0f * frameIndex / ms : 0.0f, balls.size());
+        profiler.printSummary();
     }
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    profiler.shutdownGpu();
 
-    glDeleteVertexArrays(1, &VAO_sphere);
-    glDeleteBuffers(1, &VBO_pos);
-    glDeleteBuffers(1, &VBO_normal);
+    if (gui) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
-    glfwTerminate();
+    spheres.clear();
 
     return 0;
 }
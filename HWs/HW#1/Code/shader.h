@@ -9,6 +9,38 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+
+// GL type a uniform handle of type T expects
+template <typename T> struct UniformType;
+template <> struct UniformType<bool> { static const GLenum gl = GL_BOOL; };
+template <> struct UniformType<int> { static const GLenum gl = GL_INT; };
+template <> struct UniformType<float> { static const GLenum gl = GL_FLOAT; };
+template <> struct UniformType<glm::vec3> { static const GLenum gl = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static const GLenum gl = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::mat4> { static const GLenum gl = GL_FLOAT_MAT4; };
+
+// location of a uniform resolved once, setting it is a single glUniform call on the bound program
+// a handle of a uniform the program does not have is invalid and ignores set like GL does
+template <typename T>
+class Uniform {
+
+public:
+	Uniform() : location(-1) {}
+	explicit Uniform(GLint location) : location(location) {}
+
+	bool valid() const { return location >= 0; }
+	void set(const T& value) const;
+
+	GLint location;
+};
+
+template <> inline void Uniform<bool>::set(const bool& value) const { glUniform1i(location, (int)value); }
+template <> inline void Uniform<int>::set(const int& value) const { glUniform1i(location, value); }
+template <> inline void Uniform<float>::set(const float& value) const { glUniform1f(location, value); }
+template <> inline void Uniform<glm::vec3>::set(const glm::vec3& value) const { glUniform3fv(location, 1, &value[0]); }
+template <> inline void Uniform<glm::vec4>::set(const glm::vec4& value) const { glUniform4fv(location, 1, &value[0]); }
+template <> inline void Uniform<glm::mat4>::set(const glm::mat4& value) const { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
 
 class Shader {
 
@@ -19,12 +51,41 @@ public:
 	~Shader();
 	void use();
 
-	void setBool(const std::string &name, bool value) const;
+	// typed handle of an active uniform, the type is checked against the linked program once here
+	template <typename T>
+	Uniform<T> uniform(const std::string& name) const {
+		auto it = uniforms.find(name);
+		if (it == uniforms.end())
+			return Uniform<T>();
+		if (!typeMatches(it->second.type, UniformType<T>::gl)) {
+			std::cout << "ERROR: Shader Uniform Type Mismatch: " << name << std::endl;
+			return Uniform<T>();
+		}
+		return Uniform<T>(it->second.location);
+	}
+
+	// by name setters look the location up in the reflected table, prefer handles in hot loops
+	void setBool(const std::string& name, bool value) const;
 	void setInt(const std::string& name, int value) const;
 	void setFloat(const std::string& name, float value) const;
-	void setMat4(const std::string& name, glm::mat4 &mat) const;
+	void setMat4(const std::string& name, const glm::mat4& mat) const;
+
+	// GLSL 330 has no binding qualifier, blocks are attached to their binding point here
+	void bindBlock(const char* name, unsigned int binding) const;
+
+private:
+	struct UniformInfo {
+		GLint location;
+		GLenum type;
+		GLint size; // array length, 1 for plain uniforms
+	};
+
+	void reflect();
+	GLint location(const std::string& name) const;
+	static bool typeMatches(GLenum actual, GLenum expected);
+
+	std::unordered_map<std::string, UniformInfo> uniforms;
 
 };
 
 #endif
-
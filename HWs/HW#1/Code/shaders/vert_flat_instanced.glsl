@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec4 aInstance; // center xyz, radius w
+
+// shared by all programs, see CameraBuffer.h
+layout (std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition; // xyz
+	vec4 viewport; // width, height, near, far
+};
+
+flat out vec3 Normal;
+out vec3 fragPos;
+
+void main() {
+	fragPos = aInstance.xyz + aPos * aInstance.w;
+	Normal = aNormal;
+	gl_Position = viewProjection * vec4(fragPos, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "Arena.h"
+
+#include <iostream>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#define ARENA_LARGE_PAGE_MAX ((size_t)256 << 20) // large pages are committed whole, bigger arenas commit as they grow
+#else
+#include <sys/mman.h>
+#endif
+
+void Arena::reserve(size_t capacity) {
+	used = 0;
+	high = 0;
+	size_t rounded = (std::max(capacity, (size_t)1) + ARENA_HUGE_PAGE - 1) / ARENA_HUGE_PAGE * ARENA_HUGE_PAGE;
+	if (rounded <= cap)
+		return;
+	release();
+
+#ifdef _WIN32
+	// large pages need the lock pages in memory privilege, without it ordinary pages are used
+	SIZE_T large = GetLargePageMinimum();
+	if (large && rounded <= ARENA_LARGE_PAGE_MAX && rounded % large == 0) {
+		block = (char*)VirtualAlloc(NULL, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		huge = block != NULL;
+		committed = rounded;
+	}
+	if (!block) {
+		block = (char*)VirtualAlloc(NULL, rounded, MEM_RESERVE, PAGE_READWRITE);
+		committed = 0;
+	}
+	blockSize = rounded;
+	base = block;
+#else
+	// one extra huge page of room so the start can be moved onto a huge page boundary
+	blockSize = rounded + ARENA_HUGE_PAGE;
+	void* p = mmap(NULL, blockSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	block = p == MAP_FAILED ? nullptr : (char*)p;
+	base = block ? (char*)(((uintptr_t)block + ARENA_HUGE_PAGE - 1) & ~(uintptr_t)(ARENA_HUGE_PAGE - 1)) : nullptr;
+#ifdef MADV_HUGEPAGE
+	huge = base && madvise(base, rounded, MADV_HUGEPAGE) == 0;
+#endif
+#endif
+
+	if (!block) {
+		std::cout << "ERROR: Arena Reserve Failed: " << rounded << " bytes" << std::endl;
+		base = nullptr;
+		blockSize = 0;
+		return;
+	}
+	cap = rounded;
+}
+
+void Arena::release() {
+	if (block) {
+#ifdef _WIN32
+		VirtualFree(block, 0, MEM_RELEASE);
+#else
+		munmap(block, blockSize);
+#endif
+	}
+	block = base = nullptr;
+	blockSize = cap = used = high = 0;
+	huge = false;
+#ifdef _WIN32
+	committed = 0;
+#endif
+}
+
+// base is huge page aligned, so aligning the offset aligns the address
+void* Arena::alloc(size_t bytes, size_t align) {
+	size_t start = (used + align - 1) & ~(align - 1);
+	if (start + bytes > cap) {
+		std::cout << "ERROR: Arena Full: " << bytes << " bytes asked, " << cap - used << " left" << std::endl;
+		return nullptr;
+	}
+#ifdef _WIN32
+	if (start + bytes > committed) {
+		size_t grow = std::min((start + bytes + ARENA_HUGE_PAGE - 1) / ARENA_HUGE_PAGE * ARENA_HUGE_PAGE, cap);
+		if (!VirtualAlloc(base + committed, grow - committed, MEM_COMMIT, PAGE_READWRITE)) {
+			std::cout << "ERROR: Arena Commit Failed: " << grow << " bytes" << std::endl;
+			return nullptr;
+		}
+		committed = grow;
+	}
+#endif
+	used = start + bytes;
+	high = std::max(high, used);
+	return base + start;
+}
+
+Arena& Arena::frame() {
+	static Arena arena(ARENA_FRAME_RESERVE);
+	return arena;
+}
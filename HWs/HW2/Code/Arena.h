@@ -0,0 +1,65 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define ARENA_HUGE_PAGE (2u << 20)
+#define ARENA_ALIGN 64 // cache line, every allocation starts on its own
+#define ARENA_FRAME_RESERVE ((size_t)1 << 30) // address space of the frame arena, pages are only backed once touched
+
+// one block of address space handed out front to back, nothing is freed on its own, rewinding
+// to a mark releases everything allocated after it at once
+// the block is a whole number of huge pages on a huge page boundary and the system is asked to
+// back it with huge pages, where it will not the block is ordinary pages
+class Arena {
+
+public:
+	Arena() {}
+	explicit Arena(size_t capacity) { reserve(capacity); }
+	~Arena() { release(); }
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// drops everything, the old block is only given back when the new one has to be larger
+	void reserve(size_t capacity);
+	void release();
+
+	// nullptr when the arena is full, the caller sized it wrong
+	void* alloc(size_t bytes, size_t align = ARENA_ALIGN);
+	template <class T>
+	T* alloc(size_t count) { return (T*)alloc(count * sizeof(T), alignof(T) > ARENA_ALIGN ? alignof(T) : ARENA_ALIGN); }
+
+	size_t mark() const { return used; }
+	void rewind(size_t mark) { used = mark; }
+	void reset() { used = 0; }
+
+	size_t size() const { return used; }
+	size_t capacity() const { return cap; }
+	size_t peak() const { return high; } // most bytes in use at once since the block was reserved
+	bool hugePages() const { return huge; }
+
+	// per frame scratch of the main thread, reset at the start of every frame, so nothing taken
+	// from it may be kept across frames
+	static Arena& frame();
+
+private:
+	char* base = nullptr;
+	char* block = nullptr; // as the system returned it, base is the huge page aligned start inside
+	size_t blockSize = 0;
+	size_t cap = 0;
+	size_t used = 0;
+	size_t high = 0;
+	bool huge = false;
+#ifdef _WIN32
+	size_t committed = 0; // windows backs reserved address space only once it is committed
+#endif
+};
+
+// bytes an arena needs for count values of T after alignment
+template <class T>
+inline size_t arenaBytes(size_t count) {
+	return (count * sizeof(T) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#include "CameraBuffer.h"
+
+#include <glad/glad.h>
+
+CameraBuffer::CameraBuffer() {
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+CameraBuffer::~CameraBuffer() {
+	glDeleteBuffers(1, &ubo);
+}
+
+void CameraBuffer::update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position,
+	float width, float height, float zNear, float zFar) {
+	CameraBlock block;
+	block.view = view;
+	block.projection = projection;
+	block.viewProjection = projection * view;
+	block.position = glm::vec4(position, 1.0f);
+	block.viewport = glm::vec4(width, height, zNear, zFar);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,34 @@
+#ifndef CAMERABUFFER_H
+#define CAMERABUFFER_H
+
+#include <glm/glm.hpp>
+
+#define CAMERA_BLOCK "Camera"
+#define CAMERA_BINDING 0 // uniform buffer binding point of the camera block
+
+// std140 layout of the Camera block in the vertex shaders, every member is 16 byte aligned
+struct CameraBlock {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 position; // xyz
+	glm::vec4 viewport; // width, height, near, far
+};
+
+static_assert(sizeof(CameraBlock) == 224, "CameraBlock must match the std140 layout");
+
+// one uniform buffer holding the camera for all programs, uploaded once per frame
+class CameraBuffer {
+
+public:
+	CameraBuffer();
+	~CameraBuffer();
+
+	void update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position,
+		float width, float height, float zNear, float zFar);
+
+private:
+	unsigned int ubo;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <glm/glm.hpp>
+
+enum CameraPathType {
+	CAMERA_FIXED = 0, // stays where the camera starts
+	CAMERA_ORBIT = 1, // circles the scene above its center
+	CAMERA_DOLLY = 2 // moves in and out along one line through the center
+};
+
+// a camera that is a function of the frame number only, so every run of a render benchmark sees
+// the same views, z is up like the rest of the scene
+struct CameraPath {
+	int type = CAMERA_ORBIT;
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 10.0f;
+	int period = 360; // frames of one orbit or one dolly in and out
+
+	// center and radius from the box, the whole box stays in a 45 degree view
+	void fit(const glm::vec3& lo, const glm::vec3& hi);
+	// leaves pos and front alone for CAMERA_FIXED
+	void frame(int f, glm::vec3& pos, glm::vec3& front) const;
+
+	// "fixed", "orbit" or "dolly", -1 for anything else
+	static int parse(const char* name);
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "Collider.h"
+
+#include <cmath>
+
+void TriangleCollider::build(const TriangleMesh& mesh) {
+	int tris = mesh.triangleCount();
+	v0.resize(tris);
+	e1.resize(tris);
+	e2.resize(tris);
+	n.resize(tris);
+	d.resize(tris);
+	for (int i = 0; i < tris; i++) {
+		const glm::vec3& a = mesh.positions[mesh.indices[3 * i]];
+		const glm::vec3& b = mesh.positions[mesh.indices[3 * i + 1]];
+		const glm::vec3& c = mesh.positions[mesh.indices[3 * i + 2]];
+		v0[i] = a;
+		e1[i] = b - a;
+		e2[i] = c - a;
+		glm::vec3 cr = glm::cross(e1[i], e2[i]);
+		float l = glm::length(cr);
+		n[i] = l > 0.0f ? cr / l : glm::vec3(0.0f);
+		d[i] = glm::dot(n[i], a);
+	}
+	mesh.bounds(bmin, bmax);
+}
+
+bool TriangleCollider::intersect(const glm::vec3& p0, const glm::vec3& p1, float& fraction, glm::vec3& normal, float& planeD) const {
+	// the segment cannot touch anything outside the bounds of the mesh
+	glm::vec3 smin = glm::min(p0, p1);
+	glm::vec3 smax = glm::max(p0, p1);
+	if (smax.x < bmin.x || smax.y < bmin.y || smax.z < bmin.z ||
+		smin.x > bmax.x || smin.y > bmax.y || smin.z > bmax.z)
+		return false;
+
+	bool hit = false;
+	fraction = 1.0f;
+	for (int i = 0; i < (int)n.size(); i++) {
+		float dist0 = glm::dot(n[i], p0) - d[i];
+		float dist1 = glm::dot(n[i], p1) - d[i];
+		if (std::signbit(dist0) == std::signbit(dist1))
+			continue;
+		float f = std::abs(dist0) / (std::abs(dist0) + std::abs(dist1));
+		if (f >= fraction)
+			continue;
+		// barycentric test of the crossing point
+		glm::vec3 q = p0 + (p1 - p0) * f - v0[i];
+		float d00 = glm::dot(e1[i], e1[i]);
+		float d01 = glm::dot(e1[i], e2[i]);
+		float d11 = glm::dot(e2[i], e2[i]);
+		float d20 = glm::dot(q, e1[i]);
+		float d21 = glm::dot(q, e2[i]);
+		float denom = d00 * d11 - d01 * d01;
+		if (denom == 0.0f)
+			continue;
+		float v = (d11 * d20 - d01 * d21) / denom;
+		float w = (d00 * d21 - d01 * d20) / denom;
+		if (v < 0.0f || w < 0.0f || v + w > 1.0f)
+			continue;
+		hit = true;
+		fraction = f;
+		normal = n[i];
+		planeD = d[i];
+	}
+	return hit;
+}
+
+bool SdfCollider::contact(const glm::vec3& p, float& depth, glm::vec3& normal) const {
+	bool hit = false;
+	depth = 0.0f;
+	for (const SdfGrid& grid : grids) {
+		// outside the lattice of a solid there is nothing, an inverted grid is solid all around it
+		if (!grid.inverted && (p.x < grid.bmin.x || p.y < grid.bmin.y || p.z < grid.bmin.z ||
+			p.x > grid.bmax.x || p.y > grid.bmax.y || p.z > grid.bmax.z))
+			continue;
+		float d;
+		glm::vec3 grad;
+		grid.sample(p, d, grad);
+		float l = glm::length(grad);
+		if (d >= depth || l == 0.0f)
+			continue;
+		hit = true;
+		depth = d;
+		normal = grad / l;
+	}
+	return hit;
+}
@@ -0,0 +1,46 @@
+#ifndef COLLIDER_H
+#define COLLIDER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MeshLoader.h"
+#include "SdfGrid.h"
+
+// static triangle collider, the planes of every triangle are precomputed from the mesh
+class TriangleCollider {
+
+public:
+	TriangleCollider() {};
+	TriangleCollider(const TriangleMesh& mesh) { build(mesh); }
+
+	void build(const TriangleMesh& mesh);
+
+	// tests the segment p0 -> p1, on a hit returns the fraction along the segment and the
+	// normal of the triangle that was crossed first
+	bool intersect(const glm::vec3& p0, const glm::vec3& p1, float& fraction, glm::vec3& normal, float& planeD) const;
+
+	std::vector<glm::vec3> v0;
+	std::vector<glm::vec3> e1; // v1 - v0
+	std::vector<glm::vec3> e2; // v2 - v0
+	std::vector<glm::vec3> n;
+	std::vector<float> d; // plane offset, dot(n, v0)
+	glm::vec3 bmin = glm::vec3(0.0f);
+	glm::vec3 bmax = glm::vec3(0.0f);
+};
+
+// static colliders baked into signed distance grids, a particle costs one lookup per grid
+// however many triangles the shapes had
+class SdfCollider {
+
+public:
+	// on contact, p is depth inside the solid of the grid it is deepest in, normal points out of it
+	// a step has to move less than the band, a particle that jumps over it is not seen
+	bool contact(const glm::vec3& p, float& depth, glm::vec3& normal) const;
+
+	bool empty() const { return grids.empty(); }
+
+	std::vector<SdfGrid> grids;
+};
+
+#endif
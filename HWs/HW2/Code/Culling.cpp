@@ -0,0 +1,111 @@
+#include "Culling.h"
+#include "Parallel.h"
+#include "Arena.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CULL_SSE
+#endif
+
+#define CULL_GRAIN 16384
+
+// Gribb/Hartmann, the planes are rows of the clip matrix added to or subtracted from the w row
+void Frustum::extract(const glm::mat4& m) {
+	for (int i = 0; i < 3; i++) {
+		planes[2 * i] = glm::vec4(m[0][3] + m[0][i], m[1][3] + m[1][i], m[2][3] + m[2][i], m[3][3] + m[3][i]);
+		planes[2 * i + 1] = glm::vec4(m[0][3] - m[0][i], m[1][3] - m[1][i], m[2][3] - m[2][i], m[3][3] - m[3][i]);
+	}
+	for (auto& pl : planes) {
+		float l = glm::length(glm::vec3(pl));
+		pl = pl / l;
+	}
+}
+
+bool Frustum::inside(const glm::vec3& p) const {
+	for (const auto& pl : planes) {
+		if (pl.x * p.x + pl.y * p.y + pl.z * p.z + pl.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+// visibility bits of the four particles starting at p
+static inline int cullGroup(const Frustum& f, const glm::vec3* p) {
+#ifdef CULL_SSE
+	// transpose 4 packed vec3 into x, y and z lanes
+	const float* q = &p[0].x;
+	__m128 a = _mm_loadu_ps(q);
+	__m128 b = _mm_loadu_ps(q + 4);
+	__m128 c = _mm_loadu_ps(q + 8);
+	__m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	__m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 zero = _mm_setzero_ps();
+	int mask = 0xF;
+	for (const auto& pl : f.planes) {
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(pl.x)), _mm_mul_ps(y, _mm_set1_ps(pl.y))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(pl.z)), _mm_set1_ps(pl.w)));
+		mask &= _mm_movemask_ps(_mm_cmpge_ps(d, zero));
+	}
+	return mask;
+#else
+	int mask = 0;
+	for (int k = 0; k < 4; k++)
+		mask |= f.inside(p[k]) << k;
+	return mask;
+#endif
+}
+
+static inline int popCount4(int m) {
+	return (m & 1) + ((m >> 1) & 1) + ((m >> 2) & 1) + ((m >> 3) & 1);
+}
+
+int ParticleCuller::cull(const Frustum& frustum, const ParticleData& pd, particle_gpu* out) {
+	int n = pd.n_alive;
+	int full = n / 4; // whole groups, the sse loads read 12 floats so the tail is done scalar
+	ThreadPool& pool = ThreadPool::get();
+	int ranges = pool.rangeCount(0, full, CULL_GRAIN);
+	Arena& frame = Arena::frame();
+	uint8_t* masks = frame.alloc<uint8_t>(full); // one visibility nibble per group of four particles
+	int* rangeOffsets = frame.alloc<int>(ranges + 1);
+	rangeOffsets[0] = 0;
+
+	// pass 1, visibility masks and a count per range
+	pool.parallelFor(0, full, [&](int b, int e, int r) {
+		int count = 0;
+		for (int g = b; g < e; g++) {
+			int m = cullGroup(frustum, &pd.p[4 * g]);
+			masks[g] = (uint8_t)m;
+			count += popCount4(m);
+		}
+		rangeOffsets[r + 1] = count;
+	}, CULL_GRAIN);
+
+	for (int r = 0; r < ranges; r++)
+		rangeOffsets[r + 1] += rangeOffsets[r];
+
+	// pass 2, every range packs its visible particles at its prefix offset
+	pool.parallelFor(0, full, [&](int b, int e, int r) {
+		particle_gpu* dst = out + rangeOffsets[r];
+		for (int g = b; g < e; g++) {
+			int m = masks[g];
+			for (int k = 0; m; k++, m >>= 1) {
+				if (m & 1) {
+					dst->p = pd.p[4 * g + k];
+					dst->c = pd.c[4 * g + k];
+					dst++;
+				}
+			}
+		}
+	}, CULL_GRAIN);
+
+	int visible = rangeOffsets[ranges];
+	for (int i = 4 * full; i < n; i++) {
+		if (frustum.inside(pd.p[i])) {
+			out[visible].p = pd.p[i];
+			out[visible].c = pd.c[i];
+			visible++;
+		}
+	}
+	return visible;
+}
@@ -0,0 +1,28 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "ParticleData.h"
+
+// planes are stored as (n, d) with n pointing inside, a point is inside when dot(n, p) + d >= 0
+struct Frustum {
+	glm::vec4 planes[6];
+
+	void extract(const glm::mat4& viewProjection);
+	bool inside(const glm::vec3& p) const;
+};
+
+// tests the live particles against the frustum four at a time and packs the visible ones
+// into the upload buffer, counting and packing are split over the thread pool
+// the visibility masks and range offsets are frame scratch
+class ParticleCuller {
+
+public:
+	// returns how many particles were written to out
+	int cull(const Frustum& frustum, const ParticleData& pd, particle_gpu* out);
+};
+
+#endif
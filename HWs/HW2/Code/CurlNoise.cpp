@@ -0,0 +1,260 @@
+#include "CurlNoise.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CURL_AVX2
+#endif
+
+#define CURL_MASK (CURL_LATTICE - 1)
+#define CURL_NODES (CURL_LATTICE * CURL_LATTICE * CURL_LATTICE)
+#define CURL_CORNERS (CURL_PERIOD * CURL_PERIOD * CURL_PERIOD)
+
+static inline uint32_t hashKey(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x;
+}
+
+static inline float fade(float t) {
+	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+// one of the twelve cube edge directions, dotted with the offset from the corner
+static inline float grad(int g, float x, float y, float z) {
+	switch (g) {
+	case 0: return x + y;
+	case 1: return -x + y;
+	case 2: return x - y;
+	case 3: return -x - y;
+	case 4: return x + z;
+	case 5: return -x + z;
+	case 6: return x - z;
+	case 7: return -x - z;
+	case 8: return y + z;
+	case 9: return -y + z;
+	case 10: return y - z;
+	default: return -y - z;
+	}
+}
+
+// periodic gradient noise in [-1, 1] at u in [0, CURL_PERIOD)
+static float gradientNoise(const uint8_t* grads, float ux, float uy, float uz) {
+	int ix = (int)ux, iy = (int)uy, iz = (int)uz;
+	float fx = ux - ix, fy = uy - iy, fz = uz - iz;
+	float c[8];
+	for (int k = 0; k < 8; k++) {
+		int dx = k & 1, dy = (k >> 1) & 1, dz = k >> 2;
+		int corner = (ix + dx) % CURL_PERIOD + CURL_PERIOD * ((iy + dy) % CURL_PERIOD + CURL_PERIOD * ((iz + dz) % CURL_PERIOD));
+		c[k] = grad(grads[corner], fx - dx, fy - dy, fz - dz);
+	}
+	float sx = fade(fx), sy = fade(fy), sz = fade(fz);
+	float x00 = c[0] + sx * (c[1] - c[0]);
+	float x10 = c[2] + sx * (c[3] - c[2]);
+	float x01 = c[4] + sx * (c[5] - c[4]);
+	float x11 = c[6] + sx * (c[7] - c[6]);
+	float y0 = x00 + sy * (x10 - x00);
+	float y1 = x01 + sy * (x11 - x01);
+	return y0 + sz * (y1 - y0);
+}
+
+CurlNoise::CurlNoise(unsigned seed) {
+	for (int c = 0; c < 3; c++) {
+		for (int k = 0; k < 3; k++)
+			keys[k][c].resize(CURL_NODES);
+		psi[c].resize(CURL_NODES);
+	}
+	reset(seed);
+}
+
+void CurlNoise::reset(unsigned seed) {
+	this->seed = seed;
+	key = 0;
+	time = 0.0f;
+	bakeKey(0, 0);
+	bakeKey(1, 1);
+	startKey(2, 2);
+	blend();
+}
+
+// the gradients of a key only depend on the seed and the key
+void CurlNoise::startKey(int slot, unsigned key) {
+	uint32_t base = hashKey(seed * 0x9e3779b9U + key);
+	for (int c = 0; c < 3; c++)
+		for (int i = 0; i < CURL_CORNERS; i++)
+			grads[slot][c][i] = (uint8_t)(hashKey(base + c * 0x632be5abU + i) % 12);
+	if (slot == 2)
+		baked = 0;
+}
+
+void CurlNoise::bakePlanes(int slot, int begin, int end) {
+	for (int z = begin; z < end; z++)
+		for (int y = 0; y < CURL_LATTICE; y++)
+			for (int x = 0; x < CURL_LATTICE; x++) {
+				int i = x + CURL_LATTICE * (y + CURL_LATTICE * z);
+				float ux = (float)x / CURL_FEATURE, uy = (float)y / CURL_FEATURE, uz = (float)z / CURL_FEATURE;
+				for (int c = 0; c < 3; c++)
+					keys[slot][c][i] = gradientNoise(grads[slot][c], ux, uy, uz);
+			}
+}
+
+void CurlNoise::bakeKey(int slot, unsigned key) {
+	startKey(slot, key);
+	ThreadPool::get().parallelFor(0, CURL_LATTICE, [&](int b, int e, int) { bakePlanes(slot, b, e); });
+	if (slot == 2)
+		baked = CURL_LATTICE;
+}
+
+void CurlNoise::advance(float h) {
+	if (period <= 0.0f)
+		return;
+	time += h;
+	if (time >= period) {
+		unsigned skip = (unsigned)(time / period);
+		time -= skip * period;
+		key += skip;
+		if (skip == 1) {
+			// usually one key per period, the one after has been baked along the way
+			bakePlanes(2, baked, CURL_LATTICE);
+			for (int c = 0; c < 3; c++) {
+				keys[0][c].swap(keys[1][c]);
+				keys[1][c].swap(keys[2][c]);
+			}
+			memcpy(grads[0], grads[1], sizeof(grads[0]));
+			memcpy(grads[1], grads[2], sizeof(grads[0]));
+		}
+		else {
+			// a long step skips the keys it jumped over
+			bakeKey(0, key);
+			bakeKey(1, key + 1);
+		}
+		startKey(2, key + 2);
+	}
+	// the next key is due when this period ends, so its planes are spread over the period
+	int due = std::min(CURL_LATTICE, (int)std::ceil(CURL_LATTICE * time / period));
+	if (due > baked) {
+		bakePlanes(2, baked, due);
+		baked = due;
+	}
+	blend();
+}
+
+// smoothstep in time so the flow does not change pace at the keys
+void CurlNoise::blend() {
+	float s = period > 0.0f ? time / period : 0.0f;
+	s = s * s * (3.0f - 2.0f * s);
+	for (int c = 0; c < 3; c++) {
+		const float* a = keys[0][c].data();
+		const float* b = keys[1][c].data();
+		float* out = psi[c].data();
+		for (int i = 0; i < CURL_NODES; i++)
+			out[i] = a[i] + s * (b[i] - a[i]);
+	}
+}
+
+glm::vec3 CurlNoise::curl(const glm::vec3& p) const {
+	// lattice units, then per feature so the size of the curl does not depend on the resolution
+	float toLattice = CURL_FEATURE / feature;
+	glm::vec3 g = p * toLattice;
+	glm::vec3 f = glm::floor(g);
+	glm::vec3 t = g - f;
+	int x0 = (int)f.x & CURL_MASK, y0 = (int)f.y & CURL_MASK, z0 = (int)f.z & CURL_MASK;
+	int x1 = (x0 + 1) & CURL_MASK, y1 = ((y0 + 1) & CURL_MASK) * CURL_LATTICE, z1 = ((z0 + 1) & CURL_MASK) * CURL_LATTICE * CURL_LATTICE;
+	y0 *= CURL_LATTICE;
+	z0 *= CURL_LATTICE * CURL_LATTICE;
+	int idx[8] = { x0 + y0 + z0, x1 + y0 + z0, x0 + y1 + z0, x1 + y1 + z0, x0 + y0 + z1, x1 + y0 + z1, x0 + y1 + z1, x1 + y1 + z1 };
+
+	// derivatives of the trilinear interpolant, along one axis it is the bilinear blend of the
+	// differences over the other two
+	glm::vec3 d[3];
+	for (int c = 0; c < 3; c++) {
+		const float* v = psi[c].data();
+		float c000 = v[idx[0]], c100 = v[idx[1]], c010 = v[idx[2]], c110 = v[idx[3]];
+		float c001 = v[idx[4]], c101 = v[idx[5]], c011 = v[idx[6]], c111 = v[idx[7]];
+		auto bilerp = [](float a, float b, float c, float e, float s, float u) {
+			float lo = a + s * (b - a), hi = c + s * (e - c);
+			return lo + u * (hi - lo);
+		};
+		d[c].x = bilerp(c100 - c000, c110 - c010, c101 - c001, c111 - c011, t.y, t.z);
+		d[c].y = bilerp(c010 - c000, c110 - c100, c011 - c001, c111 - c101, t.x, t.z);
+		d[c].z = bilerp(c001 - c000, c101 - c100, c011 - c010, c111 - c110, t.x, t.y);
+	}
+	return glm::vec3(d[2].y - d[1].z, d[0].z - d[2].x, d[1].x - d[0].y) * (float)CURL_FEATURE;
+}
+
+#ifdef CURL_AVX2
+static inline __m256 bilerp8(__m256 a, __m256 b, __m256 c, __m256 e, __m256 s, __m256 u) {
+	__m256 lo = _mm256_fmadd_ps(s, _mm256_sub_ps(b, a), a);
+	__m256 hi = _mm256_fmadd_ps(s, _mm256_sub_ps(e, c), c);
+	return _mm256_fmadd_ps(u, _mm256_sub_ps(hi, lo), lo);
+}
+#endif
+
+void CurlNoise::curl(const glm::vec3* p, int n, glm::vec3* out) const {
+	int i = 0;
+#ifdef CURL_AVX2
+	// the corner indices are shared by the three potential components, each component only
+	// needs the two derivatives its curl terms use, six bilinear blends for all three components
+	const float* pf = &p[0].x;
+	const __m256i lane3 = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256 toLattice = _mm256_set1_ps(CURL_FEATURE / feature);
+	const __m256i mask = _mm256_set1_epi32(CURL_MASK);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 scale = _mm256_set1_ps((float)CURL_FEATURE);
+	for (; i + 8 <= n; i += 8) {
+		__m256 t[3];
+		__m256i c0[3], c1[3];
+		for (int a = 0; a < 3; a++) {
+			__m256 g = _mm256_mul_ps(_mm256_i32gather_ps(pf + 3 * i + a, lane3, 4), toLattice);
+			__m256 f = _mm256_floor_ps(g);
+			t[a] = _mm256_sub_ps(g, f);
+			__m256i fi = _mm256_cvtps_epi32(f);
+			c0[a] = _mm256_and_si256(fi, mask);
+			c1[a] = _mm256_and_si256(_mm256_add_epi32(fi, one), mask);
+		}
+		c0[1] = _mm256_slli_epi32(c0[1], CURL_LATTICE_SHIFT);
+		c1[1] = _mm256_slli_epi32(c1[1], CURL_LATTICE_SHIFT);
+		c0[2] = _mm256_slli_epi32(c0[2], 2 * CURL_LATTICE_SHIFT);
+		c1[2] = _mm256_slli_epi32(c1[2], 2 * CURL_LATTICE_SHIFT);
+		__m256i y0z0 = _mm256_add_epi32(c0[1], c0[2]), y1z0 = _mm256_add_epi32(c1[1], c0[2]);
+		__m256i y0z1 = _mm256_add_epi32(c0[1], c1[2]), y1z1 = _mm256_add_epi32(c1[1], c1[2]);
+		__m256i idx[8] = {
+			_mm256_add_epi32(c0[0], y0z0), _mm256_add_epi32(c1[0], y0z0), _mm256_add_epi32(c0[0], y1z0), _mm256_add_epi32(c1[0], y1z0),
+			_mm256_add_epi32(c0[0], y0z1), _mm256_add_epi32(c1[0], y0z1), _mm256_add_epi32(c0[0], y1z1), _mm256_add_epi32(c1[0], y1z1)
+		};
+
+		__m256 v[3][8];
+		for (int c = 0; c < 3; c++)
+			for (int k = 0; k < 8; k++)
+				v[c][k] = _mm256_i32gather_ps(psi[c].data(), idx[k], 4);
+		// corner k has x in bit 0, y in bit 1, z in bit 2
+		auto dx = [&](int c) {
+			return bilerp8(_mm256_sub_ps(v[c][1], v[c][0]), _mm256_sub_ps(v[c][3], v[c][2]),
+				_mm256_sub_ps(v[c][5], v[c][4]), _mm256_sub_ps(v[c][7], v[c][6]), t[1], t[2]);
+		};
+		auto dy = [&](int c) {
+			return bilerp8(_mm256_sub_ps(v[c][2], v[c][0]), _mm256_sub_ps(v[c][3], v[c][1]),
+				_mm256_sub_ps(v[c][6], v[c][4]), _mm256_sub_ps(v[c][7], v[c][5]), t[0], t[2]);
+		};
+		auto dz = [&](int c) {
+			return bilerp8(_mm256_sub_ps(v[c][4], v[c][0]), _mm256_sub_ps(v[c][5], v[c][1]),
+				_mm256_sub_ps(v[c][6], v[c][2]), _mm256_sub_ps(v[c][7], v[c][3]), t[0], t[1]);
+		};
+		alignas(32) float r[3][8];
+		_mm256_store_ps(r[0], _mm256_mul_ps(_mm256_sub_ps(dy(2), dz(1)), scale));
+		_mm256_store_ps(r[1], _mm256_mul_ps(_mm256_sub_ps(dz(0), dx(2)), scale));
+		_mm256_store_ps(r[2], _mm256_mul_ps(_mm256_sub_ps(dx(1), dy(0)), scale));
+		for (int k = 0; k < 8; k++)
+			out[i + k] = glm::vec3(r[0][k], r[1][k], r[2][k]);
+	}
+#endif
+	for (; i < n; i++)
+		out[i] = curl(p[i]);
+}
@@ -0,0 +1,53 @@
+#ifndef CURLNOISE_H
+#define CURLNOISE_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#define CURL_LATTICE_SHIFT 5
+#define CURL_LATTICE (1 << CURL_LATTICE_SHIFT) // nodes along each axis, the lattice tiles space
+#define CURL_FEATURE 4 // lattice cells per noise feature
+#define CURL_PERIOD (CURL_LATTICE / CURL_FEATURE) // of the noise in features, so the lattice tiles
+
+// curl of a vector potential made of three gradient noises, the flow is divergence free so
+// particles swirl without bunching up
+// the potential is baked on a periodic lattice at key times, a new key every period seconds,
+// and advance() blends the two keys around the current time into one lattice, so a particle
+// costs the eight corners of its cell and no noise evaluation at all
+// the key after those two is baked a few planes per step, so no step pays for a whole key
+// the curl is taken of the trilinear interpolant, it is exactly divergence free inside every cell
+// and its normal component is continuous across cell faces
+class CurlNoise {
+
+public:
+	// bakes the first keys of the seed, reset only to change the seed later on
+	explicit CurlNoise(unsigned seed);
+
+	void reset(unsigned seed);
+	void advance(float h);
+
+	glm::vec3 curl(const glm::vec3& p) const;
+	// n positions at once, eight per step with avx2
+	void curl(const glm::vec3* p, int n, glm::vec3* out) const;
+
+	float feature = 4.0f; // world size of one noise feature
+	float period = 1.0f; // seconds from one key to the next
+
+private:
+	void startKey(int slot, unsigned key);
+	void bakePlanes(int slot, int begin, int end);
+	void bakeKey(int slot, unsigned key);
+	void blend();
+
+	// potential at the last key, the next key and the one after, one plane per component
+	std::vector<float> keys[3][3];
+	uint8_t grads[3][3][CURL_PERIOD * CURL_PERIOD * CURL_PERIOD]; // gradient of every noise corner per key and component
+	std::vector<float> psi[3]; // blended for the current time
+	unsigned seed = 0;
+	unsigned key = 0; // of keys[0]
+	int baked = 0; // z planes of keys[2] done
+	float time = 0.0f; // since keys[0]
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "DepthSort.h"
+#include "Parallel.h"
+#include "Arena.h"
+
+#include <cfloat>
+#include <algorithm>
+
+#define DEPTH_GRAIN 16384
+
+void DepthSorter::order(const glm::mat4& view, const particle_gpu* particles, int n, uint32_t* indices) {
+	if (n <= 0)
+		return;
+	ThreadPool& pool = ThreadPool::get();
+	int ranges = pool.rangeCount(0, n, DEPTH_GRAIN);
+	Arena& frame = Arena::frame();
+	size_t mark = frame.mark();
+	float* depth = frame.alloc<float>(n);
+	uint32_t* keys = frame.alloc<uint32_t>(n);
+	glm::vec2* bounds = frame.alloc<glm::vec2>(ranges); // min and max depth per range
+
+	// only the z row of the view matrix matters, distance along the view direction
+	glm::vec4 row(view[0][2], view[1][2], view[2][2], view[3][2]);
+	pool.parallelFor(0, n, [&](int b, int e, int r) {
+		float lo = FLT_MAX, hi = -FLT_MAX;
+		for (int i = b; i < e; i++) {
+			const glm::vec3& p = particles[i].p;
+			float d = -(row.x * p.x + row.y * p.y + row.z * p.z + row.w);
+			depth[i] = d;
+			lo = std::min(lo, d);
+			hi = std::max(hi, d);
+		}
+		bounds[r] = glm::vec2(lo, hi);
+	}, DEPTH_GRAIN);
+	float lo = FLT_MAX, hi = -FLT_MAX;
+	for (int r = 0; r < ranges; r++) {
+		lo = std::min(lo, bounds[r].x);
+		hi = std::max(hi, bounds[r].y);
+	}
+
+	// the farthest gets key 0, ascending keys are back to front
+	const float top = (float)((1u << DEPTH_SORT_BITS) - 1);
+	float scale = hi > lo ? top / (hi - lo) : 0.0f;
+	pool.parallelFor(0, n, [&](int b, int e, int) {
+		for (int i = b; i < e; i++) {
+			float k = (hi - depth[i]) * scale;
+			keys[i] = k > 0.0f ? (uint32_t)std::min(k, top) : 0; // also catches nan
+			indices[i] = (uint32_t)i;
+		}
+	}, DEPTH_GRAIN);
+
+	radix.sort(keys, indices, n);
+	frame.rewind(mark);
+}
@@ -0,0 +1,25 @@
+#ifndef DEPTHSORT_H
+#define DEPTHSORT_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "ParticleData.h"
+#include "RadixSort.h"
+
+#define DEPTH_SORT_BITS 22 // two 11 bit radix passes
+
+// back to front order of particles by view space depth so alpha blending composes correctly
+// depths are quantized over the range of the batch and radix sorted on the thread pool
+// the depths, keys and the sort buffers are frame scratch
+class DepthSorter {
+
+public:
+	// indices of particles from the farthest to the nearest, for glDrawElements over the unsorted upload
+	void order(const glm::mat4& view, const particle_gpu* particles, int n, uint32_t* indices);
+
+private:
+	RadixSorter<uint32_t> radix;
+};
+
+#endif
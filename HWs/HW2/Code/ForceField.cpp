@@ -0,0 +1,223 @@
+#include "ForceField.h"
+
+#include <algorithm>
+#include <imgui/imgui.h>
+#include <glm/gtc/type_ptr.hpp>
+
+bool ForceField::gui() {
+	return ImGui::Checkbox(name.c_str(), &enabled);
+}
+
+void ForceField::setRegion(glm::vec3 center, glm::vec3 halfExtent) {
+	bmin = center - halfExtent;
+	bmax = center + halfExtent;
+}
+
+bool ForceField::overlaps(const ParticleBatch& b) const {
+	return b.bmin.x <= bmax.x && b.bmax.x >= bmin.x &&
+		b.bmin.y <= bmax.y && b.bmax.y >= bmin.y &&
+		b.bmin.z <= bmax.z && b.bmax.z >= bmin.z;
+}
+
+bool ForceField::contains(const ParticleBatch& b) const {
+	return inside(b.bmin) && inside(b.bmax);
+}
+
+void UniformField::apply(const ParticleBatch& b, float /*h*/) const {
+	forEach(b, [&](int i) { b.a[i] += g; });
+}
+
+bool UniformField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat3("Gravity", glm::value_ptr(g), 0.005f);
+	return changed;
+}
+
+void WindField::apply(const ParticleBatch& b, float /*h*/) const {
+	glm::vec3 f = windFactor * wind;
+	forEach(b, [&](int i) { b.a[i] += f / b.m[i]; });
+}
+
+bool WindField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat3("Wind", glm::value_ptr(wind), 0.05f);
+	changed |= ImGui::DragFloat("Wind Factor", &windFactor, 0.005f);
+	return changed;
+}
+
+void DragField::apply(const ParticleBatch& b, float /*h*/) const {
+	forEach(b, [&](int i) { b.a[i] -= airResistanceFactor * b.v[i] / b.m[i]; });
+}
+
+bool DragField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat("Air Resistance Factor", &airResistanceFactor, 0.005f);
+	return changed;
+}
+
+void VortexField::apply(const ParticleBatch& b, float /*h*/) const {
+	glm::vec3 n = glm::normalize(axis);
+	forEach(b, [&](int i) {
+		glm::vec3 r = b.p[i] - center;
+		r -= glm::dot(r, n) * n; // distance to the axis only
+		float d2 = glm::dot(r, r) + 1.0f;
+		b.a[i] += (strength * glm::cross(n, r) - pull * r) / d2;
+	});
+}
+
+bool VortexField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat3("Vortex Center", glm::value_ptr(center), 0.05f);
+	changed |= ImGui::DragFloat3("Vortex Axis", glm::value_ptr(axis), 0.05f);
+	changed |= ImGui::DragFloat("Vortex Strength", &strength, 0.05f);
+	changed |= ImGui::DragFloat("Vortex Pull", &pull, 0.05f);
+	return changed;
+}
+
+void PointAttractor::apply(const ParticleBatch& b, float /*h*/) const {
+	forEach(b, [&](int i) {
+		glm::vec3 d = center - b.p[i];
+		float d2 = glm::dot(d, d) + softening * softening;
+		b.a[i] += strength * d / (d2 * std::sqrt(d2));
+	});
+}
+
+bool PointAttractor::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat3("Attractor Center", glm::value_ptr(center), 0.05f);
+	changed |= ImGui::DragFloat("Attractor Strength", &strength, 0.05f);
+	return changed;
+}
+
+void LorenzField::apply(const ParticleBatch& b, float h) const {
+	if (factor == 0.0f)
+		return;
+	// a = k/h * (lorenz - v) makes one euler step land on (1 - k) * v + k * lorenz
+	float k = factor * 0.01f / h;
+	forEach(b, [&](int i) {
+		b.a[i] += k * (flow(b.p[i]) - b.v[i]);
+	});
+}
+
+bool LorenzField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat("Rho", &rho, 0.005f);
+	changed |= ImGui::DragFloat("Beta", &beta, 0.005f);
+	changed |= ImGui::DragFloat("Sigma", &sigma, 0.005f);
+	changed |= ImGui::DragFloat("Lorenz Factor", &factor, 0.005f);
+	return changed;
+}
+
+void GridField::apply(const ParticleBatch& b, float h) const {
+	if (factor == 0.0f || grid.empty())
+		return;
+	float k = factor * 0.01f / h;
+	// the whole batch is sampled at once so the gathers run eight wide, particles outside the
+	// region are sampled for nothing but that is cheaper than packing the ones inside
+	glm::vec3 flow[FORCE_BATCH_SIZE];
+	grid.sample(b.p, b.n, flow);
+	forEach(b, [&](int i) {
+		b.a[i] += k * (flow[i] - b.v[i]);
+	});
+}
+
+bool GridField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat("Grid Factor", &factor, 0.005f);
+	ImGui::Text("%d x %d x %d samples, %s, %.1f MB", grid.samples.x, grid.samples.y, grid.samples.z,
+		grid.isSparse() ? "sparse" : "dense", grid.bytes() / (1024.0 * 1024.0));
+	return changed;
+}
+
+void CurlNoiseField::apply(const ParticleBatch& b, float h) const {
+	if (factor == 0.0f)
+		return;
+	float k = factor * 0.01f / h;
+	glm::vec3 flow[FORCE_BATCH_SIZE];
+	noise.curl(b.p, b.n, flow);
+	forEach(b, [&](int i) {
+		b.a[i] += k * (strength * flow[i] - b.v[i]);
+	});
+}
+
+bool CurlNoiseField::advance(float h) {
+	noise.advance(h);
+	// without a period the flow is frozen and nothing near it has to be woken
+	return factor != 0.0f && noise.period > 0.0f;
+}
+
+bool CurlNoiseField::gui() {
+	bool changed = ForceField::gui();
+	changed |= ImGui::DragFloat("Curl Strength", &strength, 0.05f);
+	changed |= ImGui::DragFloat("Feature Size", &noise.feature, 0.05f, 0.01f, 1000.0f);
+	changed |= ImGui::DragFloat("Key Period", &noise.period, 0.01f, 0.0f, 100.0f);
+	changed |= ImGui::DragFloat("Curl Factor", &factor, 0.005f);
+	return changed;
+}
+
+void ForceFieldRegistry::remove(ForceField* field) {
+	markDirty(field);
+	fields.erase(std::remove_if(fields.begin(), fields.end(),
+		[field](const std::unique_ptr<ForceField>& f) { return f.get() == field; }), fields.end());
+}
+
+void ForceFieldRegistry::markDirty(const ForceField* field) {
+	dirty.push_back(field->bmin);
+	dirty.push_back(field->bmax);
+}
+
+void ForceFieldRegistry::wakeDirty(ParticleData& pd) const {
+	for (size_t i = 0; i + 1 < dirty.size(); i += 2)
+		pd.wakeRegion(dirty[i], dirty[i + 1]);
+}
+
+void ForceFieldRegistry::advance(float h) {
+	for (const auto& field : fields)
+		if (field->enabled && field->advance(h))
+			markDirty(field.get());
+}
+
+void ForceFieldRegistry::apply(ParticleData& pd, int begin, int end, float h) const {
+	ParticleBatch b;
+	b.p = &pd.p[begin];
+	b.v = &pd.v[begin];
+	b.m = &pd.m[begin];
+	b.a = &pd.a[begin];
+	b.n = end - begin;
+	apply(b, h);
+}
+
+void ForceFieldRegistry::apply(ParticleBatch b, float h) const {
+	for (int i = 0; i < b.n; i++)
+		b.a[i] = glm::vec3(0.0f);
+
+	for (int start = 0; start < b.n; start += FORCE_BATCH_SIZE) {
+		ParticleBatch chunk = b;
+		chunk.p += start;
+		chunk.v += start;
+		chunk.m += start;
+		chunk.a += start;
+		chunk.n = std::min(FORCE_BATCH_SIZE, b.n - start);
+		chunk.bmin = chunk.p[0];
+		chunk.bmax = chunk.p[0];
+		for (int i = 1; i < chunk.n; i++) {
+			chunk.bmin = glm::min(chunk.bmin, chunk.p[i]);
+			chunk.bmax = glm::max(chunk.bmax, chunk.p[i]);
+		}
+
+		for (const auto& field : fields) {
+			if (field->enabled && field->overlaps(chunk))
+				field->apply(chunk, h);
+		}
+	}
+}
+
+void ForceFieldRegistry::gui() {
+	for (int i = 0; i < (int)fields.size(); i++) {
+		ImGui::PushID(i);
+		if (fields[i]->gui())
+			markDirty(fields[i].get());
+		ImGui::PopID();
+		ImGui::Separator();
+	}
+}
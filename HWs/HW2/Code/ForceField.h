@@ -0,0 +1,191 @@
+#ifndef FORCEFIELD_H
+#define FORCEFIELD_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+#include "ParticleData.h"
+#include "VectorGrid.h"
+#include "CurlNoise.h"
+
+#define FORCE_BATCH_SIZE 1024
+
+// view over a contiguous range of particle columns, fields read p, v, m and accumulate into a
+struct ParticleBatch {
+	const glm::vec3* p;
+	const glm::vec3* v;
+	const float* m;
+	glm::vec3* a;
+	int n;
+	glm::vec3 bmin; // bounds of the positions in the batch
+	glm::vec3 bmax;
+};
+
+// a field is evaluated once per batch, the per particle loop lives inside apply so stacking
+// fields costs one virtual call per field per batch instead of one per particle
+class ForceField {
+
+public:
+	ForceField(const char* name) : name(name) {};
+	virtual ~ForceField() {};
+
+	virtual void apply(const ParticleBatch& b, float h) const = 0;
+	// time dependent fields move on by h once per step, returns true when the field changed
+	virtual bool advance(float /*h*/) { return false; }
+	// returns true when a parameter was edited
+	virtual bool gui();
+
+	std::string name;
+	bool enabled = true;
+	// region of influence, unbounded by default
+	glm::vec3 bmin = glm::vec3(-FLT_MAX);
+	glm::vec3 bmax = glm::vec3(FLT_MAX);
+
+	void setRegion(glm::vec3 center, glm::vec3 halfExtent);
+	bool overlaps(const ParticleBatch& b) const;
+	bool contains(const ParticleBatch& b) const;
+	bool inside(const glm::vec3& p) const {
+		return p.x >= bmin.x && p.y >= bmin.y && p.z >= bmin.z &&
+			p.x <= bmax.x && p.y <= bmax.y && p.z <= bmax.z;
+	}
+
+protected:
+	// runs f on every particle of the batch that is inside the region, the region test is
+	// dropped when the whole batch is inside it
+	template <class F>
+	void forEach(const ParticleBatch& b, F f) const {
+		if (contains(b)) {
+			for (int i = 0; i < b.n; i++)
+				f(i);
+		}
+		else {
+			for (int i = 0; i < b.n; i++)
+				if (inside(b.p[i]))
+					f(i);
+		}
+	}
+};
+
+// constant acceleration, gravity
+class UniformField : public ForceField {
+public:
+	UniformField(glm::vec3 g) : ForceField("Gravity"), g(g) {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	glm::vec3 g;
+};
+
+// constant force scaled by the wind factor, heavier particles are pushed less
+class WindField : public ForceField {
+public:
+	WindField(glm::vec3 wind, float windFactor) : ForceField("Wind"), wind(wind), windFactor(windFactor) {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	glm::vec3 wind;
+	float windFactor;
+};
+
+// linear air resistance, -k * v
+class DragField : public ForceField {
+public:
+	DragField(float airResistanceFactor) : ForceField("Drag"), airResistanceFactor(airResistanceFactor) {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	float airResistanceFactor;
+};
+
+// swirls particles around an axis through center, falls off with distance to the axis
+class VortexField : public ForceField {
+public:
+	VortexField(glm::vec3 center, glm::vec3 axis, float strength) : ForceField("Vortex"), center(center), axis(axis), strength(strength) {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	glm::vec3 center;
+	glm::vec3 axis;
+	float strength;
+	float pull = 0.0f; // radial pull towards the axis
+};
+
+// inverse square point attractor, negative strength repels
+class PointAttractor : public ForceField {
+public:
+	PointAttractor(glm::vec3 center, float strength) : ForceField("Attractor"), center(center), strength(strength) {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	glm::vec3 center;
+	float strength;
+	float softening = 0.1f;
+};
+
+// relaxes the velocity towards the Lorenz flow, factor is the blend percentage per step
+class LorenzField : public ForceField {
+public:
+	LorenzField(float sigma, float rho, float beta) : ForceField("Lorenz"), sigma(sigma), rho(rho), beta(beta) {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	glm::vec3 flow(const glm::vec3& p) const {
+		return glm::vec3(sigma * (p.y - p.x), p.x * (rho - p.z) - p.y, p.x * p.y - beta * p.z);
+	}
+	float sigma;
+	float rho;
+	float beta;
+	float factor = 0.0f;
+};
+
+// relaxes the velocity towards a flow baked into a grid or loaded from a grid file, the same
+// blend as LorenzField but any flow costs one trilinear lookup per particle
+class GridField : public ForceField {
+public:
+	GridField() : ForceField("Grid") {};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool gui() override;
+	VectorGrid grid;
+	float factor = 0.0f;
+};
+
+// relaxes the velocity towards an animated curl noise flow, the same blend as LorenzField
+class CurlNoiseField : public ForceField {
+public:
+	CurlNoiseField(float feature, float strength, float period, unsigned seed) : ForceField("Curl Noise"), noise(seed), strength(strength) {
+		noise.feature = feature;
+		noise.period = period;
+	};
+	void apply(const ParticleBatch& b, float h) const override;
+	bool advance(float h) override;
+	bool gui() override;
+	CurlNoise noise;
+	float strength; // speed of the flow where the noise is steepest
+	float factor = 0.0f;
+};
+
+class ForceFieldRegistry {
+
+public:
+	template <class T, class... Args>
+	T* add(Args&&... args) {
+		T* field = new T(std::forward<Args>(args)...);
+		fields.emplace_back(field);
+		markDirty(field);
+		return field;
+	}
+	void remove(ForceField* field);
+	// a field changed, sleeping particles in its region have to be woken
+	void markDirty(const ForceField* field);
+	void wakeDirty(ParticleData& pd) const;
+	void clearDirty() { dirty.clear(); }
+	// once per step before apply, fields that changed are marked dirty
+	void advance(float h);
+
+	// clears a and accumulates every enabled field over [begin, end) in batches of FORCE_BATCH_SIZE
+	void apply(ParticleData& pd, int begin, int end, float h) const;
+	void apply(ParticleBatch b, float h) const;
+	void gui();
+
+	std::vector<std::unique_ptr<ForceField>> fields;
+	std::vector<glm::vec3> dirty; // pairs of region bounds
+};
+
+#endif
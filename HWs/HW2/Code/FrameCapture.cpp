@@ -0,0 +1,244 @@
+#include "FrameCapture.h"
+#include <glad/glad.h>
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+#define CAPTURE_WAIT_NS 1000000000ull // a fence not passed after a second is mapped anyway, mapping waits on its own
+
+FrameCapture::FrameCapture(int width, int height, const std::string& dir, int format)
+	: width(std::min(std::max(width, 1), CAPTURE_MAX_SIZE)), height(std::min(std::max(height, 1), CAPTURE_MAX_SIZE)), dir(dir), format(format) {
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+	if (this->width > maxSize || this->height > maxSize) {
+		std::cout << "ERROR: Capture Size Too Large: " << this->width << " x " << this->height << ", " << maxSize << " allowed" << std::endl;
+		this->width = std::min(this->width, (int)maxSize);
+		this->height = std::min(this->height, (int)maxSize);
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(dir, ec);
+	if (format == CAPTURE_RAW) {
+		char name[64];
+		snprintf(name, sizeof(name), "capture_%dx%d.rgb", this->width, this->height);
+		std::string path = (std::filesystem::path(dir) / name).string();
+		raw.open(path, std::ios::binary | std::ios::trunc);
+		if (!raw) {
+			std::cout << "ERROR: Capture Open Failed: " << path << std::endl;
+			return;
+		}
+		std::cout << "capturing rgb24 frames of " << this->width << " x " << this->height << " to " << path << std::endl;
+	}
+	else if (ec) {
+		std::cout << "ERROR: Capture Directory Failed: " << dir << std::endl;
+		return;
+	}
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenRenderbuffers(1, &color);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, this->width, this->height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glGenRenderbuffers(1, &depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, this->width, this->height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR: Capture Framebuffer Incomplete: " << status << std::endl;
+		glDeleteRenderbuffers(1, &depth);
+		glDeleteRenderbuffers(1, &color);
+		glDeleteFramebuffers(1, &fbo);
+		fbo = color = depth = 0;
+		return;
+	}
+
+	// stream read, the driver keeps the buffers where the cpu reads them fastest
+	size_t bytes = (size_t)this->width * this->height * 4;
+	glGenBuffers(CAPTURE_RING, pbo);
+	for (int i = 0; i < CAPTURE_RING; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	int encoders = 1;
+	if (format != CAPTURE_RAW)
+		encoders = std::min(std::max((int)std::thread::hardware_concurrency() - 1, 1), CAPTURE_MAX_ENCODERS);
+	int count = encoders + CAPTURE_QUEUE;
+	frames.resize(count);
+	freeList.resize(count);
+	queue.resize(count);
+	for (int i = 0; i < count; i++) {
+		frames[i].resize(bytes);
+		freeList[i] = i;
+	}
+	freeCount = count;
+	for (int i = 0; i < encoders; i++)
+		workers.emplace_back(&FrameCapture::encodeLoop, this, i);
+}
+
+FrameCapture::~FrameCapture() {
+	if (fbo) {
+		for (int k = 0; k < CAPTURE_RING; k++) {
+			int slot = (int)((frame + k) % CAPTURE_RING);
+			if (fence[slot])
+				collect(slot, true);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+
+	if (fbo) {
+		glDeleteBuffers(CAPTURE_RING, pbo);
+		glDeleteRenderbuffers(1, &depth);
+		glDeleteRenderbuffers(1, &color);
+		glDeleteFramebuffers(1, &fbo);
+	}
+}
+
+long long FrameCapture::getWritten() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return written;
+}
+
+void FrameCapture::begin() {
+	if (!valid())
+		return;
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+}
+
+void FrameCapture::end() {
+	if (!valid())
+		return;
+	// the slot is reused every CAPTURE_RING frames, its last frame is collected just before
+	int slot = (int)(frame % CAPTURE_RING);
+	if (fence[slot])
+		collect(slot, false);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slotFrame[slot] = frame++;
+
+	// letterboxed into the viewport, what is shown keeps the aspect of what is written
+	int w = viewport[2], h = viewport[3];
+	if ((long long)w * height > (long long)h * width)
+		w = (int)((long long)h * width / height);
+	else
+		h = (int)((long long)w * height / width);
+	int x = viewport[0] + (viewport[2] - w) / 2, y = viewport[1] + (viewport[3] - h) / 2;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBlitFramebuffer(0, 0, width, height, x, y, x + w, y + h, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void FrameCapture::collect(int slot, bool wait) {
+	// by now the fence has normally passed, the wait only blocks when the gpu is a whole ring behind
+	GLsync sync = (GLsync)fence[slot];
+	glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, CAPTURE_WAIT_NS);
+	glDeleteSync(sync);
+	fence[slot] = nullptr;
+
+	int buffer = -1;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (wait)
+			freed.wait(lock, [&] { return freeCount > 0; });
+		if (freeCount > 0)
+			buffer = freeList[--freeCount];
+	}
+	if (buffer < 0) {
+		dropped++;
+		return;
+	}
+
+	size_t bytes = frames[buffer].size();
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+	const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT);
+	if (pixels) {
+		memcpy(frames[buffer].data(), pixels, bytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!pixels) {
+			freeList[freeCount++] = buffer;
+			dropped++;
+			return;
+		}
+		queue[(queueHead + queueCount) % queue.size()] = { buffer, slotFrame[slot] };
+		queueCount++;
+	}
+	wake.notify_one();
+}
+
+// the queue is drained before the workers quit, so every collected frame is written
+void FrameCapture::encodeLoop(int index) {
+	char name[64];
+	for (;;) {
+		Encoded e;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return queueCount > 0 || quit; });
+			if (queueCount == 0)
+				return;
+			e = queue[queueHead];
+			queueHead = (queueHead + 1) % (int)queue.size();
+			queueCount--;
+		}
+
+		const unsigned char* rgba = frames[e.buffer].data();
+		if (format == CAPTURE_RAW) {
+			// rows come bottom up, video tools expect them top down
+			rawRow.resize((size_t)width * 3);
+			for (int y = height - 1; y >= 0; y--) {
+				const unsigned char* src = rgba + (size_t)y * width * 4;
+				for (int x = 0; x < width; x++) {
+					rawRow[3 * x] = src[4 * x];
+					rawRow[3 * x + 1] = src[4 * x + 1];
+					rawRow[3 * x + 2] = src[4 * x + 2];
+				}
+				raw.write((const char*)rawRow.data(), rawRow.size());
+			}
+			if (!raw)
+				std::cout << "ERROR: Capture Write Failed: frame " << e.frame << std::endl;
+		}
+		else {
+			const std::vector<unsigned char>& file = png[index].encode(rgba, width, height);
+			snprintf(name, sizeof(name), "frame_%06lld.png", e.frame);
+			std::string path = (std::filesystem::path(dir) / name).string();
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			out.write((const char*)file.data(), file.size());
+			if (!out)
+				std::cout << "ERROR: Capture Write Failed: " << path << std::endl;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			freeList[freeCount++] = e.buffer;
+			written++;
+		}
+		freed.notify_one();
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "PngEncoder.h"
+
+#define CAPTURE_RING 3 // pixel buffers in flight, a frame is mapped this many frames after it was drawn
+#define CAPTURE_QUEUE 8 // frames read back and waiting for an encoder on top of those being encoded, more are dropped
+#define CAPTURE_MAX_ENCODERS 8
+#define CAPTURE_MAX_SIZE 8192
+
+enum CaptureFormat {
+	CAPTURE_PNG = 0, // one numbered png file per frame
+	CAPTURE_RAW = 1 // every frame appended to one file of rgb24 rows, top down
+};
+
+// records the frames drawn between begin() and end() without stalling the draw loop
+// the scene is drawn into an offscreen framebuffer of the capture size, end() starts an
+// asynchronous glReadPixels into the next of a ring of pixel buffers, puts a fence behind it and
+// copies the framebuffer to the window, the buffer is only mapped when the ring comes back
+// round to it, by then the fence has long passed, so mapping does not wait on the gpu
+// the mapped pixels are copied into a free frame and encoded and written on worker threads, png
+// frames go to every core but one since each is its own numbered file, the raw file is written
+// in order by one worker, when the workers fall behind by CAPTURE_QUEUE frames more are dropped
+// rather than waited on
+class FrameCapture {
+
+public:
+	FrameCapture(int width, int height, const std::string& dir, int format);
+	~FrameCapture(); // reads back and writes every frame still in flight
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	bool valid() const { return fbo != 0; }
+
+	// draws go to the capture framebuffer until end(), the viewport is the capture size
+	// both do nothing when the constructor failed
+	void begin();
+	// starts the readback of the frame and shows it in the viewport begin() replaced, scaled to
+	// fit and centered
+	void end();
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	long long getCaptured() const { return frame; }
+	long long getWritten() const;
+	long long getDropped() const { return dropped; }
+
+private:
+	struct Encoded {
+		int buffer;
+		long long frame;
+	};
+
+	// maps the buffer of a slot and queues its frame, without a free frame it is dropped unless
+	// wait is set, then the worker is waited on
+	void collect(int slot, bool wait);
+	void encodeLoop(int index);
+
+	int width;
+	int height;
+	std::string dir;
+	int format;
+
+	unsigned int fbo = 0;
+	unsigned int color = 0;
+	unsigned int depth = 0;
+	unsigned int pbo[CAPTURE_RING] = {};
+	void* fence[CAPTURE_RING] = {}; // GLsync, null when the slot holds no frame
+	long long slotFrame[CAPTURE_RING] = {};
+	long long frame = 0; // frames ended so far
+	long long dropped = 0;
+	int viewport[4] = {};
+
+	// frames move from free to queued on the main thread and back on the workers, there is one
+	// per worker and CAPTURE_QUEUE more
+	std::vector<std::vector<unsigned char>> frames;
+	std::vector<int> freeList;
+	int freeCount = 0;
+	std::vector<Encoded> queue;
+	int queueHead = 0;
+	int queueCount = 0;
+	long long written = 0;
+	bool quit = false;
+	mutable std::mutex mutex;
+	std::condition_variable wake; // the workers wait for frames
+	std::condition_variable freed; // the main thread waits for free frames, only when finishing
+	std::vector<std::thread> workers;
+
+	// one encoder per worker, the raw file and its row only for the single raw worker
+	PngEncoder png[CAPTURE_MAX_ENCODERS];
+	std::ofstream raw;
+	std::vector<unsigned char> rawRow;
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "GLContext.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+#if defined(__linux__) && !defined(CONTEXT_NO_EGL)
+#define CONTEXT_EGL_BUILT
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef CONTEXT_USE_OSMESA
+#ifndef GLAPIENTRY
+#define GLAPIENTRY APIENTRY // glad keeps GL/gl.h out, osmesa.h still expects its calling convention macro
+#endif
+#include <GL/osmesa.h>
+#endif
+
+class WindowBackend : public GLContext {
+
+public:
+	~WindowBackend() {
+		if (handle)
+			glfwDestroyWindow(handle);
+		glfwTerminate();
+	}
+
+	bool init(int w, int h, const char* title) {
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // opengl version 3
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); //opengil version 3.3
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); //using core profile of opengl
+		//glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+		handle = glfwCreateWindow(w, h, title, NULL, NULL);
+		//glfwSetWindowMonitor(window, glfwGetPrimaryMonitor(), 0, 0, 1920, 1080, GLFW_DONT_CARE);
+		if (handle == NULL) {
+			std::cout << "Failed to create GLFW window" << std::endl;
+			return false;
+		}
+		glfwMakeContextCurrent(handle);
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void present() override {
+		glfwSwapBuffers(handle);
+		glfwPollEvents();
+	}
+	bool closing() const override { return glfwWindowShouldClose(handle); }
+	void getSize(int& w, int& h) const override { glfwGetWindowSize(handle, &w, &h); }
+	GLFWwindow* window() const override { return handle; }
+
+private:
+	GLFWwindow* handle = nullptr;
+};
+
+#ifdef CONTEXT_EGL_BUILT
+// the surfaceless platform of mesa needs neither a display server nor a gpu, llvmpipe renders
+// when there is none, elsewhere the default display is tried
+class EglBackend : public GLContext {
+
+public:
+	~EglBackend() {
+		if (display == EGL_NO_DISPLAY)
+			return;
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		if (surface != EGL_NO_SURFACE)
+			eglDestroySurface(display, surface);
+		eglTerminate(display);
+	}
+
+	bool init(int w, int h) {
+		const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay && extensions && strstr(extensions, "EGL_MESA_platform_surfaceless"))
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		EGLint major, minor;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			std::cout << "ERROR: EGL Initialize Failed: " << std::hex << eglGetError() << std::dec << std::endl;
+			display = EGL_NO_DISPLAY;
+			return false;
+		}
+
+		const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configs = 0;
+		if (!eglChooseConfig(display, configAttribs, &config, 1, &configs) || configs == 0) {
+			std::cout << "ERROR: EGL No Pbuffer Config" << std::endl;
+			return false;
+		}
+		const EGLint surfaceAttribs[] = { EGL_WIDTH, w, EGL_HEIGHT, h, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+		eglBindAPI(EGL_OPENGL_API);
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+		if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+			std::cout << "ERROR: EGL Context Failed: " << std::hex << eglGetError() << std::dec << std::endl;
+			return false;
+		}
+		if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void present() override { eglSwapBuffers(display, surface); }
+
+private:
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLSurface surface = EGL_NO_SURFACE;
+	EGLContext context = EGL_NO_CONTEXT;
+};
+#endif
+
+#ifdef CONTEXT_USE_OSMESA
+class OsMesaBackend : public GLContext {
+
+public:
+	~OsMesaBackend() {
+		if (context)
+			OSMesaDestroyContext(context);
+	}
+
+	bool init(int w, int h) {
+		const int attribs[] = {
+			OSMESA_FORMAT, OSMESA_RGBA,
+			OSMESA_DEPTH_BITS, 24,
+			OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+			OSMESA_CONTEXT_MAJOR_VERSION, 3,
+			OSMESA_CONTEXT_MINOR_VERSION, 3,
+			0
+		};
+		context = OSMesaCreateContextAttribs(attribs, NULL);
+		pixels.resize((size_t)w * h * 4);
+		if (!context || !OSMesaMakeCurrent(context, pixels.data(), GL_UNSIGNED_BYTE, w, h)) {
+			std::cout << "ERROR: OSMesa Context Failed" << std::endl;
+			return false;
+		}
+		if (!gladLoadGLLoader((GLADloadproc)OSMesaGetProcAddress)) {
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void present() override { glFlush(); }
+
+private:
+	OSMesaContext context = nullptr;
+	std::vector<unsigned char> pixels; // the default framebuffer
+};
+#endif
+
+std::unique_ptr<GLContext> GLContext::create(int backend, int width, int height, const char* title) {
+	std::unique_ptr<GLContext> context;
+	bool made = false;
+	if (backend == CONTEXT_WINDOW) {
+		WindowBackend* b = new WindowBackend();
+		context.reset(b);
+		made = b->init(width, height, title);
+	}
+#ifdef CONTEXT_EGL_BUILT
+	else if (backend == CONTEXT_EGL) {
+		EglBackend* b = new EglBackend();
+		context.reset(b);
+		made = b->init(width, height);
+	}
+#endif
+#ifdef CONTEXT_USE_OSMESA
+	else if (backend == CONTEXT_OSMESA) {
+		OsMesaBackend* b = new OsMesaBackend();
+		context.reset(b);
+		made = b->init(width, height);
+	}
+#endif
+	else
+		std::cout << "ERROR: Context Backend Not Built: " << backendName(backend) << std::endl;
+	if (!made)
+		return nullptr;
+	context->backend = backend;
+	context->width = width;
+	context->height = height;
+	return context;
+}
+
+int GLContext::parseBackend(const char* name) {
+	for (int b = CONTEXT_WINDOW; b <= CONTEXT_OSMESA; b++)
+		if (strcmp(name, backendName(b)) == 0)
+			return b;
+	return -1;
+}
+
+const char* GLContext::backendName(int backend) {
+	switch (backend) {
+	case CONTEXT_WINDOW: return "window";
+	case CONTEXT_EGL: return "egl";
+	case CONTEXT_OSMESA: return "osmesa";
+	}
+	return "unknown";
+}
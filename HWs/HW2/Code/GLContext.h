@@ -0,0 +1,45 @@
+#ifndef GLCONTEXT_H
+#define GLCONTEXT_H
+
+#include <memory>
+
+struct GLFWwindow;
+
+enum ContextBackend {
+	CONTEXT_WINDOW = 0, // glfw window, the only backend with input and the gui
+	CONTEXT_EGL = 1, // egl pbuffer on the surfaceless platform, needs no display server
+	CONTEXT_OSMESA = 2 // mesa rendering on the cpu into a buffer in memory
+};
+
+// an opengl 3.3 core context made current on the calling thread with glad loaded through it
+// every backend has a default framebuffer, the offscreen ones of the size asked for, so the
+// renderer draws the same way whichever made the context
+// egl is built on linux unless CONTEXT_NO_EGL is defined, osmesa only when CONTEXT_USE_OSMESA is
+// defined and libOSMesa linked, it is being dropped from newer mesa releases
+class GLContext {
+
+public:
+	// null when the backend is not built in or the context could not be made, the reason is printed
+	static std::unique_ptr<GLContext> create(int backend, int width, int height, const char* title);
+	// "window", "egl" or "osmesa", -1 for anything else
+	static int parseBackend(const char* name);
+	static const char* backendName(int backend);
+
+	virtual ~GLContext() {}
+
+	// shows the frame, the offscreen backends only flush
+	virtual void present() = 0;
+	virtual bool closing() const { return false; }
+	// framebuffer size, the window can be resized
+	virtual void getSize(int& w, int& h) const { w = width; h = height; }
+	virtual GLFWwindow* window() const { return nullptr; }
+
+	int getBackend() const { return backend; }
+
+protected:
+	int backend = CONTEXT_WINDOW;
+	int width = 0;
+	int height = 0;
+};
+
+#endif
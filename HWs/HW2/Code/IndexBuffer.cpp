@@ -2,7 +2,7 @@
 #include <glad/glad.h>
 
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : count(count)
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) : count(count), capacity(count)
 {
 	glGenBuffers(1, &rendererID);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID);
@@ -24,4 +24,15 @@ void IndexBuffer::Unbind() const
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
- 
+// binds the buffer to the element target, a vertex array bound at the time records it
+void IndexBuffer::UpdateData(const unsigned int* data, unsigned int count)
+{
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendererID);
+	if (count > capacity) {
+		capacity = count > 2 * capacity ? count : 2 * capacity;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, capacity * sizeof(unsigned int), NULL, GL_DYNAMIC_DRAW);
+	}
+	if (count > 0)
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, count * sizeof(unsigned int), data);
+	this->count = count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+
+// a vertex array with its buffers, attribute state is recorded once when a buffer is added
+// and updates go through the capacity aware buffers, so changing the data never touches the layout
+class MeshBuffer {
+
+private:
+	unsigned int vao;
+	std::vector<std::unique_ptr<VertexBuffer>> buffers;
+	std::vector<int> components; // floats per vertex of every buffer
+	std::unique_ptr<IndexBuffer> indices;
+public:
+	MeshBuffer();
+	~MeshBuffer();
+	MeshBuffer(const MeshBuffer&) = delete;
+	MeshBuffer& operator=(const MeshBuffer&) = delete;
+
+	// tightly packed float attribute in its own buffer, returns the buffer index for UpdateAttribute
+	int AddAttribute(unsigned int location, int components, const void* data, unsigned int size);
+	// same but advancing once per instance, add it after the vertex attributes
+	int AddInstanceAttribute(unsigned int location, int components, const void* data, unsigned int size);
+	void SetIndices(const unsigned int* data, unsigned int count);
+	void UpdateAttribute(int buffer, const void* data, unsigned int size);
+
+	void Bind() const;
+	void Unbind() const;
+
+	// vertices of the first attribute, indices when the mesh has them
+	unsigned int getCount() const;
+	inline bool isIndexed() const { return indices != nullptr; }
+};
@@ -0,0 +1,747 @@
+#include "MeshLoader.h"
+#include "Parallel.h"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <atomic>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define MESH_CACHE_MAGIC 0x4348534d // "MSHC"
+#define MESH_CACHE_VERSION 1
+
+void TriangleMesh::computeNormals() {
+	normals.assign(positions.size(), glm::vec3(0.0f));
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		// unnormalized cross product weights every face by its area
+		glm::vec3 n = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+		normals[a] += n;
+		normals[b] += n;
+		normals[c] += n;
+	}
+	for (auto& n : normals) {
+		float l = glm::length(n);
+		n = l > 0.0f ? n / l : glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+}
+
+void TriangleMesh::bounds(glm::vec3& bmin, glm::vec3& bmax) const {
+	bmin = glm::vec3(0.0f);
+	bmax = glm::vec3(0.0f);
+	if (positions.empty())
+		return;
+	bmin = bmax = positions[0];
+	for (const auto& p : positions) {
+		bmin = glm::min(bmin, p);
+		bmax = glm::max(bmax, p);
+	}
+}
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+	HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (f == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(f, &fileSize);
+	if (fileSize.QuadPart == 0) {
+		CloseHandle(f);
+		return;
+	}
+	HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m == NULL) {
+		CloseHandle(f);
+		return;
+	}
+	file = f;
+	mapping = m;
+	data = (const char*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return;
+	}
+	void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return;
+	madvise(p, st.st_size, MADV_SEQUENTIAL);
+	data = (const char*)p;
+	size = (size_t)st.st_size;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+#else
+	if (data)
+		munmap((void*)data, size);
+#endif
+}
+
+// FNV-1a over 64 bit words, chunks are hashed in parallel and folded in order
+uint64_t hashBytes(const char* data, size_t size) {
+	const size_t chunk = 1 << 22;
+	int chunks = (int)((size + chunk - 1) / chunk);
+	std::vector<uint64_t> partial(chunks);
+	ThreadPool::get().parallelFor(0, chunks, [&](int b, int e, int) {
+		for (int c = b; c < e; c++) {
+			const char* p = data + (size_t)c * chunk;
+			size_t n = std::min(chunk, size - (size_t)c * chunk);
+			uint64_t h = 14695981039346656037ull;
+			size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				uint64_t w;
+				memcpy(&w, p + i, 8);
+				h = (h ^ w) * 1099511628211ull;
+			}
+			for (; i < n; i++)
+				h = (h ^ (unsigned char)p[i]) * 1099511628211ull;
+			partial[c] = h;
+		}
+	});
+	uint64_t h = 14695981039346656037ull ^ size;
+	for (uint64_t p : partial)
+		h = (h ^ p) * 1099511628211ull;
+	return h;
+}
+
+// tokenizer helpers, these skip the locale handling of strtof which dominates parse time
+static inline bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skipSpace(const char* s, const char* end) {
+	while (s < end && isSpace(*s))
+		s++;
+	return s;
+}
+
+static inline const char* skipLine(const char* s, const char* end) {
+	const char* nl = (const char*)memchr(s, '\n', end - s);
+	return nl ? nl + 1 : end;
+}
+
+static inline const char* skipToken(const char* s, const char* end) {
+	while (s < end && !isSpace(*s) && *s != '\n')
+		s++;
+	return s;
+}
+
+static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static inline double pow10i(int e) {
+	if (e >= 0 && e <= 22)
+		return powersOf10[e];
+	if (e < 0 && e >= -22)
+		return 1.0 / powersOf10[-e];
+	return std::pow(10.0, e);
+}
+
+static inline const char* parseFloat(const char* s, const char* end, float& out) {
+	s = skipSpace(s, end);
+	bool neg = false;
+	if (s < end && (*s == '-' || *s == '+'))
+		neg = *s++ == '-';
+	uint64_t mant = 0;
+	int exp = 0;
+	int digits = 0;
+	while (s < end && *s >= '0' && *s <= '9') {
+		if (digits++ < 18)
+			mant = mant * 10 + (*s - '0');
+		else
+			exp++;
+		s++;
+	}
+	if (s < end && *s == '.') {
+		s++;
+		while (s < end && *s >= '0' && *s <= '9') {
+			if (digits++ < 18) {
+				mant = mant * 10 + (*s - '0');
+				exp--;
+			}
+			s++;
+		}
+	}
+	if (s < end && (*s == 'e' || *s == 'E')) {
+		s++;
+		bool eneg = false;
+		if (s < end && (*s == '-' || *s == '+'))
+			eneg = *s++ == '-';
+		int e = 0;
+		while (s < end && *s >= '0' && *s <= '9')
+			e = e * 10 + (*s++ - '0');
+		exp += eneg ? -e : e;
+	}
+	double v = (double)mant * pow10i(exp);
+	out = (float)(neg ? -v : v);
+	return s;
+}
+
+static inline const char* parseInt(const char* s, const char* end, long long& out) {
+	bool neg = false;
+	if (s < end && (*s == '-' || *s == '+'))
+		neg = *s++ == '-';
+	long long v = 0;
+	while (s < end && *s >= '0' && *s <= '9')
+		v = v * 10 + (*s++ - '0');
+	out = neg ? -v : v;
+	return s;
+}
+
+// splits the buffer into count pieces that each start at the beginning of a line
+static std::vector<const char*> lineChunks(const char* data, size_t size, int count) {
+	std::vector<const char*> cuts(count + 1);
+	const char* end = data + size;
+	cuts[0] = data;
+	for (int i = 1; i < count; i++) {
+		const char* c = data + size * i / count;
+		cuts[i] = c < cuts[i - 1] ? cuts[i - 1] : skipLine(c == data ? c : c - 1, end);
+	}
+	cuts[count] = end;
+	return cuts;
+}
+
+struct ObjChunkCounts {
+	size_t v = 0;
+	size_t vn = 0;
+	size_t tris = 0;
+};
+
+bool parseOBJ(const char* data, size_t size, TriangleMesh& mesh) {
+	ThreadPool& pool = ThreadPool::get();
+	int chunkCount = std::max(1, std::min(pool.size(), (int)(size >> 16)));
+	std::vector<const char*> cuts = lineChunks(data, size, chunkCount);
+	std::vector<ObjChunkCounts> counts(chunkCount);
+
+	// pass 1, count so every chunk knows where its vertices and triangles go
+	pool.parallelFor(0, chunkCount, [&](int b, int e, int) {
+		for (int c = b; c < e; c++) {
+			const char* s = cuts[c];
+			const char* end = cuts[c + 1];
+			ObjChunkCounts& cc = counts[c];
+			while (s < end) {
+				s = skipSpace(s, end);
+				if (s + 1 < end && s[0] == 'v' && isSpace(s[1]))
+					cc.v++;
+				else if (s + 2 < end && s[0] == 'v' && s[1] == 'n' && isSpace(s[2]))
+					cc.vn++;
+				else if (s + 1 < end && s[0] == 'f' && isSpace(s[1])) {
+					const char* t = s + 1;
+					int corners = 0;
+					while (true) {
+						t = skipSpace(t, end);
+						if (t >= end || *t == '\n' || *t == '#')
+							break;
+						t = skipToken(t, end);
+						corners++;
+					}
+					if (corners >= 3)
+						cc.tris += corners - 2;
+				}
+				s = skipLine(s, end);
+			}
+		}
+	});
+
+	std::vector<ObjChunkCounts> offsets(chunkCount);
+	ObjChunkCounts total;
+	for (int c = 0; c < chunkCount; c++) {
+		offsets[c] = total;
+		total.v += counts[c].v;
+		total.vn += counts[c].vn;
+		total.tris += counts[c].tris;
+	}
+
+	mesh.positions.resize(total.v);
+	mesh.indices.resize(total.tris * 3);
+	std::vector<glm::vec3> fileNormals(total.vn);
+	std::vector<int> cornerNormals(total.vn > 0 ? total.tris * 3 : 0, -1);
+	std::atomic<bool> valid(true);
+
+	// pass 2, parse straight into the final arrays
+	pool.parallelFor(0, chunkCount, [&](int b, int e, int) {
+		for (int c = b; c < e; c++) {
+			const char* s = cuts[c];
+			const char* end = cuts[c + 1];
+			size_t v = offsets[c].v;
+			size_t vn = offsets[c].vn;
+			size_t idx = offsets[c].tris * 3;
+			long long corner[3];
+			long long cornerN[3];
+			while (s < end) {
+				s = skipSpace(s, end);
+				if (s + 1 < end && s[0] == 'v' && isSpace(s[1])) {
+					glm::vec3& p = mesh.positions[v++];
+					s = parseFloat(s + 1, end, p.x);
+					s = parseFloat(s, end, p.y);
+					s = parseFloat(s, end, p.z);
+				}
+				else if (s + 2 < end && s[0] == 'v' && s[1] == 'n' && isSpace(s[2])) {
+					glm::vec3& n = fileNormals[vn++];
+					s = parseFloat(s + 2, end, n.x);
+					s = parseFloat(s, end, n.y);
+					s = parseFloat(s, end, n.z);
+				}
+				else if (s + 1 < end && s[0] == 'f' && isSpace(s[1])) {
+					s++;
+					int k = 0;
+					while (true) {
+						s = skipSpace(s, end);
+						if (s >= end || *s == '\n' || *s == '#')
+							break;
+						long long vi = 0, ti = 0, ni = 0;
+						s = parseInt(s, end, vi);
+						if (s < end && *s == '/') {
+							s++;
+							if (s < end && *s != '/')
+								s = parseInt(s, end, ti);
+							if (s < end && *s == '/')
+								s = parseInt(s + 1, end, ni);
+						}
+						s = skipToken(s, end);
+						// negative indices count back from the vertices read so far
+						vi = vi < 0 ? (long long)v + vi : vi - 1;
+						ni = ni < 0 ? (long long)vn + ni : ni - 1;
+						if (vi < 0 || vi >= (long long)total.v) {
+							valid = false;
+							vi = 0;
+						}
+						if (k < 2) {
+							corner[k] = vi;
+							cornerN[k] = ni;
+						}
+						else {
+							corner[2] = vi;
+							cornerN[2] = ni;
+							for (int j = 0; j < 3; j++) {
+								if (!cornerNormals.empty())
+									cornerNormals[idx] = (int)cornerN[j];
+								mesh.indices[idx++] = (unsigned int)corner[j];
+							}
+							// fan triangulation for polygons
+							corner[1] = corner[2];
+							cornerN[1] = cornerN[2];
+						}
+						k++;
+					}
+				}
+				s = skipLine(s, end);
+			}
+		}
+	});
+
+	if (!valid) {
+		std::cout << "ERROR: OBJ face references a missing vertex" << std::endl;
+		return false;
+	}
+
+	if (!fileNormals.empty()) {
+		mesh.normals.assign(mesh.positions.size(), glm::vec3(0.0f));
+		bool complete = true;
+		for (size_t i = 0; i < mesh.indices.size(); i++) {
+			int n = cornerNormals[i];
+			if (n >= 0 && n < (int)fileNormals.size())
+				mesh.normals[mesh.indices[i]] = fileNormals[n];
+			else
+				complete = false;
+		}
+		if (complete)
+			return true;
+	}
+	mesh.computeNormals();
+	return true;
+}
+
+enum PlyType { PLY_CHAR, PLY_UCHAR, PLY_SHORT, PLY_USHORT, PLY_INT, PLY_UINT, PLY_FLOAT, PLY_DOUBLE, PLY_INVALID };
+
+struct PlyProperty {
+	std::string name;
+	PlyType type = PLY_INVALID;
+	bool isList = false;
+	PlyType countType = PLY_INVALID;
+};
+
+struct PlyElement {
+	std::string name;
+	size_t count = 0;
+	std::vector<PlyProperty> properties;
+};
+
+static PlyType plyType(const std::string& t) {
+	if (t == "char" || t == "int8") return PLY_CHAR;
+	if (t == "uchar" || t == "uint8") return PLY_UCHAR;
+	if (t == "short" || t == "int16") return PLY_SHORT;
+	if (t == "ushort" || t == "uint16") return PLY_USHORT;
+	if (t == "int" || t == "int32") return PLY_INT;
+	if (t == "uint" || t == "uint32") return PLY_UINT;
+	if (t == "float" || t == "float32") return PLY_FLOAT;
+	if (t == "double" || t == "float64") return PLY_DOUBLE;
+	return PLY_INVALID;
+}
+
+static int plySize(PlyType t) {
+	static const int sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+	return sizes[t];
+}
+
+static double plyRead(const char* p, PlyType t, bool swap) {
+	unsigned char b[8];
+	int n = plySize(t);
+	for (int i = 0; i < n; i++)
+		b[i] = p[swap ? n - 1 - i : i];
+	switch (t) {
+	case PLY_CHAR: return (double)(signed char)b[0];
+	case PLY_UCHAR: return (double)b[0];
+	case PLY_SHORT: { int16_t v; memcpy(&v, b, 2); return v; }
+	case PLY_USHORT: { uint16_t v; memcpy(&v, b, 2); return v; }
+	case PLY_INT: { int32_t v; memcpy(&v, b, 4); return v; }
+	case PLY_UINT: { uint32_t v; memcpy(&v, b, 4); return v; }
+	case PLY_FLOAT: { float v; memcpy(&v, b, 4); return v; }
+	case PLY_DOUBLE: { double v; memcpy(&v, b, 8); return v; }
+	default: return 0.0;
+	}
+}
+
+bool parsePLY(const char* data, size_t size, TriangleMesh& mesh) {
+	const char* end = data + size;
+	const char* s = data;
+	std::vector<PlyElement> elements;
+	int format = -1; // 0 ascii, 1 little endian, 2 big endian
+
+	while (s < end) {
+		const char* lineEnd = skipLine(s, end);
+		std::string line(s, lineEnd);
+		s = lineEnd;
+		while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+			line.pop_back();
+		char a[64] = {}, b[64] = {}, c[64] = {}, d[64] = {}, e[64] = {};
+		int fields = sscanf(line.c_str(), "%63s %63s %63s %63s %63s", a, b, c, d, e);
+		if (fields <= 0)
+			continue;
+		if (!strcmp(a, "end_header"))
+			break;
+		if (!strcmp(a, "format")) {
+			if (!strcmp(b, "ascii")) format = 0;
+			else if (!strcmp(b, "binary_little_endian")) format = 1;
+			else if (!strcmp(b, "binary_big_endian")) format = 2;
+		}
+		else if (!strcmp(a, "element") && fields >= 3) {
+			PlyElement el;
+			el.name = b;
+			el.count = (size_t)strtoull(c, NULL, 10);
+			elements.push_back(el);
+		}
+		else if (!strcmp(a, "property") && !elements.empty()) {
+			PlyProperty prop;
+			if (!strcmp(b, "list") && fields >= 5) {
+				prop.isList = true;
+				prop.countType = plyType(c);
+				prop.type = plyType(d);
+				prop.name = e;
+			}
+			else if (fields >= 3) {
+				prop.type = plyType(b);
+				prop.name = c;
+			}
+			elements.back().properties.push_back(prop);
+		}
+	}
+
+	if (format < 0) {
+		std::cout << "ERROR: PLY header has no known format" << std::endl;
+		return false;
+	}
+
+	bool swap = format == 2;
+	bool hasNormals = false;
+	std::vector<glm::vec3> positions;
+	std::vector<unsigned int> indices;
+	ThreadPool& pool = ThreadPool::get();
+
+	for (const PlyElement& el : elements) {
+		int px = -1, py = -1, pz = -1, nx = -1, ny = -1, nz = -1, list = -1;
+		bool fixedSize = true;
+		std::vector<int> offset(el.properties.size());
+		int stride = 0;
+		for (int i = 0; i < (int)el.properties.size(); i++) {
+			const PlyProperty& prop = el.properties[i];
+			if (prop.type == PLY_INVALID || (prop.isList && prop.countType == PLY_INVALID)) {
+				std::cout << "ERROR: PLY property " << prop.name << " has an unknown type" << std::endl;
+				return false;
+			}
+			offset[i] = stride;
+			if (prop.isList)
+				fixedSize = false;
+			else
+				stride += plySize(prop.type);
+			if (prop.name == "x") px = i;
+			else if (prop.name == "y") py = i;
+			else if (prop.name == "z") pz = i;
+			else if (prop.name == "nx") nx = i;
+			else if (prop.name == "ny") ny = i;
+			else if (prop.name == "nz") nz = i;
+			else if (prop.isList && (prop.name == "vertex_indices" || prop.name == "vertex_index")) list = i;
+		}
+
+		if (el.name == "vertex") {
+			positions.resize(el.count);
+			hasNormals = nx >= 0 && ny >= 0 && nz >= 0;
+			if (hasNormals)
+				mesh.normals.resize(el.count);
+		}
+
+		if (format == 0) {
+			// ascii, one element per line
+			for (size_t r = 0; r < el.count && s < end; r++) {
+				if (el.name == "face" && list >= 0) {
+					long long cnt = 0;
+					s = skipSpace(s, end);
+					s = parseInt(s, end, cnt);
+					long long first = 0, prev = 0, cur = 0;
+					for (long long k = 0; k < cnt; k++) {
+						s = skipSpace(s, end);
+						s = parseInt(s, end, cur);
+						if (k == 0) first = cur;
+						else if (k >= 2) {
+							indices.push_back((unsigned int)first);
+							indices.push_back((unsigned int)prev);
+							indices.push_back((unsigned int)cur);
+						}
+						prev = cur;
+					}
+				}
+				else if (el.name == "vertex") {
+					for (int i = 0; i < (int)el.properties.size(); i++) {
+						float f = 0.0f;
+						s = parseFloat(s, end, f);
+						if (i == px) positions[r].x = f;
+						else if (i == py) positions[r].y = f;
+						else if (i == pz) positions[r].z = f;
+						else if (i == nx) mesh.normals[r].x = f;
+						else if (i == ny) mesh.normals[r].y = f;
+						else if (i == nz) mesh.normals[r].z = f;
+					}
+				}
+				s = skipLine(s, end);
+			}
+			continue;
+		}
+
+		if (fixedSize) {
+			// binary with a fixed stride, rows can be decoded in parallel
+			if ((size_t)(end - s) < el.count * stride) {
+				std::cout << "ERROR: PLY element " << el.name << " is truncated" << std::endl;
+				return false;
+			}
+			if (el.name == "vertex") {
+				const char* base = s;
+				pool.parallelFor(0, (int)el.count, [&](int b, int e, int) {
+					for (int r = b; r < e; r++) {
+						const char* row = base + (size_t)r * stride;
+						auto read = [&](int i) { return i >= 0 ? (float)plyRead(row + offset[i], el.properties[i].type, swap) : 0.0f; };
+						positions[r] = glm::vec3(read(px), read(py), read(pz));
+						if (hasNormals)
+							mesh.normals[r] = glm::vec3(read(nx), read(ny), read(nz));
+					}
+				}, 4096);
+			}
+			s += el.count * stride;
+			continue;
+		}
+
+		if (el.name != "face" || list < 0) {
+			std::cout << "ERROR: PLY element " << el.name << " has variable size rows" << std::endl;
+			return false;
+		}
+
+		// faces, the common all-triangles layout has a fixed row size and is decoded in parallel
+		const PlyProperty& lp = el.properties[list];
+		int countSize = plySize(lp.countType);
+		int indexSize = plySize(lp.type);
+		int triRow = countSize + 3 * indexSize;
+		bool allTriangles = el.properties.size() == 1 && (size_t)(end - s) >= el.count * triRow;
+		for (size_t r = 0; allTriangles && r < el.count; r += std::max<size_t>(1, el.count / 64))
+			allTriangles = plyRead(s + r * triRow, lp.countType, swap) == 3.0;
+
+		if (allTriangles) {
+			size_t first = indices.size();
+			indices.resize(first + el.count * 3);
+			const char* base = s;
+			std::atomic<bool> valid(true);
+			pool.parallelFor(0, (int)el.count, [&](int b, int e, int) {
+				for (int r = b; r < e; r++) {
+					const char* row = base + (size_t)r * triRow;
+					if (plyRead(row, lp.countType, swap) != 3.0)
+						valid = false;
+					for (int k = 0; k < 3; k++)
+						indices[first + (size_t)r * 3 + k] = (unsigned int)plyRead(row + countSize + k * indexSize, lp.type, swap);
+				}
+			}, 4096);
+			if (!valid) {
+				std::cout << "ERROR: PLY face list is not all triangles" << std::endl;
+				return false;
+			}
+			s += el.count * triRow;
+			continue;
+		}
+
+		for (size_t r = 0; r < el.count; r++) {
+			if (s >= end)
+				return false;
+			for (int i = 0; i < (int)el.properties.size(); i++) {
+				const PlyProperty& prop = el.properties[i];
+				if (!prop.isList) {
+					s += plySize(prop.type);
+					continue;
+				}
+				int cnt = (int)plyRead(s, prop.countType, swap);
+				s += plySize(prop.countType);
+				if (i == list) {
+					unsigned int first = 0, prev = 0;
+					for (int k = 0; k < cnt; k++) {
+						unsigned int cur = (unsigned int)plyRead(s + k * plySize(prop.type), prop.type, swap);
+						if (k == 0) first = cur;
+						else if (k >= 2) {
+							indices.push_back(first);
+							indices.push_back(prev);
+							indices.push_back(cur);
+						}
+						prev = cur;
+					}
+				}
+				s += cnt * plySize(prop.type);
+			}
+		}
+	}
+
+	for (unsigned int i : indices) {
+		if (i >= positions.size()) {
+			std::cout << "ERROR: PLY face references a missing vertex" << std::endl;
+			return false;
+		}
+	}
+
+	mesh.positions = std::move(positions);
+	mesh.indices = std::move(indices);
+	if (!hasNormals)
+		mesh.computeNormals();
+	return true;
+}
+
+struct MeshCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t hash;
+	int64_t mtime;
+	uint64_t fileSize;
+	uint64_t vertexCount;
+	uint64_t indexCount;
+};
+
+static bool readCache(const std::string& cachePath, const MeshCacheHeader& expect, TriangleMesh& mesh) {
+	MappedFile cache(cachePath);
+	if (!cache.isOpen() || cache.getSize() < sizeof(MeshCacheHeader))
+		return false;
+	MeshCacheHeader header;
+	memcpy(&header, cache.getData(), sizeof(header));
+	if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION ||
+		header.hash != expect.hash || header.mtime != expect.mtime || header.fileSize != expect.fileSize)
+		return false;
+	size_t vbytes = header.vertexCount * sizeof(glm::vec3);
+	size_t ibytes = header.indexCount * sizeof(unsigned int);
+	if (cache.getSize() != sizeof(header) + 2 * vbytes + ibytes)
+		return false;
+	const char* p = cache.getData() + sizeof(header);
+	mesh.positions.resize(header.vertexCount);
+	mesh.normals.resize(header.vertexCount);
+	mesh.indices.resize(header.indexCount);
+	memcpy(mesh.positions.data(), p, vbytes);
+	memcpy(mesh.normals.data(), p + vbytes, vbytes);
+	memcpy(mesh.indices.data(), p + 2 * vbytes, ibytes);
+	return true;
+}
+
+static void writeCache(const std::string& cachePath, MeshCacheHeader header, const TriangleMesh& mesh) {
+	header.vertexCount = mesh.positions.size();
+	header.indexCount = mesh.indices.size();
+	// write to a temporary and rename so a crash never leaves a half written cache behind
+	std::string tmp = cachePath + ".tmp";
+	std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+	if (!out)
+		return;
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)mesh.positions.data(), mesh.positions.size() * sizeof(glm::vec3));
+	out.write((const char*)mesh.normals.data(), mesh.normals.size() * sizeof(glm::vec3));
+	out.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+	out.close();
+	std::error_code ec;
+	std::filesystem::rename(tmp, cachePath, ec);
+	if (ec)
+		std::filesystem::remove(tmp, ec);
+}
+
+bool loadMesh(const std::string& path, TriangleMesh& mesh, bool useCache) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		std::cout << "ERROR: Mesh File Reading Failed: " << path << std::endl;
+		return false;
+	}
+
+	std::error_code ec;
+	MeshCacheHeader header = {};
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.fileSize = file.getSize();
+	header.mtime = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	std::string cachePath = path + ".mcache";
+
+	if (useCache) {
+		header.hash = hashBytes(file.getData(), file.getSize());
+		if (readCache(cachePath, header, mesh))
+			return true;
+	}
+
+	std::string ext = std::filesystem::path(path).extension().string();
+	for (auto& ch : ext)
+		ch = (char)tolower(ch);
+
+	mesh = TriangleMesh();
+	bool ok;
+	if (ext == ".ply")
+		ok = parsePLY(file.getData(), file.getSize(), mesh);
+	else
+		ok = parseOBJ(file.getData(), file.getSize(), mesh);
+
+	if (!ok) {
+		std::cout << "ERROR: Mesh Parsing Failed: " << path << std::endl;
+		return false;
+	}
+
+	if (useCache)
+		writeCache(cachePath, header, mesh);
+	return true;
+}
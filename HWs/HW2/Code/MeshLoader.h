@@ -0,0 +1,49 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// indexed triangle mesh, shared by the colliders and the renderer
+struct TriangleMesh {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals; // per vertex, same size as positions
+	std::vector<unsigned int> indices; // 3 per triangle
+
+	int triangleCount() const { return (int)indices.size() / 3; }
+	void computeNormals();
+	void bounds(glm::vec3& bmin, glm::vec3& bmax) const;
+};
+
+// read only memory mapping of a whole file
+class MappedFile {
+
+public:
+	MappedFile(const std::string& path);
+	~MappedFile();
+
+	bool isOpen() const { return data != nullptr; }
+	const char* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// loads an .obj or .ply, the parsed result is stored next to the file as <path>.mcache and
+// reused on later loads as long as the file size, mtime and content hash still match
+bool loadMesh(const std::string& path, TriangleMesh& mesh, bool useCache = true);
+
+bool parseOBJ(const char* data, size_t size, TriangleMesh& mesh);
+bool parsePLY(const char* data, size_t size, TriangleMesh& mesh);
+
+uint64_t hashBytes(const char* data, size_t size);
+
+#endif
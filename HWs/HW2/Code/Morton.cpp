@@ -0,0 +1,97 @@
+#include "Morton.h"
+#include "Parallel.h"
+#include "Arena.h"
+
+#include <cstring>
+#include <algorithm>
+
+#define MORTON_GRAIN 16384
+
+void MortonSorter::sort(ParticleData& pd) {
+	sortRange(pd, 0, pd.n_awake);
+	sortRange(pd, pd.n_awake, pd.n_alive);
+}
+
+// tmp holds n values of the widest column
+template <class T>
+static void permute(T* column, int begin, int end, const uint32_t* order, void* tmp) {
+	int n = end - begin;
+	T* dst = (T*)tmp;
+	T* src = column + begin;
+	ThreadPool::get().parallelFor(0, n, [&](int b, int e, int) {
+		for (int i = b; i < e; i++)
+			dst[i] = src[order[i]];
+	}, MORTON_GRAIN);
+	memcpy(src, dst, n * sizeof(T));
+}
+
+void MortonSorter::sortRange(ParticleData& pd, int begin, int end) {
+	int n = end - begin;
+	if (n <= 1)
+		return;
+	ThreadPool& pool = ThreadPool::get();
+	Arena& frame = Arena::frame();
+	size_t mark = frame.mark();
+
+	// bounds of the range, the codes are quantized inside them
+	int ranges = pool.rangeCount(0, n, MORTON_GRAIN);
+	glm::vec3* rmin = frame.alloc<glm::vec3>(ranges);
+	glm::vec3* rmax = frame.alloc<glm::vec3>(ranges);
+	std::fill(rmin, rmin + ranges, pd.p[begin]);
+	std::fill(rmax, rmax + ranges, pd.p[begin]);
+	const glm::vec3* p = &pd.p[begin];
+	pool.parallelFor(0, n, [&](int b, int e, int r) {
+		for (int i = b; i < e; i++) {
+			rmin[r] = glm::min(rmin[r], p[i]);
+			rmax[r] = glm::max(rmax[r], p[i]);
+		}
+	}, MORTON_GRAIN);
+	glm::vec3 bmin = rmin[0], bmax = rmax[0];
+	for (int r = 1; r < ranges; r++) {
+		bmin = glm::min(bmin, rmin[r]);
+		bmax = glm::max(bmax, rmax[r]);
+	}
+	glm::vec3 ext = glm::max(bmax - bmin, glm::vec3(1e-6f));
+
+	uint32_t* order = frame.alloc<uint32_t>(n);
+	if (wide) {
+		uint64_t* keys63 = frame.alloc<uint64_t>(n);
+		glm::vec3 scale = glm::vec3((float)0x1FFFFF) / ext;
+		pool.parallelFor(0, n, [&](int b, int e, int) {
+			for (int i = b; i < e; i++) {
+				glm::vec3 q = (p[i] - bmin) * scale;
+				keys63[i] = morton63((uint64_t)q.x, (uint64_t)q.y, (uint64_t)q.z);
+				order[i] = i;
+			}
+		}, MORTON_GRAIN);
+		sorter63.sort(keys63, order, n);
+	}
+	else {
+		uint32_t* keys30 = frame.alloc<uint32_t>(n);
+		glm::vec3 scale = glm::vec3((float)0x3FF) / ext;
+		pool.parallelFor(0, n, [&](int b, int e, int) {
+			for (int i = b; i < e; i++) {
+				glm::vec3 q = (p[i] - bmin) * scale;
+				keys30[i] = morton30((uint32_t)q.x, (uint32_t)q.y, (uint32_t)q.z);
+				order[i] = i;
+			}
+		}, MORTON_GRAIN);
+		sorter30.sort(keys30, order, n);
+	}
+
+	void* tmp = frame.alloc<glm::vec3>(n);
+	permute(pd.p, begin, end, order, tmp);
+	permute(pd.c, begin, end, order, tmp);
+	permute(pd.v, begin, end, order, tmp);
+	permute(pd.a, begin, end, order, tmp);
+	permute(pd.m, begin, end, order, tmp);
+	permute(pd.LS, begin, end, order, tmp);
+	permute(pd.COF, begin, end, order, tmp);
+	permute(pd.COR, begin, end, order, tmp);
+	permute(pd.age, begin, end, order, tmp);
+	permute(pd.alive, begin, end, order, tmp);
+	permute(pd.restSteps, begin, end, order, tmp);
+	permute(pd.id, begin, end, order, tmp);
+	permute(pd.slot, begin, end, order, tmp);
+	frame.rewind(mark);
+}
@@ -0,0 +1,55 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "ParticleData.h"
+#include "RadixSort.h"
+
+// interleaves 10 bits per axis into a 30 bit code
+inline uint32_t morton30(uint32_t x, uint32_t y, uint32_t z) {
+	auto spread = [](uint32_t v) {
+		v &= 0x3FF;
+		v = (v | (v << 16)) & 0x030000FF;
+		v = (v | (v << 8)) & 0x0300F00F;
+		v = (v | (v << 4)) & 0x030C30C3;
+		v = (v | (v << 2)) & 0x09249249;
+		return v;
+	};
+	return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+}
+
+// interleaves 21 bits per axis into a 63 bit code
+inline uint64_t morton63(uint64_t x, uint64_t y, uint64_t z) {
+	auto spread = [](uint64_t v) {
+		v &= 0x1FFFFF;
+		v = (v | (v << 32)) & 0x001F00000000FFFFull;
+		v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+		v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+		v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+		v = (v | (v << 2)) & 0x1249249249249249ull;
+		return v;
+	};
+	return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+}
+
+// reorders the particle columns along a z-order curve so particles close in space are close
+// in memory, the awake and sleeping partitions are sorted separately
+// codes, order and the column copy are frame scratch
+class MortonSorter {
+
+public:
+	bool wide = false; // 63 bit codes instead of 30 bit
+
+	void sort(ParticleData& pd);
+
+private:
+	void sortRange(ParticleData& pd, int begin, int end);
+
+	RadixSorter<uint32_t> sorter30;
+	RadixSorter<uint64_t> sorter63;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <string>
+
+#include "Trace.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+ThreadPool::ThreadPool(int threads) : nextRange(0) {
+	if (threads <= 0)
+		threads = std::max(1, (int)std::thread::hardware_concurrency());
+	threadIds.assign(threads - 1, 0);
+	for (int i = 1; i < threads; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return started == (int)workers.size(); });
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto& w : workers)
+		w.join();
+}
+
+ThreadPool& ThreadPool::get() {
+	static ThreadPool pool;
+	return pool;
+}
+
+int ThreadPool::rangeCount(int begin, int end, int minGrain) const {
+	int n = end - begin;
+	if (n <= 0)
+		return 0;
+	int ranges = std::min(size(), (n + minGrain - 1) / std::max(minGrain, 1));
+	return std::max(ranges, 1);
+}
+
+void ThreadPool::run(int begin, int end, const void* f, JobCall call, int minGrain) {
+	int ranges = rangeCount(begin, end, minGrain);
+	if (ranges == 0)
+		return;
+	if (ranges == 1) {
+		call(f, begin, end, 0);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	job = f;
+	jobCall = call;
+	jobBegin = begin;
+	jobEnd = end;
+	jobRanges = ranges;
+	jobStep = (end - begin + ranges - 1) / ranges;
+	nextRange = 0;
+	pending = (int)workers.size();
+	generation++;
+	lock.unlock();
+	wake.notify_all();
+
+	runRanges();
+
+	lock.lock();
+	done.wait(lock, [this] { return pending == 0; });
+	job = nullptr;
+}
+
+void ThreadPool::runRanges() {
+	int r;
+	while ((r = nextRange++) < jobRanges) {
+		int b = jobBegin + r * jobStep;
+		int e = std::min(jobEnd, b + jobStep);
+		if (b < e) {
+			TRACE_SCOPE("Range");
+			jobCall(job, b, e, r);
+		}
+	}
+}
+
+void ThreadPool::workerLoop(int index) {
+	Tracer::get().setThreadName("Worker " + std::to_string(index));
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+#ifdef __linux__
+		threadIds[index - 1] = (int)syscall(SYS_gettid);
+#endif
+		started++;
+	}
+	done.notify_one();
+	unsigned int seen = 0;
+	while (true) {
+		std::unique_lock<std::mutex> lock(mutex);
+		wake.wait(lock, [&] { return quit || generation != seen; });
+		if (quit)
+			return;
+		seen = generation;
+		lock.unlock();
+
+		runRanges();
+
+		lock.lock();
+		if (--pending == 0)
+			done.notify_one();
+	}
+}
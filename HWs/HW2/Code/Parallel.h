@@ -0,0 +1,61 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// persistent worker threads, the calling thread takes part in every job so a pool of
+// size 1 runs everything inline
+class ThreadPool {
+
+public:
+	ThreadPool(int threads = 0);
+	~ThreadPool();
+
+	static ThreadPool& get();
+
+	int size() const { return (int)workers.size() + 1; }
+	// kernel thread ids of the workers on linux, for counters that follow them, 0 elsewhere
+	const std::vector<int>& workerThreadIds() const { return threadIds; }
+
+	// splits [begin, end) into contiguous ranges of at least minGrain items and calls
+	// f(rangeBegin, rangeEnd, rangeIndex) on them, returns once every range is done
+	// rangeIndex is in [0, rangeCount(begin, end, minGrain)), jobs must not nest
+	// f is called through a plain function pointer, a std::function would allocate for every
+	// lambda capturing more than a couple of references
+	template <class F>
+	void parallelFor(int begin, int end, const F& f, int minGrain = 1) {
+		run(begin, end, &f, [](const void* job, int b, int e, int r) { (*(const F*)job)(b, e, r); }, minGrain);
+	}
+	int rangeCount(int begin, int end, int minGrain = 1) const;
+
+private:
+	typedef void (*JobCall)(const void* job, int b, int e, int r);
+
+	void run(int begin, int end, const void* f, JobCall call, int minGrain);
+	void workerLoop(int index);
+	void runRanges();
+
+	std::vector<std::thread> workers;
+	std::vector<int> threadIds; // written by each worker before the constructor returns
+	int started = 0;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	const void* job = nullptr;
+	JobCall jobCall = nullptr;
+	int jobBegin = 0;
+	int jobStep = 0;
+	int jobEnd = 0;
+	int jobRanges = 0;
+	std::atomic<int> nextRange;
+	int pending = 0;
+	unsigned int generation = 0;
+	bool quit = false;
+};
+
+#endif
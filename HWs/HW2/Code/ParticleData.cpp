@@ -1 +1,159 @@
-#include "ParticleSystem.h"
+#include "ParticleData.h"
+
+#include <algorithm>
+
+size_t ParticleData::storageBytes(int maxParticles) {
+	return 4 * arenaBytes<glm::vec3>(maxParticles) + 5 * arenaBytes<float>(maxParticles) +
+		arenaBytes<bool>(maxParticles) + 2 * arenaBytes<int>(maxParticles) + arenaBytes<unsigned int>(maxParticles);
+}
+
+void ParticleData::genParticle(int maxParticles, Arena& arena) {
+	n = maxParticles;
+	n_alive = 0;
+	n_awake = 0;
+	nextId = 0;
+	p = arena.alloc<glm::vec3>(maxParticles);
+	c = arena.alloc<glm::vec3>(maxParticles);
+	v = arena.alloc<glm::vec3>(maxParticles);
+	a = arena.alloc<glm::vec3>(maxParticles);
+	m = arena.alloc<float>(maxParticles);
+	LS = arena.alloc<float>(maxParticles);
+	COF = arena.alloc<float>(maxParticles);
+	COR = arena.alloc<float>(maxParticles);
+	age = arena.alloc<float>(maxParticles);
+	alive = arena.alloc<bool>(maxParticles);
+	restSteps = arena.alloc<int>(maxParticles);
+	id = arena.alloc<unsigned int>(maxParticles);
+	slot = arena.alloc<int>(maxParticles);
+	for (int i = 0; i < maxParticles; i++) {
+		alive[i] = false;
+		slot[i] = i;
+	}
+}
+
+void ParticleData::swapData(int a, int b) {
+	std::swap(p[a], p[b]);
+	std::swap(c[a], c[b]);
+	std::swap(v[a], v[b]);
+	std::swap(this->a[a], this->a[b]);
+	std::swap(m[a], m[b]);
+	std::swap(LS[a], LS[b]);
+	std::swap(COF[a], COF[b]);
+	std::swap(COR[a], COR[b]);
+	std::swap(age[a], age[b]);
+	std::swap(alive[a], alive[b]);
+	std::swap(restSteps[a], restSteps[b]);
+	std::swap(this->id[a], this->id[b]);
+	std::swap(slot[a], slot[b]);
+}
+
+// claims the next free slot, returns -1 when the storage is full
+// new particles are awake, the first sleeping particle is moved to the end to make room
+int ParticleData::emit() {
+	if (n_alive >= n)
+		return -1;
+	int id = n_alive++;
+	if (id != n_awake) {
+		swapData(id, n_awake);
+		id = n_awake;
+	}
+	n_awake++;
+	alive[id] = true;
+	a[id] = glm::vec3(0.0f);
+	age[id] = 0.0f;
+	restSteps[id] = 0;
+	this->id[id] = nextId++;
+	return id;
+}
+
+// moves the dead particle past the live range so [0, n_alive) stays packed
+void ParticleData::kill(int id) {
+	if (id < n_awake) {
+		swapData(id, n_awake - 1);
+		id = n_awake - 1;
+		n_awake--;
+	}
+	alive[id] = false;
+	swapData(id, n_alive - 1);
+	n_alive--;
+}
+
+void ParticleData::reset() {
+	for (int i = 0; i < n_alive; i++) {
+		alive[i] = false;
+	}
+	n_alive = 0;
+	n_awake = 0;
+	nextId = 0;
+}
+
+// swapping with the last awake particle keeps both partitions packed, so callers walking the
+// awake range should go from the back
+void ParticleData::sleep(int id) {
+	if (id >= n_awake)
+		return;
+	swapData(id, n_awake - 1);
+	n_awake--;
+	v[n_awake] = glm::vec3(0.0f);
+	a[n_awake] = glm::vec3(0.0f);
+}
+
+void ParticleData::wake(int id) {
+	if (id < n_awake || id >= n_alive)
+		return;
+	swapData(id, n_awake);
+	restSteps[n_awake] = 0;
+	n_awake++;
+}
+
+void ParticleData::wakeAll() {
+	for (int i = n_awake; i < n_alive; i++)
+		restSteps[i] = 0;
+	n_awake = n_alive;
+}
+
+void ParticleData::wakeRegion(const glm::vec3& bmin, const glm::vec3& bmax) {
+	// wake swaps the woken particle to n_awake, so i only advances past ones that stay asleep
+	int i = n_awake;
+	while (i < n_alive) {
+		const glm::vec3& q = p[i];
+		if (q.x >= bmin.x && q.y >= bmin.y && q.z >= bmin.z && q.x <= bmax.x && q.y <= bmax.y && q.z <= bmax.z) {
+			wake(i);
+			i = std::max(i, n_awake);
+		}
+		else
+			i++;
+	}
+}
+
+void ParticleData::wakeNear(const glm::vec3* points, int count, float radius) {
+	if (count == 0 || n_awake == n_alive)
+		return;
+	glm::vec3 bmin = points[0], bmax = points[0];
+	for (int k = 1; k < count; k++) {
+		bmin = glm::min(bmin, points[k]);
+		bmax = glm::max(bmax, points[k]);
+	}
+	bmin -= glm::vec3(radius);
+	bmax += glm::vec3(radius);
+	float r2 = radius * radius;
+	int i = n_awake;
+	while (i < n_alive) {
+		const glm::vec3& q = p[i];
+		bool woken = false;
+		if (q.x >= bmin.x && q.y >= bmin.y && q.z >= bmin.z && q.x <= bmax.x && q.y <= bmax.y && q.z <= bmax.z) {
+			for (int k = 0; k < count; k++) {
+				glm::vec3 d = q - points[k];
+				if (glm::dot(d, d) <= r2) {
+					wake(i);
+					woken = true;
+					break;
+				}
+			}
+		}
+		if (woken)
+			i = std::max(i, n_awake);
+		else
+			i++;
+	}
+}
@@ -6,33 +6,76 @@
 #include <cmath>
 #include <glm/glm.hpp>
 
-#define MAX_PARTICLE_PER_GENERATOR 1000
-#define MAX_PARTICLES 10000
+#include "Arena.h"
 
+#define MAX_PARTICLE_PER_GENERATOR 10000
+#define MAX_PARTICLES 100000
+
+// interleaved layout uploaded to the particle vertex buffer
+struct particle_gpu {
+	glm::vec3 p;
+	glm::vec3 c;
+};
+
+// structure of arrays particle storage, every attribute is its own column
+// the columns are carved from an arena the owner keeps, reset only rewinds the counters
+// live particles are kept packed in [0, n_alive), awake ones first in [0, n_awake) and the
+// sleeping ones after them in [n_awake, n_alive)
 class ParticleData {
 
 public:
 	ParticleData() {};
-	ParticleData(int maxParticles) { genParticle(maxParticles); }
+	ParticleData(int maxParticles, Arena& arena) { genParticle(maxParticles, arena); }
 	~ParticleData() {};
 
-	std::unique_ptr<glm::vec3[]> p;
-	std::unique_ptr<glm::vec3[]> c;
-	std::unique_ptr<glm::vec3[]> v;
-	std::unique_ptr<glm::vec3[]> a;
-	std::unique_ptr<glm::vec3[]> t;
-	std::unique_ptr<bool[]> v;
+	glm::vec3* p = nullptr; // position
+	glm::vec3* c = nullptr; // color
+	glm::vec3* v = nullptr; // velocity
+	glm::vec3* a = nullptr; // acceleration, accumulated by the force fields every step
+	float* m = nullptr; // mass
+	float* LS = nullptr; // life span
+	float* COF = nullptr; // coefficient of friction
+	float* COR = nullptr; // coefficient of restitution
+	float* age = nullptr;
+	bool* alive = nullptr;
+	int* restSteps = nullptr; // consecutive slow steps while touching a collider
+	unsigned int* id = nullptr; // emission order, wraps, stays with the particle when columns are reordered
+	// in [0, n) and unique among the live particles, a new particle takes over the one of the dead
+	// particle whose storage it reuses, the last one to die, so only slots below the highest
+	// n_alive so far are ever handed out
+	int* slot = nullptr;
 
-	int n;
-	int n_alive;
+	int n = 0;
+	int n_alive = 0;
+	int n_awake = 0;
+	unsigned int nextId = 0;
 
-	void genParticle(int maxParticles);
+	// bytes genParticle takes from the arena
+	static size_t storageBytes(int maxParticles);
+	void genParticle(int maxParticles, Arena& arena);
 	void swapData(int a, int b);
+	int emit();
+	void kill(int id);
+	void reset();
+
+	void sleep(int id);
+	void wake(int id);
+	void wakeAll();
+	void wakeRegion(const glm::vec3& bmin, const glm::vec3& bmax);
+	void wakeNear(const glm::vec3* points, int count, float radius);
 
 private:
 
 	
 
 };
+// particles fall asleep after restSteps consecutive steps in contact below restVelocity
+struct SleepParams {
+	bool enabled = true;
+	float restVelocity = 0.05f;
+	int restSteps = 30;
+	float wakeRadius = 0.5f; // impacts wake sleeping particles this close
+};
+
 #endif
 
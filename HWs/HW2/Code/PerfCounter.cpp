@@ -0,0 +1,72 @@
+#include "PerfCounter.h"
+#include "Parallel.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+// perf events only count the thread they were opened for, inherit would only cover threads
+// started after the counter and only adds their counts once they exit, so every thread the
+// passes run on gets its own event
+CacheMissCounter::CacheMissCounter() {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	std::vector<int> threads = { 0 };
+	for (int tid : ThreadPool::get().workerThreadIds())
+		threads.push_back(tid);
+	for (int tid : threads) {
+		int fd = (int)syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0);
+		if (fd < 0)
+			break;
+		fds.push_back(fd);
+	}
+	// a partial count would read as fewer misses, so it is all threads or none
+	if (fds.size() != threads.size()) {
+		for (int fd : fds)
+			close(fd);
+		fds.clear();
+	}
+}
+
+CacheMissCounter::~CacheMissCounter() {
+	for (int fd : fds)
+		close(fd);
+}
+
+void CacheMissCounter::start() {
+	for (int fd : fds) {
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+int64_t CacheMissCounter::read() const {
+	if (fds.empty())
+		return -1;
+	int64_t total = 0;
+	for (int fd : fds) {
+		long long count = 0;
+		if (::read(fd, &count, sizeof(count)) != sizeof(count))
+			return -1;
+		total += count;
+	}
+	return total;
+}
+
+#else
+
+CacheMissCounter::CacheMissCounter() {}
+CacheMissCounter::~CacheMissCounter() {}
+void CacheMissCounter::start() {}
+int64_t CacheMissCounter::read() const { return -1; }
+
+#endif
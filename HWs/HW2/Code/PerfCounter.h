@@ -0,0 +1,24 @@
+#ifndef PERFCOUNTER_H
+#define PERFCOUNTER_H
+
+#include <vector>
+#include <cstdint>
+
+// hardware cache miss counter for the calling thread and the workers of the thread pool, one
+// perf event per thread summed on read, only available on linux, elsewhere read() returns -1
+class CacheMissCounter {
+
+public:
+	CacheMissCounter();
+	~CacheMissCounter();
+
+	bool available() const { return !fds.empty(); }
+	void start();
+	// misses since start
+	int64_t read() const;
+
+private:
+	std::vector<int> fds;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "PngEncoder.h"
+
+#include <cstring>
+#include <algorithm>
+
+// deflate length and distance symbols, the first value each covers and its extra bits
+static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+struct DeflateTables {
+	uint16_t litCode[288]; // fixed huffman codes, bit reversed as deflate writes them lsb first
+	uint8_t litBits[288];
+	uint8_t distCode[30];
+	uint8_t lengthSym[259];
+	uint8_t distSym[512]; // distances up to 256 directly, farther ones in steps of 128 after them
+	uint32_t crc[256];
+};
+
+static uint32_t reverseBits(uint32_t code, int bits) {
+	uint32_t r = 0;
+	for (int i = 0; i < bits; i++) {
+		r = (r << 1) | (code & 1);
+		code >>= 1;
+	}
+	return r;
+}
+
+static const DeflateTables& tables() {
+	static const DeflateTables t = [] {
+		DeflateTables t;
+		for (int s = 0; s < 288; s++) {
+			uint32_t code;
+			int bits;
+			if (s < 144) { code = 0x30 + s; bits = 8; }
+			else if (s < 256) { code = 0x190 + s - 144; bits = 9; }
+			else if (s < 280) { code = s - 256; bits = 7; }
+			else { code = 0xc0 + s - 280; bits = 8; }
+			t.litCode[s] = (uint16_t)reverseBits(code, bits);
+			t.litBits[s] = (uint8_t)bits;
+		}
+		for (int s = 0; s < 30; s++) {
+			t.distCode[s] = (uint8_t)reverseBits(s, 5);
+			for (int d = distBase[s]; d < distBase[s] + (1 << distExtra[s]); d++)
+				t.distSym[d <= 256 ? d - 1 : 256 + ((d - 1) >> 7)] = (uint8_t)s;
+		}
+		for (int s = 0; s < 29; s++)
+			for (int l = lengthBase[s]; l < (s + 1 < 29 ? lengthBase[s + 1] : 259); l++)
+				t.lengthSym[l] = (uint8_t)s;
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			t.crc[n] = c;
+		}
+		return t;
+	}();
+	return t;
+}
+
+static uint32_t crc32(const unsigned char* p, size_t n) {
+	const uint32_t* table = tables().crc;
+	uint32_t c = 0xffffffffu;
+	while (n--)
+		c = table[(c ^ *p++) & 0xff] ^ (c >> 8);
+	return c ^ 0xffffffffu;
+}
+
+// the sums are reduced every 5552 bytes, the most that can not overflow 32 bits
+static uint32_t adler32(const unsigned char* p, size_t n) {
+	uint32_t a = 1, b = 0;
+	while (n > 0) {
+		size_t k = std::min<size_t>(n, 5552);
+		n -= k;
+		while (k--) {
+			a += *p++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+static void putBE32(std::vector<unsigned char>& out, uint32_t v) {
+	unsigned char b[4] = { (unsigned char)(v >> 24), (unsigned char)(v >> 16), (unsigned char)(v >> 8), (unsigned char)v };
+	out.insert(out.end(), b, b + 4);
+}
+
+static void putChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, uint32_t size) {
+	putBE32(out, size);
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data, data + size);
+	putBE32(out, crc32(out.data() + start, size + 4));
+}
+
+const std::vector<unsigned char>& PngEncoder::encode(const unsigned char* rgba, int width, int height) {
+	// rows are not filtered, the renders are mostly flat background the matcher takes in long runs
+	size_t stride = (size_t)width * 3 + 1;
+	scanlines.resize(stride * height);
+	for (int y = 0; y < height; y++) {
+		const unsigned char* src = rgba + (size_t)(height - 1 - y) * width * 4;
+		unsigned char* dst = &scanlines[stride * y];
+		*dst++ = 0;
+		for (int x = 0; x < width; x++, src += 4, dst += 3) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+	}
+
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	png.clear();
+	png.insert(png.end(), signature, signature + 8);
+	unsigned char ihdr[13] = { (unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+		(unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+		8, 2, 0, 0, 0 }; // 8 bits, rgb, deflate, no filter choice, not interlaced
+	putChunk(png, "IHDR", ihdr, 13);
+
+	// the zlib stream is written straight into the chunk, its length is patched in after
+	size_t idat = png.size();
+	putBE32(png, 0);
+	png.insert(png.end(), { 'I', 'D', 'A', 'T', 0x78, 0x01 });
+	deflate(scanlines.data(), scanlines.size());
+	putBE32(png, adler32(scanlines.data(), scanlines.size()));
+	uint32_t size = (uint32_t)(png.size() - idat - 8);
+	for (int k = 0; k < 4; k++)
+		png[idat + k] = (unsigned char)(size >> (24 - 8 * k));
+	putBE32(png, crc32(png.data() + idat + 4, size + 4));
+
+	putChunk(png, "IEND", nullptr, 0);
+	return png;
+}
+
+// one fixed code block, a literal takes at most 9 bits and a match of 4 or more bytes at most
+// 31, so the output never needs more than 9 bits per input byte
+void PngEncoder::deflate(const unsigned char* data, size_t size) {
+	const DeflateTables& t = tables();
+	head.assign((size_t)1 << PNG_HASH_BITS, -1);
+	size_t start = png.size();
+	png.resize(start + size + size / 8 + 64);
+	unsigned char* out = png.data() + start;
+
+	uint64_t bits = 0;
+	int count = 0;
+	auto put = [&](uint32_t value, int n) {
+		bits |= (uint64_t)value << count;
+		count += n;
+		while (count >= 8) {
+			*out++ = (unsigned char)bits;
+			bits >>= 8;
+			count -= 8;
+		}
+	};
+
+	put(1, 1); // last block
+	put(1, 2); // fixed codes
+	size_t i = 0;
+	while (i + 4 <= size) {
+		uint32_t word, prev;
+		memcpy(&word, data + i, 4);
+		uint32_t h = (word * 2654435761u) >> (32 - PNG_HASH_BITS);
+		int32_t cand = head[h];
+		head[h] = (int32_t)i;
+		if (cand >= 0 && i - cand <= PNG_WINDOW && (memcpy(&prev, data + cand, 4), prev == word)) {
+			size_t limit = std::min<size_t>(258, size - i);
+			size_t len = 4;
+			while (len < limit && data[cand + len] == data[i + len])
+				len++;
+			int ls = t.lengthSym[len];
+			put(t.litCode[257 + ls], t.litBits[257 + ls]);
+			put((uint32_t)(len - lengthBase[ls]), lengthExtra[ls]);
+			size_t dist = i - cand;
+			int ds = t.distSym[dist <= 256 ? dist - 1 : 256 + ((dist - 1) >> 7)];
+			put(t.distCode[ds], 5);
+			put((uint32_t)(dist - distBase[ds]), distExtra[ds]);
+			i += len;
+		}
+		else {
+			put(t.litCode[data[i]], t.litBits[data[i]]);
+			i++;
+		}
+	}
+	for (; i < size; i++)
+		put(t.litCode[data[i]], t.litBits[data[i]]);
+	put(t.litCode[256], t.litBits[256]);
+	if (count > 0)
+		*out++ = (unsigned char)bits;
+	png.resize(out - png.data());
+}
@@ -0,0 +1,30 @@
+#ifndef PNGENCODER_H
+#define PNGENCODER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#define PNG_HASH_BITS 15
+#define PNG_WINDOW 32768 // farthest back a deflate match may reach
+
+// 8 bit rgb png files compressed with a single greedy pass, matches are found through one
+// hash probe per position and written with the fixed huffman codes of deflate, so no code
+// tables are built or sent, files are larger than zlib would make them but encoding is fast
+// the scratch is kept between images, images of one size encode without allocating
+class PngEncoder {
+
+public:
+	// rgba rows bottom up as glReadPixels returns them, alpha is dropped
+	// the file is valid until the next call
+	const std::vector<unsigned char>& encode(const unsigned char* rgba, int width, int height);
+
+private:
+	void deflate(const unsigned char* data, size_t size);
+
+	std::vector<unsigned char> scanlines; // filter byte and rgb row, top down
+	std::vector<int32_t> head; // last position of every hash, -1 when none
+	std::vector<unsigned char> png;
+};
+
+#endif
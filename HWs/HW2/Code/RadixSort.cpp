@@ -0,0 +1,80 @@
+#include "RadixSort.h"
+#include "Parallel.h"
+#include "Arena.h"
+
+#include <cstring>
+#include <algorithm>
+
+#define RADIX_GRAIN 16384
+#define RADIX_BITS 11
+#define RADIX_BINS (1 << RADIX_BITS)
+
+template <class Key>
+void RadixSorter<Key>::sort(Key* keys, uint32_t* values, int n) {
+	if (n <= 1)
+		return;
+	ThreadPool& pool = ThreadPool::get();
+	int ranges = pool.rangeCount(0, n, RADIX_GRAIN);
+	Arena& frame = Arena::frame();
+	size_t mark = frame.mark();
+	uint32_t* histograms = frame.alloc<uint32_t>((size_t)ranges * RADIX_BINS); // one counter per digit value per range
+
+	Key* srcK = keys;
+	uint32_t* srcV = values;
+	Key* dstK = frame.alloc<Key>(n);
+	uint32_t* dstV = frame.alloc<uint32_t>(n);
+
+	for (int shift = 0; shift < (int)sizeof(Key) * 8; shift += RADIX_BITS) {
+		std::fill(histograms, histograms + (size_t)ranges * RADIX_BINS, 0);
+		pool.parallelFor(0, n, [&](int b, int e, int r) {
+			uint32_t* hist = &histograms[(size_t)r * RADIX_BINS];
+			for (int i = b; i < e; i++)
+				hist[(srcK[i] >> shift) & (RADIX_BINS - 1)]++;
+		}, RADIX_GRAIN);
+
+		// a digit shared by every key leaves the order unchanged
+		bool trivial = false;
+		for (int d = 0; d < RADIX_BINS && !trivial; d++) {
+			uint32_t total = 0;
+			for (int r = 0; r < ranges; r++)
+				total += histograms[(size_t)r * RADIX_BINS + d];
+			if (total == (uint32_t)n)
+				trivial = true;
+			else if (total != 0)
+				break;
+		}
+		if (trivial)
+			continue;
+
+		// exclusive prefix in (digit, range) order keeps the sort stable
+		uint32_t sum = 0;
+		for (int d = 0; d < RADIX_BINS; d++) {
+			for (int r = 0; r < ranges; r++) {
+				uint32_t c = histograms[(size_t)r * RADIX_BINS + d];
+				histograms[(size_t)r * RADIX_BINS + d] = sum;
+				sum += c;
+			}
+		}
+
+		pool.parallelFor(0, n, [&](int b, int e, int r) {
+			uint32_t* offset = &histograms[(size_t)r * RADIX_BINS];
+			for (int i = b; i < e; i++) {
+				uint32_t o = offset[(srcK[i] >> shift) & (RADIX_BINS - 1)]++;
+				dstK[o] = srcK[i];
+				dstV[o] = srcV[i];
+			}
+		}, RADIX_GRAIN);
+
+		std::swap(srcK, dstK);
+		std::swap(srcV, dstV);
+	}
+
+	if (srcK != keys) {
+		memcpy(keys, srcK, n * sizeof(Key));
+		memcpy(values, srcV, n * sizeof(uint32_t));
+	}
+	frame.rewind(mark);
+}
+
+template class RadixSorter<uint32_t>;
+template class RadixSorter<uint64_t>;
@@ -0,0 +1,22 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <vector>
+#include <cstdint>
+
+// parallel LSD radix sort of (key, value) pairs with 11 bit digits, stable
+// passes where every key has the same digit are skipped, so narrow keys only pay for the
+// bytes they use
+// the ping pong buffers and the histograms are frame scratch
+template <class Key>
+class RadixSorter {
+
+public:
+	// sorts keys ascending and carries values along, both arrays hold n entries
+	void sort(Key* keys, uint32_t* values, int n);
+};
+
+extern template class RadixSorter<uint32_t>;
+extern template class RadixSorter<uint64_t>;
+
+#endif
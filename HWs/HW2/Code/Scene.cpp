@@ -0,0 +1,754 @@
+#include "Scene.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <initializer_list>
+
+#define SCENE_CACHE_MAGIC 0x43534353 // "SCSC"
+#define SCENE_CACHE_VERSION 4
+
+SceneDesc defaultScene() {
+	SceneDesc scene;
+
+	GeneratorDesc gen;
+	gen.p = glm::vec3(10.0f, 10.0f, 10.0f);
+	gen.v = glm::vec3(0.0f, -1.0f, 0.0f);
+	gen.d = glm::vec3(1.0f, 1.0f, 1.0f);
+	gen.period = 0.2f;
+	gen.capacity = MAX_PARTICLE_PER_GENERATOR;
+	gen.mass = 0.1f;
+	gen.lifespan = 120.0f;
+	gen.cof = 0.1f;
+	gen.cor = 0.1f;
+	gen.count = 1;
+	gen.speed = 3.0f;
+	gen.mesh[0] = '\0';
+	scene.generators.push_back(gen);
+
+	gen.p = glm::vec3(-10.0f, -10.0f, -10.0f);
+	gen.v = glm::vec3(0.0f, 1.0f, 0.0f);
+	gen.d = glm::vec3(-1.0f, -1.0f, -1.0f);
+	gen.period = 1.0f;
+	scene.generators.push_back(gen);
+
+	FieldDesc field = {};
+	field.enabled = 1;
+	field.bmin = glm::vec3(-FLT_MAX);
+	field.bmax = glm::vec3(FLT_MAX);
+	field.type = FIELD_GRAVITY;
+	field.v0 = glm::vec3(0.0f);
+	scene.fields.push_back(field);
+
+	field.type = FIELD_LORENZ;
+	field.f[0] = 10.0f;
+	field.f[1] = 28.0f;
+	field.f[2] = 8.0f / 3.0f;
+	field.f[3] = 0.0f;
+	scene.fields.push_back(field);
+
+	ColliderDesc coll = {};
+	coll.tri[0] = glm::vec3(0.0f, 0.0f, 0.0f);
+	coll.tri[1] = glm::vec3(0.0f, 10.0f, 10.0f);
+	coll.tri[2] = glm::vec3(0.0f, -10.0f, 10.0f);
+	scene.colliders.push_back(coll);
+	return scene;
+}
+
+// typed member access, every getter leaves the output alone when the member is missing
+struct SceneReader {
+	std::string& error;
+
+	bool fail(const JsonValue& v, const std::string& what) {
+		error = "line " + std::to_string(v.line) + ": " + what;
+		return false;
+	}
+
+	bool checkMembers(const JsonValue& obj, const char* what, std::initializer_list<const char*> allowed) {
+		if (!obj.isObject())
+			return fail(obj, std::string(what) + " must be an object");
+		for (const auto& m : obj.members) {
+			bool known = false;
+			for (const char* a : allowed)
+				known |= m.first == a;
+			if (!known)
+				return fail(m.second, "unknown member \"" + m.first + "\" in " + what);
+		}
+		return true;
+	}
+
+	bool getFloat(const JsonValue& obj, const char* key, float& out, float lo = -FLT_MAX, float hi = FLT_MAX) {
+		const JsonValue* v = obj.find(key);
+		if (!v)
+			return true;
+		if (!v->isNumber())
+			return fail(*v, std::string(key) + " must be a number");
+		if (v->number < lo || v->number > hi)
+			return fail(*v, std::string(key) + " must be in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+		out = (float)v->number;
+		return true;
+	}
+
+	bool getInt(const JsonValue& obj, const char* key, int& out, int lo, int hi) {
+		const JsonValue* v = obj.find(key);
+		if (!v)
+			return true;
+		if (!v->isNumber() || v->number != (double)(long long)v->number)
+			return fail(*v, std::string(key) + " must be an integer");
+		if (v->number < lo || v->number > hi)
+			return fail(*v, std::string(key) + " must be in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+		out = (int)v->number;
+		return true;
+	}
+
+	bool getBool(const JsonValue& obj, const char* key, bool& out) {
+		const JsonValue* v = obj.find(key);
+		if (!v)
+			return true;
+		if (v->type != JsonValue::Bool)
+			return fail(*v, std::string(key) + " must be true or false");
+		out = v->boolean;
+		return true;
+	}
+
+	bool getIVec3(const JsonValue& obj, const char* key, int out[3], int lo, int hi) {
+		const JsonValue* v = obj.find(key);
+		if (!v)
+			return true;
+		if (!v->isArray() || v->array.size() != 3)
+			return fail(*v, std::string(key) + " must be an array of 3 integers");
+		for (int i = 0; i < 3; i++) {
+			const JsonValue& e = v->array[i];
+			if (!e.isNumber() || e.number != (double)(long long)e.number)
+				return fail(e, std::string(key) + " must be an array of 3 integers");
+			if (e.number < lo || e.number > hi)
+				return fail(e, std::string(key) + " must be in [" + std::to_string(lo) + ", " + std::to_string(hi) + "]");
+			out[i] = (int)e.number;
+		}
+		return true;
+	}
+
+	// relative paths are taken from the scene file's directory, the file has to exist
+	bool getPath(const JsonValue& v, const std::string& baseDir, const char* key, char out[SCENE_MAX_PATH]) {
+		if (!v.isString())
+			return fail(v, std::string(key) + " must be a path");
+		std::filesystem::path p(v.string);
+		if (p.is_relative())
+			p = std::filesystem::path(baseDir) / p;
+		std::error_code ec;
+		std::string resolved = std::filesystem::absolute(p, ec).lexically_normal().string();
+		if (!std::filesystem::exists(resolved, ec))
+			return fail(v, std::string(key) + " file not found: " + resolved);
+		if (resolved.size() >= SCENE_MAX_PATH)
+			return fail(v, std::string(key) + " path too long");
+		memcpy(out, resolved.c_str(), resolved.size() + 1);
+		return true;
+	}
+
+	bool toVec3(const JsonValue& v, const char* key, glm::vec3& out) {
+		if (!v.isArray() || v.array.size() != 3 ||
+			!v.array[0].isNumber() || !v.array[1].isNumber() || !v.array[2].isNumber())
+			return fail(v, std::string(key) + " must be an array of 3 numbers");
+		out = glm::vec3((float)v.array[0].number, (float)v.array[1].number, (float)v.array[2].number);
+		return true;
+	}
+
+	bool getVec3(const JsonValue& obj, const char* key, glm::vec3& out) {
+		const JsonValue* v = obj.find(key);
+		return !v || toVec3(*v, key, out);
+	}
+
+	bool requireMember(const JsonValue& obj, const char* key, const char* what) {
+		if (!obj.find(key))
+			return fail(obj, std::string(what) + " needs \"" + key + "\"");
+		return true;
+	}
+};
+
+static bool compileGenerator(SceneReader& r, const JsonValue& g, const std::string& baseDir, GeneratorDesc& gen) {
+	if (!r.checkMembers(g, "generator", { "position", "velocity", "direction", "period", "capacity",
+		"mass", "lifespan", "friction", "restitution", "count", "mesh", "speed" }))
+		return false;
+	gen = defaultScene().generators[0];
+	gen.v = glm::vec3(0.0f);
+	const JsonValue* mesh = g.find("mesh");
+	if (!r.requireMember(g, "position", "generator") || (!mesh && !r.requireMember(g, "direction", "generator")))
+		return false;
+	if (mesh && !r.getPath(*mesh, baseDir, "mesh", gen.mesh))
+		return false;
+	if (!r.getVec3(g, "position", gen.p) ||
+		!r.getVec3(g, "velocity", gen.v) ||
+		!r.getVec3(g, "direction", gen.d) ||
+		!r.getFloat(g, "period", gen.period, 1e-4f) ||
+		!r.getInt(g, "capacity", gen.capacity, 1, MAX_PARTICLES) ||
+		!r.getFloat(g, "mass", gen.mass, 1e-6f) ||
+		!r.getFloat(g, "lifespan", gen.lifespan, 0.0f) ||
+		!r.getFloat(g, "friction", gen.cof, 0.0f) ||
+		!r.getFloat(g, "restitution", gen.cor, 0.0f, 1.0f) ||
+		!r.getInt(g, "count", gen.count, 1, MAX_PARTICLES) ||
+		!r.getFloat(g, "speed", gen.speed))
+		return false;
+	if (glm::dot(gen.d, gen.d) == 0.0f)
+		return r.fail(*g.find("direction"), "direction must not be zero");
+	return true;
+}
+
+static bool compileField(SceneReader& r, const JsonValue& fv, const std::string& baseDir, FieldDesc& field) {
+	if (!fv.isObject())
+		return r.fail(fv, "field must be an object");
+	const JsonValue* type = fv.find("type");
+	if (!type || !type->isString())
+		return r.fail(fv, "field needs a \"type\" string");
+
+	field = FieldDesc();
+	field.enabled = 1;
+	field.bmin = glm::vec3(-FLT_MAX);
+	field.bmax = glm::vec3(FLT_MAX);
+	bool enabled = true;
+	bool ok;
+	const std::string& t = type->string;
+	if (t == "gravity") {
+		field.type = FIELD_GRAVITY;
+		ok = r.checkMembers(fv, "gravity", { "type", "enabled", "region", "g" }) &&
+			r.getVec3(fv, "g", field.v0);
+	}
+	else if (t == "wind") {
+		field.type = FIELD_WIND;
+		field.f[0] = 1.0f;
+		ok = r.checkMembers(fv, "wind", { "type", "enabled", "region", "wind", "factor" }) &&
+			r.getVec3(fv, "wind", field.v0) &&
+			r.getFloat(fv, "factor", field.f[0]);
+	}
+	else if (t == "drag") {
+		field.type = FIELD_DRAG;
+		field.f[0] = 0.1f;
+		ok = r.checkMembers(fv, "drag", { "type", "enabled", "region", "factor" }) &&
+			r.getFloat(fv, "factor", field.f[0], 0.0f);
+	}
+	else if (t == "vortex") {
+		field.type = FIELD_VORTEX;
+		field.v1 = glm::vec3(0.0f, 0.0f, 1.0f);
+		field.f[0] = 10.0f;
+		ok = r.checkMembers(fv, "vortex", { "type", "enabled", "region", "center", "axis", "strength", "pull" }) &&
+			r.getVec3(fv, "center", field.v0) &&
+			r.getVec3(fv, "axis", field.v1) &&
+			r.getFloat(fv, "strength", field.f[0]) &&
+			r.getFloat(fv, "pull", field.f[1]);
+		if (ok && glm::dot(field.v1, field.v1) == 0.0f)
+			return r.fail(*fv.find("axis"), "axis must not be zero");
+	}
+	else if (t == "attractor") {
+		field.type = FIELD_ATTRACTOR;
+		field.f[0] = 10.0f;
+		field.f[1] = 0.1f;
+		ok = r.checkMembers(fv, "attractor", { "type", "enabled", "region", "center", "strength", "softening" }) &&
+			r.getVec3(fv, "center", field.v0) &&
+			r.getFloat(fv, "strength", field.f[0]) &&
+			r.getFloat(fv, "softening", field.f[1], 1e-4f);
+	}
+	else if (t == "lorenz") {
+		field.type = FIELD_LORENZ;
+		field.f[0] = 10.0f;
+		field.f[1] = 28.0f;
+		field.f[2] = 8.0f / 3.0f;
+		field.f[3] = 0.0f;
+		ok = r.checkMembers(fv, "lorenz", { "type", "enabled", "region", "sigma", "rho", "beta", "factor" }) &&
+			r.getFloat(fv, "sigma", field.f[0]) &&
+			r.getFloat(fv, "rho", field.f[1]) &&
+			r.getFloat(fv, "beta", field.f[2]) &&
+			r.getFloat(fv, "factor", field.f[3], 0.0f, 100.0f);
+	}
+	else if (t == "grid") {
+		// either a grid file or a flow baked at load, only the lorenz flow can be baked so far
+		field.type = FIELD_GRID;
+		field.v0 = glm::vec3(-30.0f, -30.0f, -10.0f);
+		field.v1 = glm::vec3(30.0f, 30.0f, 60.0f);
+		field.f[0] = 10.0f;
+		field.f[1] = 28.0f;
+		field.f[2] = 8.0f / 3.0f;
+		field.f[3] = 0.0f;
+		field.samples[0] = field.samples[1] = field.samples[2] = 64;
+		bool sparse = false;
+		ok = r.checkMembers(fv, "grid", { "type", "enabled", "region", "file", "bake", "min", "max", "samples",
+			"sigma", "rho", "beta", "sparse", "factor" }) &&
+			r.getBool(fv, "sparse", sparse) &&
+			r.getFloat(fv, "factor", field.f[3], 0.0f, 100.0f);
+		field.sparse = sparse ? 1 : 0;
+		const JsonValue* file = fv.find("file");
+		const JsonValue* bake = fv.find("bake");
+		if (ok && (file != nullptr) == (bake != nullptr))
+			return r.fail(fv, "grid needs exactly one of \"file\" or \"bake\"");
+		if (ok && file) {
+			for (const char* baked : { "min", "max", "samples", "sigma", "rho", "beta" })
+				if (const JsonValue* m = fv.find(baked))
+					return r.fail(*m, std::string(baked) + " is only for baked grids, a grid file has its own");
+			ok = r.getPath(*file, baseDir, "file", field.path);
+		}
+		else if (ok) {
+			if (!bake->isString() || bake->string != "lorenz")
+				return r.fail(*bake, "bake must be \"lorenz\"");
+			ok = r.getVec3(fv, "min", field.v0) &&
+				r.getVec3(fv, "max", field.v1) &&
+				r.getIVec3(fv, "samples", field.samples, 2, GRID_MAX_SAMPLES) &&
+				r.getFloat(fv, "sigma", field.f[0]) &&
+				r.getFloat(fv, "rho", field.f[1]) &&
+				r.getFloat(fv, "beta", field.f[2]);
+			if (ok && (field.v0.x >= field.v1.x || field.v0.y >= field.v1.y || field.v0.z >= field.v1.z))
+				return r.fail(fv, "grid min must be below max");
+		}
+	}
+	else if (t == "curl") {
+		// the noise is seeded with the scene seed
+		field.type = FIELD_CURL;
+		field.f[0] = 4.0f;
+		field.f[1] = 5.0f;
+		field.f[2] = 1.0f;
+		field.f[3] = 0.0f;
+		ok = r.checkMembers(fv, "curl", { "type", "enabled", "region", "feature", "strength", "period", "factor" }) &&
+			r.getFloat(fv, "feature", field.f[0], 1e-3f) &&
+			r.getFloat(fv, "strength", field.f[1]) &&
+			r.getFloat(fv, "period", field.f[2], 0.0f) &&
+			r.getFloat(fv, "factor", field.f[3], 0.0f, 100.0f);
+	}
+	else {
+		return r.fail(*type, "unknown field type \"" + t + "\"");
+	}
+	if (!ok || !r.getBool(fv, "enabled", enabled))
+		return false;
+	field.enabled = enabled ? 1 : 0;
+
+	if (const JsonValue* region = fv.find("region")) {
+		if (!r.checkMembers(*region, "region", { "center", "halfExtent", "min", "max" }))
+			return false;
+		if (region->find("center")) {
+			glm::vec3 center(0.0f), half(0.0f);
+			if (!r.requireMember(*region, "halfExtent", "region") ||
+				!r.getVec3(*region, "center", center) ||
+				!r.getVec3(*region, "halfExtent", half))
+				return false;
+			if (half.x < 0.0f || half.y < 0.0f || half.z < 0.0f)
+				return r.fail(*region, "halfExtent must not be negative");
+			field.bmin = center - half;
+			field.bmax = center + half;
+		}
+		else {
+			if (!r.requireMember(*region, "min", "region") || !r.requireMember(*region, "max", "region") ||
+				!r.getVec3(*region, "min", field.bmin) ||
+				!r.getVec3(*region, "max", field.bmax))
+				return false;
+			if (field.bmin.x > field.bmax.x || field.bmin.y > field.bmax.y || field.bmin.z > field.bmax.z)
+				return r.fail(*region, "region min must not exceed max");
+		}
+	}
+	return true;
+}
+
+static bool compileCollider(SceneReader& r, const JsonValue& cv, const std::string& baseDir, ColliderDesc& coll) {
+	if (!r.checkMembers(cv, "collider", { "triangle", "mesh", "box", "sdf", "inverted" }))
+		return false;
+	coll = ColliderDesc();
+	coll.sdfBand = 3.0f;
+	const JsonValue* tri = cv.find("triangle");
+	const JsonValue* mesh = cv.find("mesh");
+	const JsonValue* box = cv.find("box");
+	if ((tri != nullptr) + (mesh != nullptr) + (box != nullptr) != 1)
+		return r.fail(cv, "collider needs exactly one of \"triangle\", \"mesh\" or \"box\"");
+	if (tri) {
+		if (!tri->isArray() || tri->array.size() != 3)
+			return r.fail(*tri, "triangle must be an array of 3 points");
+		for (int i = 0; i < 3; i++)
+			if (!r.toVec3(tri->array[i], "triangle point", coll.tri[i]))
+				return false;
+	}
+	else if (mesh) {
+		if (!r.getPath(*mesh, baseDir, "mesh", coll.mesh))
+			return false;
+		coll.type = COLLIDER_MESH;
+	}
+	else {
+		coll.type = COLLIDER_BOX;
+		coll.sdf = 1;
+		if (!r.checkMembers(*box, "box", { "center", "halfExtent" }) ||
+			!r.requireMember(*box, "halfExtent", "box") ||
+			!r.getVec3(*box, "center", coll.tri[0]) ||
+			!r.getVec3(*box, "halfExtent", coll.tri[1]))
+			return false;
+		if (coll.tri[1].x <= 0.0f || coll.tri[1].y <= 0.0f || coll.tri[1].z <= 0.0f)
+			return r.fail(*box, "halfExtent must be positive");
+	}
+
+	if (const JsonValue* sdf = cv.find("sdf")) {
+		if (tri)
+			return r.fail(*sdf, "a single triangle has no inside, sdf needs a closed mesh or a box");
+		if (!r.checkMembers(*sdf, "sdf", { "cell", "band" }) ||
+			!r.getFloat(*sdf, "cell", coll.sdfCell, 1e-4f) ||
+			!r.getFloat(*sdf, "band", coll.sdfBand, 1.0f, 16.0f))
+			return false;
+		coll.sdf = 1;
+	}
+	bool inverted = false;
+	if (!r.getBool(cv, "inverted", inverted))
+		return false;
+	if (inverted && !coll.sdf)
+		return r.fail(*cv.find("inverted"), "only distance grid colliders can be inverted");
+	coll.inverted = inverted ? 1 : 0;
+	return true;
+}
+
+bool compileScene(const JsonValue& root, const std::string& baseDir, SceneDesc& scene, std::string& error) {
+	SceneReader r{ error };
+	if (!r.checkMembers(root, "scene", { "timestep", "integrator", "seed", "velocityVariance", "sleep",
+		"generators", "fields", "colliders" }))
+		return false;
+
+	scene = SceneDesc();
+	int seed = 0;
+	if (!r.getFloat(root, "timestep", scene.timestep, 1e-5f, 1.0f) ||
+		!r.getInt(root, "seed", seed, 0, 0x7fffffff) ||
+		!r.getFloat(root, "velocityVariance", scene.velVariance, 0.0f))
+		return false;
+	scene.seed = (unsigned int)seed;
+
+	if (const JsonValue* integrator = root.find("integrator")) {
+		if (integrator->isString() && integrator->string == "euler")
+			scene.integrator = INTEGRATOR_EULER;
+		else if (integrator->isString() && integrator->string == "symplectic")
+			scene.integrator = INTEGRATOR_SYMPLECTIC;
+		else
+			return r.fail(*integrator, "integrator must be \"euler\" or \"symplectic\"");
+	}
+
+	if (const JsonValue* sleep = root.find("sleep")) {
+		if (!r.checkMembers(*sleep, "sleep", { "enabled", "restVelocity", "restSteps", "wakeRadius" }) ||
+			!r.getBool(*sleep, "enabled", scene.sleep.enabled) ||
+			!r.getFloat(*sleep, "restVelocity", scene.sleep.restVelocity, 0.0f) ||
+			!r.getInt(*sleep, "restSteps", scene.sleep.restSteps, 1, 1 << 20) ||
+			!r.getFloat(*sleep, "wakeRadius", scene.sleep.wakeRadius, 0.0f))
+			return false;
+	}
+
+	const JsonValue* gens = root.find("generators");
+	if (!gens || !gens->isArray() || gens->array.empty())
+		return r.fail(gens ? *gens : root, "scene needs a non empty \"generators\" array");
+	if (gens->array.size() > SCENE_MAX_GENERATORS)
+		return r.fail(*gens, "too many generators, at most " + std::to_string(SCENE_MAX_GENERATORS));
+	long long total = 0;
+	for (const auto& g : gens->array) {
+		GeneratorDesc gen;
+		if (!compileGenerator(r, g, baseDir, gen))
+			return false;
+		total += gen.capacity;
+		scene.generators.push_back(gen);
+	}
+	if (total > MAX_PARTICLES)
+		return r.fail(*gens, "generator capacities add up to more than " + std::to_string(MAX_PARTICLES));
+
+	if (const JsonValue* fields = root.find("fields")) {
+		if (!fields->isArray())
+			return r.fail(*fields, "fields must be an array");
+		if (fields->array.size() > SCENE_MAX_FIELDS)
+			return r.fail(*fields, "too many fields, at most " + std::to_string(SCENE_MAX_FIELDS));
+		for (const auto& fv : fields->array) {
+			FieldDesc field;
+			if (!compileField(r, fv, baseDir, field))
+				return false;
+			scene.fields.push_back(field);
+		}
+	}
+
+	if (const JsonValue* colliders = root.find("colliders")) {
+		if (!colliders->isArray())
+			return r.fail(*colliders, "colliders must be an array");
+		for (const auto& cv : colliders->array) {
+			ColliderDesc coll;
+			if (!compileCollider(r, cv, baseDir, coll))
+				return false;
+			scene.colliders.push_back(coll);
+		}
+	}
+	return true;
+}
+
+struct SceneCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t hash;
+	int64_t mtime;
+	uint64_t fileSize;
+	uint32_t generatorCount;
+	uint32_t fieldCount;
+	uint32_t colliderCount;
+	uint32_t pad;
+};
+
+// the scalar part of SceneDesc
+struct SceneCacheGlobals {
+	float timestep;
+	int integrator;
+	unsigned int seed;
+	float velVariance;
+	SleepParams sleep;
+};
+
+static bool readCache(const std::string& cachePath, const SceneCacheHeader& expect, SceneDesc& scene) {
+	MappedFile cache(cachePath);
+	if (!cache.isOpen() || cache.getSize() < sizeof(SceneCacheHeader))
+		return false;
+	SceneCacheHeader header;
+	memcpy(&header, cache.getData(), sizeof(header));
+	if (header.magic != SCENE_CACHE_MAGIC || header.version != SCENE_CACHE_VERSION ||
+		header.hash != expect.hash || header.mtime != expect.mtime || header.fileSize != expect.fileSize)
+		return false;
+	if (header.generatorCount == 0 || header.generatorCount > SCENE_MAX_GENERATORS || header.fieldCount > SCENE_MAX_FIELDS)
+		return false;
+	size_t gbytes = header.generatorCount * sizeof(GeneratorDesc);
+	size_t fbytes = header.fieldCount * sizeof(FieldDesc);
+	size_t cbytes = header.colliderCount * sizeof(ColliderDesc);
+	if (cache.getSize() != sizeof(header) + sizeof(SceneCacheGlobals) + gbytes + fbytes + cbytes)
+		return false;
+
+	const char* p = cache.getData() + sizeof(header);
+	SceneCacheGlobals globals;
+	memcpy(&globals, p, sizeof(globals));
+	p += sizeof(globals);
+	scene = SceneDesc();
+	scene.timestep = globals.timestep;
+	scene.integrator = globals.integrator;
+	scene.seed = globals.seed;
+	scene.velVariance = globals.velVariance;
+	scene.sleep = globals.sleep;
+	scene.generators.resize(header.generatorCount);
+	scene.fields.resize(header.fieldCount);
+	scene.colliders.resize(header.colliderCount);
+	memcpy(scene.generators.data(), p, gbytes);
+	memcpy(scene.fields.data(), p + gbytes, fbytes);
+	memcpy(scene.colliders.data(), p + gbytes + fbytes, cbytes);
+	for (auto& g : scene.generators)
+		g.mesh[SCENE_MAX_PATH - 1] = '\0';
+	for (auto& f : scene.fields)
+		f.path[SCENE_MAX_PATH - 1] = '\0';
+	for (auto& c : scene.colliders)
+		c.mesh[SCENE_MAX_PATH - 1] = '\0';
+	return true;
+}
+
+static void writeCache(const std::string& cachePath, SceneCacheHeader header, const SceneDesc& scene) {
+	header.generatorCount = (uint32_t)scene.generators.size();
+	header.fieldCount = (uint32_t)scene.fields.size();
+	header.colliderCount = (uint32_t)scene.colliders.size();
+	SceneCacheGlobals globals = {};
+	globals.timestep = scene.timestep;
+	globals.integrator = scene.integrator;
+	globals.seed = scene.seed;
+	globals.velVariance = scene.velVariance;
+	globals.sleep = scene.sleep;
+
+	// write to a temporary and rename so a crash never leaves a half written cache behind
+	std::string tmp = cachePath + ".tmp";
+	std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+	if (!out)
+		return;
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)&globals, sizeof(globals));
+	out.write((const char*)scene.generators.data(), scene.generators.size() * sizeof(GeneratorDesc));
+	out.write((const char*)scene.fields.data(), scene.fields.size() * sizeof(FieldDesc));
+	out.write((const char*)scene.colliders.data(), scene.colliders.size() * sizeof(ColliderDesc));
+	out.close();
+	std::error_code ec;
+	std::filesystem::rename(tmp, cachePath, ec);
+	if (ec)
+		std::filesystem::remove(tmp, ec);
+}
+
+bool loadScene(const std::string& path, SceneDesc& scene, bool useCache) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		std::cout << "ERROR: Scene File Reading Failed: " << path << std::endl;
+		return false;
+	}
+
+	std::error_code ec;
+	SceneCacheHeader header = {};
+	header.magic = SCENE_CACHE_MAGIC;
+	header.version = SCENE_CACHE_VERSION;
+	header.fileSize = file.getSize();
+	header.mtime = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	header.hash = hashBytes(file.getData(), file.getSize());
+	std::string cachePath = path + ".scache";
+
+	if (useCache && readCache(cachePath, header, scene))
+		return true;
+
+	JsonValue root;
+	std::string error;
+	std::string baseDir = std::filesystem::path(path).parent_path().string();
+	if (!parseJson(file.getData(), file.getSize(), root, error) ||
+		!compileScene(root, baseDir, scene, error)) {
+		std::cout << "ERROR: Scene Invalid: " << path << " " << error << std::endl;
+		return false;
+	}
+
+	if (useCache)
+		writeCache(cachePath, header, scene);
+	return true;
+}
+
+void buildFields(const SceneDesc& scene, ForceFieldRegistry& fields) {
+	for (const FieldDesc& fd : scene.fields) {
+		ForceField* field = nullptr;
+		switch (fd.type) {
+		case FIELD_GRAVITY:
+			field = fields.add<UniformField>(fd.v0);
+			break;
+		case FIELD_WIND:
+			field = fields.add<WindField>(fd.v0, fd.f[0]);
+			break;
+		case FIELD_DRAG:
+			field = fields.add<DragField>(fd.f[0]);
+			break;
+		case FIELD_VORTEX: {
+			VortexField* vortex = fields.add<VortexField>(fd.v0, fd.v1, fd.f[0]);
+			vortex->pull = fd.f[1];
+			field = vortex;
+			break;
+		}
+		case FIELD_ATTRACTOR: {
+			PointAttractor* attractor = fields.add<PointAttractor>(fd.v0, fd.f[0]);
+			attractor->softening = fd.f[1];
+			field = attractor;
+			break;
+		}
+		case FIELD_LORENZ: {
+			LorenzField* lorenz = fields.add<LorenzField>(fd.f[0], fd.f[1], fd.f[2]);
+			lorenz->factor = fd.f[3];
+			field = lorenz;
+			break;
+		}
+		case FIELD_GRID: {
+			GridField* grid = fields.add<GridField>();
+			grid->factor = fd.f[3];
+			if (fd.path[0]) {
+				grid->grid.load(fd.path, fd.sparse != 0);
+			}
+			else {
+				LorenzField lorenz(fd.f[0], fd.f[1], fd.f[2]);
+				grid->grid.bake(fd.v0, fd.v1, glm::ivec3(fd.samples[0], fd.samples[1], fd.samples[2]), fd.sparse != 0,
+					[&](const glm::vec3& p) { return lorenz.flow(p); });
+			}
+			field = grid;
+			break;
+		}
+		case FIELD_CURL: {
+			CurlNoiseField* curl = fields.add<CurlNoiseField>(fd.f[0], fd.f[1], fd.f[2], scene.seed);
+			curl->factor = fd.f[3];
+			field = curl;
+			break;
+		}
+		default:
+			continue;
+		}
+		field->enabled = fd.enabled != 0;
+		field->bmin = fd.bmin;
+		field->bmax = fd.bmax;
+		// outside its lattice a grid only repeats the boundary, so it acts on nothing there
+		if (fd.type == FIELD_GRID) {
+			const VectorGrid& grid = ((GridField*)field)->grid;
+			if (!grid.empty()) {
+				field->bmin = glm::max(field->bmin, grid.bmin);
+				field->bmax = glm::min(field->bmax, grid.bmax);
+			}
+		}
+	}
+}
+
+// 24 vertices so every face keeps its own normal
+static void boxMesh(const glm::vec3& center, const glm::vec3& half, TriangleMesh& mesh) {
+	for (int axis = 0; axis < 3; axis++) {
+		for (int side = -1; side <= 1; side += 2) {
+			glm::vec3 n(0.0f);
+			n[axis] = (float)side;
+			glm::vec3 u(0.0f), v(0.0f);
+			u[(axis + 1) % 3] = 1.0f;
+			v[(axis + 2) % 3] = 1.0f;
+			// counter clockwise seen from outside
+			if (side < 0)
+				std::swap(u, v);
+			unsigned int base = (unsigned int)mesh.positions.size();
+			for (int k = 0; k < 4; k++) {
+				float su = (k == 1 || k == 2) ? 1.0f : -1.0f;
+				float sv = k >= 2 ? 1.0f : -1.0f;
+				mesh.positions.push_back(center + half * (n + su * u + sv * v));
+				mesh.normals.push_back(n);
+			}
+			for (unsigned int i : { 0u, 1u, 2u, 0u, 2u, 3u })
+				mesh.indices.push_back(base + i);
+		}
+	}
+}
+
+static void appendMesh(TriangleMesh& mesh, const TriangleMesh& part) {
+	unsigned int base = (unsigned int)mesh.positions.size();
+	mesh.positions.insert(mesh.positions.end(), part.positions.begin(), part.positions.end());
+	mesh.normals.insert(mesh.normals.end(), part.normals.begin(), part.normals.end());
+	for (unsigned int i : part.indices)
+		mesh.indices.push_back(base + i);
+}
+
+static void bakeCollider(const ColliderDesc& cd, const TriangleMesh& part, SdfGrid& grid) {
+	glm::vec3 lo, hi;
+	part.bounds(lo, hi);
+	glm::vec3 extent = hi - lo;
+	float cell = cd.sdfCell > 0.0f ? cd.sdfCell : std::max(extent.x, std::max(extent.y, extent.z)) / 64.0f;
+	glm::vec3 gridLo, gridHi;
+	float band;
+	glm::ivec3 count = SdfGrid::fit(lo, hi, cell, cd.sdfBand, gridLo, gridHi, band);
+	if (cd.type == COLLIDER_BOX) {
+		glm::vec3 center = cd.tri[0], half = cd.tri[1];
+		grid.bake(gridLo, gridHi, count, band, cd.inverted != 0, [&](const glm::vec3& p) {
+			glm::vec3 q = glm::abs(p - center) - half;
+			return glm::length(glm::max(q, glm::vec3(0.0f))) + std::min(std::max(q.x, std::max(q.y, q.z)), 0.0f);
+		});
+	}
+	else {
+		grid.bakeMesh(part, gridLo, gridHi, count, band, cd.inverted != 0);
+	}
+}
+
+bool buildColliders(const SceneDesc& scene, TriangleMesh& mesh, TriangleCollider& triangles, SdfCollider& sdf) {
+	mesh = TriangleMesh();
+	sdf.grids.clear();
+	TriangleMesh tested;
+	bool ok = true;
+	for (const ColliderDesc& cd : scene.colliders) {
+		TriangleMesh part;
+		if (cd.type == COLLIDER_MESH) {
+			if (!loadMesh(cd.mesh, part)) {
+				ok = false;
+				continue;
+			}
+		}
+		else if (cd.type == COLLIDER_BOX) {
+			boxMesh(cd.tri[0], cd.tri[1], part);
+		}
+		else {
+			part.positions = { cd.tri[0], cd.tri[1], cd.tri[2] };
+			part.indices = { 0, 1, 2 };
+			part.computeNormals();
+		}
+		if (cd.sdf) {
+			sdf.grids.emplace_back();
+			bakeCollider(cd, part, sdf.grids.back());
+		}
+		else {
+			appendMesh(tested, part);
+		}
+		// the camera is fitted to the drawn mesh, drawn from outside an inverted collider would only
+		// hide what it contains
+		if (!cd.inverted)
+			appendMesh(mesh, part);
+	}
+	triangles.build(tested);
+	return ok;
+}
@@ -0,0 +1,112 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Json.h"
+#include "ParticleData.h"
+#include "ForceField.h"
+#include "MeshLoader.h"
+#include "Collider.h"
+
+#define SCENE_MAX_GENERATORS 64
+#define SCENE_MAX_FIELDS 256
+#define SCENE_MAX_PATH 256
+
+enum SceneIntegrator {
+	INTEGRATOR_EULER = 0, // position with the old velocity, then velocity
+	INTEGRATOR_SYMPLECTIC = 1 // velocity first, position with the new velocity
+};
+
+enum SceneFieldType {
+	FIELD_GRAVITY = 0,
+	FIELD_WIND,
+	FIELD_DRAG,
+	FIELD_VORTEX,
+	FIELD_ATTRACTOR,
+	FIELD_LORENZ,
+	FIELD_GRID,
+	FIELD_CURL
+};
+
+// the compiled scene is plain data only, the cache is these structs written as they are
+
+struct GeneratorDesc {
+	glm::vec3 p; // position
+	glm::vec3 v; // velocity of the generator itself
+	glm::vec3 d; // direction
+	float period;
+	int capacity; // particle slots
+	// given to every emitted particle
+	float mass;
+	float lifespan;
+	float cof;
+	float cor;
+	int count; // particles per emission
+	// with a mesh the particles start uniformly over its surface placed at p and leave along the
+	// interpolated normal at speed, the direction is only used by point generators
+	float speed;
+	char mesh[SCENE_MAX_PATH];
+};
+
+struct FieldDesc {
+	int type; // SceneFieldType
+	int enabled;
+	glm::vec3 v0; // gravity, wind, vortex and attractor center | grid min
+	glm::vec3 v1; // vortex axis | grid max
+	float f[4]; // wind factor | drag factor | vortex strength, pull | attractor strength, softening | sigma, rho, beta, factor | curl feature, strength, period, factor
+	glm::vec3 bmin; // region of influence
+	glm::vec3 bmax;
+	// grid only, without a path the lorenz flow of f is baked over [v0, v1]
+	int samples[3];
+	int sparse;
+	char path[SCENE_MAX_PATH];
+};
+
+enum SceneColliderType {
+	COLLIDER_TRIANGLE = 0,
+	COLLIDER_MESH = 1,
+	COLLIDER_BOX = 2 // always a distance grid
+};
+
+struct ColliderDesc {
+	int type; // SceneColliderType
+	glm::vec3 tri[3]; // when it is a single triangle | box center, half extent
+	char mesh[SCENE_MAX_PATH]; // .obj or .ply, relative paths are resolved against the scene file
+	// baked into a signed distance grid instead of tested per triangle, the mesh has to be closed
+	int sdf;
+	int inverted; // the solid is everything but the shape, particles stay inside
+	float sdfCell; // 0 fits 64 cells along the widest axis
+	float sdfBand; // cells on either side of the surface
+};
+
+struct SceneDesc {
+	float timestep = 0.01f;
+	int integrator = INTEGRATOR_EULER;
+	unsigned int seed = 0; // for the emission noise, runs with the same seed are repeatable
+	float velVariance = 0.5f;
+	SleepParams sleep;
+	std::vector<GeneratorDesc> generators;
+	std::vector<FieldDesc> fields;
+	std::vector<ColliderDesc> colliders;
+};
+
+// the scene main used before scene files, two generators, gravity, lorenz and one triangle
+SceneDesc defaultScene();
+
+// loads a json scene, the validated result is cached next to it as <path>.scache and reused
+// as long as the file size, mtime and content hash match
+bool loadScene(const std::string& path, SceneDesc& scene, bool useCache = true);
+
+// checks every member against the schema, unknown members are errors so typos do not go unnoticed
+bool compileScene(const JsonValue& root, const std::string& baseDir, SceneDesc& scene, std::string& error);
+
+void buildFields(const SceneDesc& scene, ForceFieldRegistry& fields);
+// all colliders of the scene but the inverted ones merged into one mesh to draw, the distance grid
+// ones are baked into sdf and the rest are tested per triangle
+bool buildColliders(const SceneDesc& scene, TriangleMesh& mesh, TriangleCollider& triangles, SdfCollider& sdf);
+
+#endif
@@ -0,0 +1,205 @@
+#include "SdfGrid.h"
+
+#include <cmath>
+#include <algorithm>
+
+#define SDF_BRICK_SAMPLES (GRID_BRICK + 1) // along one edge, the last ones are shared with the next brick
+#define SDF_BRICK_SIZE (SDF_BRICK_SAMPLES * SDF_BRICK_SAMPLES * SDF_BRICK_SAMPLES)
+
+glm::ivec3 SdfGrid::fit(const glm::vec3& lo, const glm::vec3& hi, float cell, float bandCells, glm::vec3& gridLo, glm::vec3& gridHi, float& band) {
+	glm::vec3 extent = hi - lo;
+	float widest = std::max(extent.x, std::max(extent.y, extent.z));
+	// the widest axis decides the cell when the lattice would get too fine
+	cell = std::max(cell, widest / (float)(SDF_MAX_SAMPLES - 3 - 2 * (int)std::ceil(bandCells)));
+	band = bandCells * cell;
+	gridLo = lo - glm::vec3(band + cell);
+	glm::ivec3 count = glm::ivec3(glm::ceil((extent + 2.0f * (band + cell)) / cell)) + 1;
+	count = glm::clamp(count, glm::ivec3(2), glm::ivec3(SDF_MAX_SAMPLES));
+	gridHi = gridLo + cell * glm::vec3(count - 1);
+	return count;
+}
+
+// closest point on the triangle abc to p, by the voronoi region p falls in
+static glm::vec3 closestOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+	glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+	float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return a;
+	glm::vec3 bp = p - b;
+	float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+		return b;
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return a + ab * (d1 / (d1 - d3));
+	glm::vec3 cp = p - c;
+	float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+		return c;
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return a + ac * (d2 / (d2 - d6));
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// whether q is inside the triangle projected on the yz plane, counter clockwise there
+// a point on an edge only counts for one of the two triangles sharing it, so a row through an
+// edge or a vertex still crosses the surface once
+static bool coversYZ(const glm::vec2& q, const glm::vec2 t[3]) {
+	for (int k = 0; k < 3; k++) {
+		glm::vec2 e = t[(k + 1) % 3] - t[k];
+		float side = e.x * (q.y - t[k].y) - e.y * (q.x - t[k].x);
+		if (side < 0.0f || (side == 0.0f && !(e.x < 0.0f || (e.x == 0.0f && e.y > 0.0f))))
+			return false;
+	}
+	return true;
+}
+
+void SdfGrid::bakeMesh(const TriangleMesh& mesh, const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, float band, bool inverted) {
+	std::vector<float> dense((size_t)count.x * count.y * count.z, band);
+	glm::vec3 step = (hi - lo) / glm::vec3(glm::max(count - 1, glm::ivec3(1)));
+	int tris = mesh.triangleCount();
+
+	// each range of z slices goes over every triangle, first for the distances of the samples in
+	// the band around it, then for the x where the rows of samples pass through it
+	ThreadPool::get().parallelFor(0, count.z, [&](int zb, int ze, int) {
+		std::vector<std::vector<float>> crossings((size_t)(ze - zb) * count.y);
+		for (int t = 0; t < tris; t++) {
+			const glm::vec3& a = mesh.positions[mesh.indices[3 * t]];
+			const glm::vec3& b = mesh.positions[mesh.indices[3 * t + 1]];
+			const glm::vec3& c = mesh.positions[mesh.indices[3 * t + 2]];
+			glm::vec3 tmin = glm::min(a, glm::min(b, c));
+			glm::vec3 tmax = glm::max(a, glm::max(b, c));
+
+			glm::ivec3 i0 = glm::max(glm::ivec3(glm::ceil((tmin - band - lo) / step)), glm::ivec3(0, 0, zb));
+			glm::ivec3 i1 = glm::min(glm::ivec3(glm::floor((tmax + band - lo) / step)), glm::ivec3(count.x - 1, count.y - 1, ze - 1));
+			for (int z = i0.z; z <= i1.z; z++)
+				for (int y = i0.y; y <= i1.y; y++)
+					for (int x = i0.x; x <= i1.x; x++) {
+						glm::vec3 p = lo + step * glm::vec3(x, y, z);
+						float& d = dense[x + (size_t)count.x * (y + (size_t)count.y * z)];
+						d = std::min(d, glm::length(p - closestOnTriangle(p, a, b, c)));
+					}
+
+			// triangles edge on to x are never crossed
+			glm::vec3 n = glm::cross(b - a, c - a);
+			if (n.x == 0.0f)
+				continue;
+			glm::vec2 proj[3] = { glm::vec2(a.y, a.z), glm::vec2(b.y, b.z), glm::vec2(c.y, c.z) };
+			if (n.x < 0.0f)
+				std::swap(proj[1], proj[2]);
+			i0 = glm::max(glm::ivec3(glm::ceil((tmin - lo) / step)), glm::ivec3(0, 0, zb));
+			i1 = glm::min(glm::ivec3(glm::floor((tmax - lo) / step)), glm::ivec3(count.x - 1, count.y - 1, ze - 1));
+			float nd = glm::dot(n, a);
+			for (int z = i0.z; z <= i1.z; z++)
+				for (int y = i0.y; y <= i1.y; y++) {
+					glm::vec2 q(lo.y + step.y * y, lo.z + step.z * z);
+					if (coversYZ(q, proj))
+						crossings[(size_t)(z - zb) * count.y + y].push_back((nd - n.y * q.x - n.z * q.y) / n.x);
+				}
+		}
+
+		// a sample is inside when an odd number of crossings lies before it on its row
+		for (int z = zb; z < ze; z++)
+			for (int y = 0; y < count.y; y++) {
+				std::vector<float>& row = crossings[(size_t)(z - zb) * count.y + y];
+				std::sort(row.begin(), row.end());
+				size_t k = 0;
+				for (int x = 0; x < count.x; x++) {
+					float px = lo.x + step.x * x;
+					while (k < row.size() && row[k] < px)
+						k++;
+					if (k & 1) {
+						float& d = dense[x + (size_t)count.x * (y + (size_t)count.y * z)];
+						d = -d;
+					}
+				}
+			}
+	});
+	build(lo, hi, count, band, inverted, dense);
+}
+
+void SdfGrid::build(const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, float band, bool inverted, std::vector<float>& dense) {
+	bmin = lo;
+	bmax = hi;
+	samples = count;
+	this->band = band;
+	this->inverted = inverted;
+	scale = glm::vec3(count - 1) / glm::max(hi - lo, glm::vec3(1e-30f));
+	for (float& d : dense)
+		d = inverted ? -std::clamp(d, -band, band) : std::clamp(d, -band, band);
+
+	const int S = SDF_BRICK_SAMPLES;
+	brickCount = (count - 1 + GRID_BRICK - 1) / GRID_BRICK;
+	bricks.assign((size_t)brickCount.x * brickCount.y * brickCount.z, 0);
+	values.assign(2 * SDF_BRICK_SIZE, band);
+	std::fill(values.begin() + SDF_BRICK_SIZE, values.end(), -band);
+
+	// samples past the end of the lattice in the last bricks repeat the boundary
+	auto at = [&](int x, int y, int z) {
+		x = std::min(x, count.x - 1);
+		y = std::min(y, count.y - 1);
+		z = std::min(z, count.z - 1);
+		return dense[x + (size_t)count.x * (y + (size_t)count.y * z)];
+	};
+	for (int bz = 0; bz < brickCount.z; bz++) {
+		for (int by = 0; by < brickCount.y; by++) {
+			for (int bx = 0; bx < brickCount.x; bx++) {
+				int x0 = bx * GRID_BRICK, y0 = by * GRID_BRICK, z0 = bz * GRID_BRICK;
+				float first = at(x0, y0, z0);
+				bool constant = first == band || first == -band;
+				for (int z = 0; z < S && constant; z++)
+					for (int y = 0; y < S && constant; y++)
+						for (int x = 0; x < S && constant; x++)
+							constant = at(x0 + x, y0 + y, z0 + z) == first;
+				int& brick = bricks[bx + (size_t)brickCount.x * (by + (size_t)brickCount.y * bz)];
+				if (constant) {
+					brick = first == band ? 0 : SDF_BRICK_SIZE;
+					continue;
+				}
+				brick = (int)values.size();
+				values.resize(brick + SDF_BRICK_SIZE);
+				for (int z = 0; z < S; z++)
+					for (int y = 0; y < S; y++)
+						for (int x = 0; x < S; x++)
+							values[brick + x + S * (y + S * z)] = at(x0 + x, y0 + y, z0 + z);
+			}
+		}
+	}
+}
+
+int SdfGrid::cellBase(int x, int y, int z) const {
+	int brick = (x >> GRID_BRICK_SHIFT) + brickCount.x * ((y >> GRID_BRICK_SHIFT) + brickCount.y * (z >> GRID_BRICK_SHIFT));
+	const int mask = GRID_BRICK - 1;
+	return bricks[brick] + (x & mask) + SDF_BRICK_SAMPLES * ((y & mask) + SDF_BRICK_SAMPLES * (z & mask));
+}
+
+void SdfGrid::sample(const glm::vec3& p, float& dist, glm::vec3& grad) const {
+	glm::vec3 g = glm::clamp((p - bmin) * scale, glm::vec3(0.0f), glm::vec3(samples - 1));
+	glm::ivec3 cell = glm::min(glm::ivec3(g), samples - 2);
+	glm::vec3 t = g - glm::vec3(cell);
+	const float* v = values.data() + cellBase(cell.x, cell.y, cell.z);
+	const int sy = SDF_BRICK_SAMPLES, sz = SDF_BRICK_SAMPLES * SDF_BRICK_SAMPLES;
+
+	// the differences along x are lerped like the values, the gradient is exact for the interpolant
+	float x00 = v[1] - v[0];
+	float x10 = v[sy + 1] - v[sy];
+	float x01 = v[sz + 1] - v[sz];
+	float x11 = v[sz + sy + 1] - v[sz + sy];
+	float c00 = v[0] + t.x * x00;
+	float c10 = v[sy] + t.x * x10;
+	float c01 = v[sz] + t.x * x01;
+	float c11 = v[sz + sy] + t.x * x11;
+	float c0 = c00 + t.y * (c10 - c00);
+	float c1 = c01 + t.y * (c11 - c01);
+	dist = c0 + t.z * (c1 - c0);
+	float gx0 = x00 + t.y * (x10 - x00);
+	float gx1 = x01 + t.y * (x11 - x01);
+	grad.x = (gx0 + t.z * (gx1 - gx0)) * scale.x;
+	grad.y = ((c10 - c00) + t.z * ((c11 - c01) - (c10 - c00))) * scale.y;
+	grad.z = (c1 - c0) * scale.z;
+}
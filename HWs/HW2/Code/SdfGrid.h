@@ -0,0 +1,66 @@
+#ifndef SDFGRID_H
+#define SDFGRID_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Parallel.h"
+#include "VectorGrid.h"
+#include "MeshLoader.h"
+
+#define SDF_MAX_SAMPLES 256 // along one axis, the bake holds the whole lattice once
+
+// signed distances on a regular lattice spanning [bmin, bmax], negative inside the solid, read
+// back with trilinear interpolation together with the gradient of the interpolant
+// only a narrow band around the surface is exact, further away the distance is clamped to plus or
+// minus the band, so the samples are cut in bricks of GRID_BRICK^3 cells like the sparse VectorGrid
+// and all bricks that are entirely outside or entirely inside share one constant brick each
+class SdfGrid {
+
+public:
+	// a lattice of cubic cells over [lo, hi] grown by the band and one cell, the cells are cell
+	// wide unless that needs more than SDF_MAX_SAMPLES samples along an axis, band is bandCells of them
+	static glm::ivec3 fit(const glm::vec3& lo, const glm::vec3& hi, float cell, float bandCells, glm::vec3& gridLo, glm::vec3& gridHi, float& band);
+
+	// evaluates dist(position) at every sample on the thread pool, for analytic shapes
+	// inverted swaps inside and outside, the solid is then everything but the shape
+	template <class F>
+	void bake(const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, float band, bool inverted, const F& dist) {
+		std::vector<float> dense((size_t)count.x * count.y * count.z);
+		glm::vec3 step = (hi - lo) / glm::vec3(glm::max(count - 1, glm::ivec3(1)));
+		ThreadPool::get().parallelFor(0, count.z, [&](int b, int e, int) {
+			for (int z = b; z < e; z++)
+				for (int y = 0; y < count.y; y++)
+					for (int x = 0; x < count.x; x++)
+						dense[x + (size_t)count.x * (y + (size_t)count.y * z)] = dist(lo + step * glm::vec3(x, y, z));
+		});
+		build(lo, hi, count, band, inverted, dense);
+	}
+	// a closed mesh, within the band the distance is to the nearest triangle and the sign of
+	// every sample comes from the parity of the surface crossings before it along +x
+	void bakeMesh(const TriangleMesh& mesh, const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, float band, bool inverted);
+
+	// outside the lattice dist and grad are those of the nearest boundary point
+	void sample(const glm::vec3& p, float& dist, glm::vec3& grad) const;
+
+	bool empty() const { return values.empty(); }
+	size_t bytes() const { return values.size() * sizeof(float) + bricks.size() * sizeof(int32_t); }
+
+	glm::vec3 bmin = glm::vec3(0.0f);
+	glm::vec3 bmax = glm::vec3(0.0f);
+	glm::ivec3 samples = glm::ivec3(0);
+	float band = 0.0f;
+	bool inverted = false;
+
+private:
+	void build(const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, float band, bool inverted, std::vector<float>& dense);
+	int cellBase(int x, int y, int z) const;
+
+	std::vector<float> values; // the outside brick, the inside brick, then the bricks in the band
+	std::vector<int32_t> bricks; // first sample of every brick
+	glm::ivec3 brickCount = glm::ivec3(0);
+	glm::vec3 scale = glm::vec3(0.0f); // positions to lattice units
+};
+
+#endif
@@ -1,45 +1,33 @@
 #include "Sphere.h"
 
-Sphere::Sphere(int stack, int sector, bool smooth, float radius) : stack(stack), sector(sector), smooth(smooth), radius(radius){
-	genVertices();
-	genSmoothSphere();
+#include <thread>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+Sphere::Sphere(int stack, int sector, bool smooth, float radius) : radius(radius), stack(stack), sector(sector), smooth(smooth) {
+	generate();
 }
 
 void Sphere::setStack(int stack) {
-	stack = stack;
-	genVertices();
-	if (smooth)
-		genSmoothSphere();
-	else
-		genFlatSphere();
+	this->stack = stack;
+	generate();
 }
 void Sphere::setSector(int sector) {
-	sector = sector;
-	genVertices();
-	if (smooth)
-		genSmoothSphere();
-	else
-		genFlatSphere();
+	this->sector = sector;
+	generate();
 }
 
 void Sphere::setRadius(float radius) {
-    radius = radius;
-    genVertices();
-    if (smooth)
-        genSmoothSphere();
-    else
-        genFlatSphere();
+    this->radius = radius;
+    generate();
 }
 
 void Sphere::setDims(int stack, int sector, float radius) {
     this->radius = radius;
     this->stack = stack;
     this->sector = sector;
-    genVertices();
-    if (smooth)
-        genSmoothSphere();
-    else
-        genFlatSphere();
+    generate();
 }
 
 float* Sphere::getVertices() {
@@ -54,37 +42,62 @@ int* Sphere::getIndices() {
 	return &indices[0];
 }
 
+void Sphere::generate() {
+    genVertices();
+    genSmoothSphere();
+    if (!smooth)
+        genFlatSphere();
+}
+
 void Sphere::genVertices() {
-    vertices.clear();
-    normals.clear();
     const float PI = acos(-1);
-    float x, y, z, nx, ny, nz;
-
     float stackStep = PI / stack;
     float sectorStep = 2 * PI / sector;
-    float a_stack, a_sector;
+
+    // the tables only change with the tessellation, a radius change reuses them
+    if ((int)stackCos.size() != stack + 1) {
+        stackCos.resize(stack + 1);
+        stackSin.resize(stack + 1);
+        for (int i = 0; i <= stack; i++) {
+            float a_stack = PI / 2 - i * stackStep;
+            stackCos[i] = cosf(a_stack);
+            stackSin[i] = sinf(a_stack);
+        }
+    }
+    if ((int)sectorCos.size() != sector + 1) {
+        sectorCos.resize(sector + 1);
+        sectorSin.resize(sector + 1);
+        for (int j = 0; j <= sector; j++) {
+            float a_sector = j * sectorStep;
+            sectorCos[j] = cosf(a_sector);
+            sectorSin[j] = sinf(a_sector);
+        }
+    }
+
+    size_t count = (size_t)(stack + 1) * (sector + 1) * 3;
+    vertices.resize(count);
+    normals.resize(count);
+    float* v = &vertices[0];
+    float* n = &normals[0];
     for (int i = 0; i <= stack; i++) {
-        a_stack = PI / 2 - i * stackStep;
-        nz = sinf(a_stack);
+        float nz = stackSin[i];
         for (int j = 0; j <= sector; j++) {
-            a_sector = j * sectorStep;
-            nx = cosf(a_stack) * cosf(a_sector);
-            ny = cosf(a_stack) * sinf(a_sector);
-            x = radius * nx;
-            y = radius * ny;
-            z = radius * nz;
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            normals.push_back(nx);
-            normals.push_back(ny);
-            normals.push_back(nz);
+            float nx = stackCos[i] * sectorCos[j];
+            float ny = stackCos[i] * sectorSin[j];
+            *v++ = radius * nx;
+            *v++ = radius * ny;
+            *v++ = radius * nz;
+            *n++ = nx;
+            *n++ = ny;
+            *n++ = nz;
         }
     }
 }
 
 void Sphere::genSmoothSphere() {
     indices.clear();
+    // the pole rings have one triangle per sector, every other ring two
+    indices.reserve((size_t)std::max(stack - 1, 0) * sector * 6);
     unsigned int k1, k2;
     for (int i = 0; i < stack; i++) {
         k1 = i * (sector + 1);
@@ -105,6 +118,125 @@ void Sphere::genSmoothSphere() {
     }
 }
 
+// every triangle of the smooth sphere gets its own three vertices with the face normal
 void Sphere::genFlatSphere() {
+    std::vector<float> flatVertices(indices.size() * 3);
+    std::vector<float> flatNormals(indices.size() * 3);
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; k++)
+            p[k] = glm::vec3(vertices[indices[t + k] * 3], vertices[indices[t + k] * 3 + 1], vertices[indices[t + k] * 3 + 2]);
+        glm::vec3 n = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[0]));
+        for (int k = 0; k < 3; k++) {
+            size_t o = (t + k) * 3;
+            flatVertices[o] = p[k].x;
+            flatVertices[o + 1] = p[k].y;
+            flatVertices[o + 2] = p[k].z;
+            flatNormals[o] = n.x;
+            flatNormals[o + 1] = n.y;
+            flatNormals[o + 2] = n.z;
+        }
+        indices[t] = (int)t;
+        indices[t + 1] = (int)t + 1;
+        indices[t + 2] = (int)t + 2;
+    }
+    vertices.swap(flatVertices);
+    normals.swap(flatNormals);
+}
+
+SphereCache::~SphereCache() {
+    clear();
+}
+
+void SphereCache::clear() {
+    meshes.clear();
+    chain.clear();
+}
+
+void SphereCache::setLevels(int stack, int sector, bool smooth) {
+    // the chain halves both dimensions until the coarsest level, stacks and sectors keep their ratio
+    std::vector<Key> keys;
+    for (int st = stack, se = sector; ; st /= 2, se /= 2) {
+        keys.insert(keys.begin(), Key(st, std::max(se, 3), smooth));
+        if (st / 2 < SPHERE_MIN_STACK)
+            break;
+    }
+
+    std::vector<Key> missing;
+    for (auto& k : keys)
+        if (meshes.find(k) == meshes.end())
+            missing.push_back(k);
+
+    // geometry of the missing levels is built on their own threads, GL calls stay on this one
+    std::vector<Sphere*> built(missing.size(), nullptr);
+    std::vector<std::thread> builders;
+    for (size_t i = 0; i < missing.size(); i++)
+        builders.emplace_back([&, i]() {
+            built[i] = new Sphere(std::get<0>(missing[i]), std::get<1>(missing[i]), std::get<2>(missing[i]), 1.0f);
+        });
+    for (auto& b : builders)
+        b.join();
+
+    for (size_t i = 0; i < missing.size(); i++) {
+        SphereMesh& mesh = meshes[missing[i]];
+        mesh.stack = std::get<0>(missing[i]);
+        mesh.sector = std::get<1>(missing[i]);
+        upload(*built[i], mesh);
+        delete built[i];
+    }
+
+    chain.clear();
+    for (auto& k : keys) {
+        SphereMesh& mesh = meshes[k];
+        mesh.lastUsed = ++useCounter;
+        chain.push_back(&mesh);
+    }
+    evict();
+}
+
+int SphereCache::selectLevel(float radius, float distance, float fovY, float viewportHeight) const {
+    if (chain.empty())
+        return -1;
+    // projected diameter in pixels, a sphere around the camera takes the finest level
+    float diameter = distance > radius ? radius * viewportHeight / (distance * tanf(fovY / 2)) : viewportHeight;
+    float circumference = acos(-1) * diameter;
+    for (int i = 0; i < (int)chain.size(); i++)
+        if (circumference / chain[i]->sector <= SPHERE_LOD_EDGE_PIXELS)
+            return i;
+    return (int)chain.size() - 1;
+}
 
-}
\ No newline at end of file
+const SphereMesh& SphereCache::level(int i) {
+    chain[i]->lastUsed = ++useCounter;
+    return *chain[i];
+}
+
+void SphereCache::upload(const Sphere& sphere, SphereMesh& mesh) {
+    mesh.buffer.reset(new MeshBuffer());
+    mesh.buffer->AddAttribute(0, 3, sphere.vertices.data(), (unsigned int)(sphere.vertices.size() * sizeof(float)));
+    mesh.buffer->AddAttribute(1, 3, sphere.normals.data(), (unsigned int)(sphere.normals.size() * sizeof(float)));
+    mesh.buffer->SetIndices((const unsigned int*)sphere.indices.data(), (unsigned int)sphere.indices.size());
+    mesh.instances = mesh.buffer->AddInstanceAttribute(2, 4, nullptr, 0);
+}
+
+void SphereCache::drawInstanced(int i, const std::vector<glm::vec4>& spheres) {
+    if (spheres.empty())
+        return;
+    SphereMesh& mesh = *chain[i];
+    mesh.lastUsed = ++useCounter;
+    // the instance buffer keeps its storage, only the first frame at a new count grows it
+    mesh.buffer->UpdateAttribute(mesh.instances, spheres.data(), (unsigned int)(spheres.size() * sizeof(glm::vec4)));
+    mesh.buffer->Bind();
+    glDrawElementsInstanced(GL_TRIANGLES, mesh.buffer->getCount(), GL_UNSIGNED_INT, 0, (GLsizei)spheres.size());
+}
+
+void SphereCache::evict() {
+    while ((int)meshes.size() > SPHERE_CACHE_MAX) {
+        auto oldest = meshes.end();
+        for (auto it = meshes.begin(); it != meshes.end(); ++it)
+            if (oldest == meshes.end() || it->second.lastUsed < oldest->second.lastUsed)
+                oldest = it;
+        // the chain was just touched so it is always newer than anything evicted here
+        meshes.erase(oldest);
+    }
+}
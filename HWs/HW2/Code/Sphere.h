@@ -2,7 +2,18 @@
 #define SPHERE_H
 
 #include <vector>
+#include <map>
+#include <tuple>
 #include <cmath>
+#include <memory>
+#include <glm/glm.hpp>
+
+#include "MeshBuffer.h"
+
+#define SPHERE_MIN_STACK 4 // coarsest level of a chain
+#define SPHERE_LOD_EDGE_PIXELS 8.0f // longest on screen edge a level may have before a finer one is used
+#define SPHERE_CACHE_MAX 32 // resident meshes, the least recently used one outside the chain is dropped
+
 class Sphere {
 
 public:
@@ -19,6 +30,7 @@ public:
 	std::vector<float> normals;
 	std::vector<int> indices;
 private:
+	void generate();
 	void genVertices();
 	void genSmoothSphere();
 	void genFlatSphere();
@@ -28,6 +40,50 @@ private:
 	int sector;
 	bool smooth;
 
+	// cos and sin of every stack and sector angle, shared by all vertices of a ring
+	std::vector<float> stackCos, stackSin;
+	std::vector<float> sectorCos, sectorSin;
+
 };
-#endif // !SPHERE_H
 
+// unit sphere uploaded once, scaled by the radius in the model matrix
+struct SphereMesh {
+	std::unique_ptr<MeshBuffer> buffer; // positions at 0, normals at 1
+	int instances = -1; // buffer of per instance center and radius at 2, see drawInstanced
+	int stack = 0;
+	int sector = 0;
+	long long lastUsed = 0;
+};
+
+// GPU resident sphere meshes keyed by (stack, sector, smooth), a chain of levels halving the
+// tessellation down to SPHERE_MIN_STACK is picked from per sphere by its size on screen
+class SphereCache {
+
+public:
+	~SphereCache();
+	// drops every mesh, must run while the context that uploaded them is current
+	void clear();
+
+	// finest level of the chain, missing levels are built in parallel and uploaded
+	void setLevels(int stack, int sector, bool smooth);
+	int levelCount() const { return (int)chain.size(); }
+
+	// coarsest level whose edges stay under SPHERE_LOD_EDGE_PIXELS at this distance
+	int selectLevel(float radius, float distance, float fovY, float viewportHeight) const;
+	const SphereMesh& level(int i);
+
+	// one instanced draw per level, spheres are center xyz and radius w
+	void drawInstanced(int level, const std::vector<glm::vec4>& spheres);
+
+private:
+	typedef std::tuple<int, int, bool> Key;
+
+	void upload(const Sphere& sphere, SphereMesh& mesh);
+	void evict();
+
+	std::map<Key, SphereMesh> meshes;
+	std::vector<SphereMesh*> chain; // coarse to fine
+	long long useCounter = 0;
+};
+
+#endif // !SPHERE_H
@@ -0,0 +1,101 @@
+#include "SurfaceSampler.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <algorithm>
+
+#define SURFACE_GRAIN 4096
+
+// splitmix64, the uniforms of a sample are a pure function of the seed and its number
+static inline uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static inline float unit(uint64_t bits) {
+	return (float)(bits >> 40) * (1.0f / 16777216.0f); // 24 bits, [0, 1)
+}
+
+void SurfaceSampler::build(const TriangleMesh& source) {
+	mesh = source;
+	if (mesh.normals.size() != mesh.positions.size())
+		mesh.computeNormals();
+	int n = mesh.triangleCount();
+	std::vector<double> area(n);
+	ThreadPool::get().parallelFor(0, n, [&](int b, int e, int) {
+		for (int t = b; t < e; t++) {
+			const glm::vec3& a = mesh.positions[mesh.indices[3 * t]];
+			const glm::vec3& c1 = mesh.positions[mesh.indices[3 * t + 1]];
+			const glm::vec3& c2 = mesh.positions[mesh.indices[3 * t + 2]];
+			area[t] = 0.5 * (double)glm::length(glm::cross(c1 - a, c2 - a));
+		}
+	}, SURFACE_GRAIN);
+	double total = 0.0;
+	for (double a : area)
+		total += a;
+	totalArea = (float)total;
+	if (n == 0 || !(total > 0.0)) {
+		prob.clear();
+		alias.clear();
+		return;
+	}
+
+	// scaled so the mean column is 1, columns under 1 are topped up from one over 1
+	prob.resize(n);
+	alias.resize(n);
+	std::vector<double> scaled(n);
+	std::vector<uint32_t> small, large;
+	small.reserve(n);
+	large.reserve(n);
+	for (int t = 0; t < n; t++) {
+		scaled[t] = area[t] * n / total;
+		(scaled[t] < 1.0 ? small : large).push_back(t);
+	}
+	while (!small.empty() && !large.empty()) {
+		uint32_t s = small.back(), l = large.back();
+		small.pop_back();
+		prob[s] = (float)scaled[s];
+		alias[s] = l;
+		scaled[l] -= 1.0 - scaled[s];
+		if (scaled[l] < 1.0) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	// what is left is 1 up to rounding
+	for (uint32_t t : large) {
+		prob[t] = 1.0f;
+		alias[t] = t;
+	}
+	for (uint32_t t : small) {
+		prob[t] = 1.0f;
+		alias[t] = t;
+	}
+}
+
+void SurfaceSampler::sample(uint64_t seed, uint64_t first, int n, glm::vec3* p, glm::vec3* normal) const {
+	if (empty() || n <= 0)
+		return;
+	uint32_t columns = (uint32_t)prob.size();
+	uint64_t key = mix(seed);
+	ThreadPool::get().parallelFor(0, n, [&](int b, int e, int) {
+		for (int i = b; i < e; i++) {
+			uint64_t r0 = mix(key ^ (first + (uint64_t)i));
+			uint64_t r1 = mix(r0);
+			// the top 32 bits pick the column, the low 24 bits decide against its alias
+			uint32_t k = (uint32_t)(((r0 >> 32) * columns) >> 32);
+			uint32_t t = unit(r0 << 40) < prob[k] ? k : alias[k];
+
+			float s = std::sqrt(unit(r1));
+			float v = unit(r1 << 24);
+			float b1 = s * (1.0f - v), b2 = s * v, b0 = 1.0f - s;
+			unsigned int i0 = mesh.indices[3 * t], i1 = mesh.indices[3 * t + 1], i2 = mesh.indices[3 * t + 2];
+			p[i] = b0 * mesh.positions[i0] + b1 * mesh.positions[i1] + b2 * mesh.positions[i2];
+			glm::vec3 nrm = b0 * mesh.normals[i0] + b1 * mesh.normals[i1] + b2 * mesh.normals[i2];
+			float l = glm::length(nrm);
+			normal[i] = l > 0.0f ? nrm / l : glm::vec3(0.0f, 0.0f, 1.0f);
+		}
+	}, SURFACE_GRAIN);
+}
@@ -0,0 +1,35 @@
+#ifndef SURFACESAMPLER_H
+#define SURFACESAMPLER_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "MeshLoader.h"
+
+// uniformly distributed points on the surface of a triangle mesh
+// the triangle is picked with an area weighted alias table, one uniform picks a column and
+// a second one either keeps it or takes its alias, so a sample costs the same for ten triangles
+// as for millions, the point inside the triangle is uniform by the square root mapping and its
+// normal is interpolated from the vertex normals
+// samples are numbered, sample i of a seed is the same however the batches are split over threads
+class SurfaceSampler {
+
+public:
+	// Vose's construction, linear in the triangle count, degenerate triangles are never picked
+	void build(const TriangleMesh& mesh);
+
+	// n samples starting at sample number first, positions and unit normals
+	void sample(uint64_t seed, uint64_t first, int n, glm::vec3* p, glm::vec3* normal) const;
+
+	bool empty() const { return prob.empty(); }
+	float area() const { return totalArea; }
+
+private:
+	TriangleMesh mesh;
+	std::vector<float> prob; // chance of keeping column k instead of taking alias[k]
+	std::vector<uint32_t> alias;
+	float totalArea = 0.0f;
+};
+
+#endif
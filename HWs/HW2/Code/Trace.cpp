@@ -0,0 +1,122 @@
+#include "Trace.h"
+
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <imgui/imgui.h>
+
+static thread_local TraceBuffer* localBuffer = nullptr;
+
+Tracer& Tracer::get() {
+	static Tracer tracer;
+	return tracer;
+}
+
+TraceBuffer* Tracer::threadBuffer() {
+	if (localBuffer)
+		return localBuffer;
+	std::lock_guard<std::mutex> lock(registry);
+	TraceBuffer* b = new TraceBuffer();
+	b->events.reset(new TraceEvent[TRACE_BUFFER_EVENTS]);
+	b->count = 0;
+	b->tid = (int)buffers.size() + 1;
+	b->name = b->tid == 1 ? "Main" : "Thread " + std::to_string(b->tid);
+	buffers.emplace_back(b);
+	localBuffer = b;
+	return b;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+	TraceBuffer* b = threadBuffer();
+	std::lock_guard<std::mutex> lock(registry);
+	b->name = name;
+}
+
+void Tracer::record(const char* name, char phase) {
+	TraceBuffer* b = threadBuffer();
+	uint32_t n = b->count.load(std::memory_order_relaxed);
+	if (n >= TRACE_BUFFER_EVENTS) {
+		b->dropped++;
+		return;
+	}
+	TraceEvent& e = b->events[n];
+	e.name = name;
+	e.ts = traceTicks();
+	e.phase = phase;
+	b->count.store(n + 1, std::memory_order_release);
+}
+
+void Tracer::capture(int frames, const std::string& path) {
+	framesLeft = std::max(frames, 1);
+	capturePath = path;
+	pending = true;
+}
+
+// recording only starts and stops between frames so no scope is cut in half
+void Tracer::frameEnd() {
+	if (recording) {
+		if (--framesLeft > 0)
+			return;
+		recording = false;
+		endTicks = traceTicks();
+		endTime = std::chrono::steady_clock::now();
+		write(capturePath);
+	}
+	else if (pending) {
+		std::lock_guard<std::mutex> lock(registry);
+		for (auto& b : buffers) {
+			b->count = 0;
+			b->dropped = 0;
+		}
+		pending = false;
+		startTicks = traceTicks();
+		startTime = std::chrono::steady_clock::now();
+		recording = true;
+	}
+}
+
+bool Tracer::write(const std::string& path) {
+	FILE* f = fopen(path.c_str(), "w");
+	if (!f) {
+		printf("ERROR: Trace File Writing Failed: %s\n", path.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(registry);
+	double elapsedUs = std::chrono::duration<double, std::micro>(endTime - startTime).count();
+	double usPerTick = endTicks > startTicks ? elapsedUs / (double)(endTicks - startTicks) : 0.0;
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+	uint32_t dropped = 0;
+	for (auto& b : buffers) {
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+			first ? "" : ",\n", b->tid, b->name.c_str());
+		first = false;
+		uint32_t n = b->count.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < n; i++) {
+			const TraceEvent& e = b->events[i];
+			fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+				e.name, e.phase, b->tid, (e.ts - startTicks) * usPerTick);
+		}
+		dropped += b->dropped;
+	}
+	fprintf(f, "\n]}\n");
+	fclose(f);
+	if (dropped > 0)
+		printf("Trace buffers were full, %u events dropped\n", dropped);
+	lastWritten = path;
+	return true;
+}
+
+void Tracer::gui() {
+	ImGui::SliderInt("Trace Frames", &guiFrames, 1, 600);
+	if (active() || pending) {
+		ImGui::Text("Capturing, %d frames left", framesLeft);
+	}
+	else if (ImGui::Button("Capture Trace")) {
+		capture(guiFrames, "trace_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".json");
+	}
+	if (!lastWritten.empty())
+		ImGui::Text("Last trace: %s", lastWritten.c_str());
+}
@@ -0,0 +1,101 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+
+#define TRACE_BUFFER_EVENTS (1 << 18) // per thread, events past this are dropped
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+// the time stamp counter is a few times cheaper to read than the steady clock, ticks are
+// converted to ns against the steady clock over the capture when the trace is written
+inline int64_t traceTicks() { return (int64_t)__rdtsc(); }
+#else
+inline int64_t traceTicks() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+#endif
+
+struct TraceEvent {
+	const char* name; // must outlive the capture, string literals and stage names
+	int64_t ts; // ticks, see traceTicks
+	char phase; // 'B' or 'E'
+};
+
+// events of one thread, only the owning thread writes so recording takes no lock
+struct TraceBuffer {
+	std::unique_ptr<TraceEvent[]> events;
+	std::atomic<uint32_t> count;
+	uint32_t dropped = 0;
+	int tid;
+	std::string name;
+};
+
+// records begin/end events while a capture is running and writes them as Chrome trace json,
+// which loads in chrome://tracing and ui.perfetto.dev
+class Tracer {
+
+public:
+	static Tracer& get();
+
+	// records the next frames, the file is written when the last one ends
+	void capture(int frames, const std::string& path);
+	void frameEnd();
+	bool active() const { return recording.load(std::memory_order_relaxed); }
+
+	void begin(const char* name) {
+		if (active())
+			record(name, 'B');
+	}
+	void end(const char* name) {
+		if (active())
+			record(name, 'E');
+	}
+	void setThreadName(const std::string& name);
+
+	bool write(const std::string& path);
+	void gui();
+
+private:
+	void record(const char* name, char phase);
+	TraceBuffer* threadBuffer();
+
+	std::atomic<bool> recording{ false };
+	bool pending = false; // capture requested, starts at the next frame end
+	int framesLeft = 0;
+	std::string capturePath;
+	// tick and steady clock pairs at the start and end of the capture
+	int64_t startTicks = 0;
+	int64_t endTicks = 0;
+	std::chrono::steady_clock::time_point startTime;
+	std::chrono::steady_clock::time_point endTime;
+	std::string lastWritten;
+	int guiFrames = 60;
+
+	std::mutex registry; // guards buffers when a thread records for the first time
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+class TraceScope {
+
+public:
+	TraceScope(const char* name) : name(name) { Tracer::get().begin(name); }
+	~TraceScope() { Tracer::get().end(name); }
+
+private:
+	const char* name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif
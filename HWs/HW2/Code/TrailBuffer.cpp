@@ -0,0 +1,85 @@
+#include "TrailBuffer.h"
+#include <glad/glad.h>
+
+#include <iostream>
+#include <algorithm>
+
+TrailBuffer::TrailBuffer(int slots, int length) : slots(std::max(slots, 1)), length(std::min(std::max(length, 2), TRAIL_MAX_LENGTH)) {
+	// buffer textures may be as small as 64k texels, shorter trails fit where the full ones do not
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if ((long long)this->slots * this->length > maxTexels) {
+		std::cout << "ERROR: Trail Buffer Too Large: " << this->slots << " x " << this->length << " samples, " << maxTexels << " allowed" << std::endl;
+		this->length = std::max(2, maxTexels / this->slots);
+	}
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)this->slots * this->length * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glGenVertexArrays(1, &vao);
+
+	owner.resize(this->slots);
+	born.resize(this->slots);
+	stage.resize(this->slots);
+	reset();
+}
+
+TrailBuffer::~TrailBuffer() {
+	glDeleteVertexArrays(1, &vao);
+	glDeleteTextures(1, &texture);
+	glDeleteBuffers(1, &buffer);
+}
+
+// the slices still on the gpu are only read up to the valid count, so they need no clearing
+void TrailBuffer::reset() {
+	head = 0;
+	slice = 0;
+	used = 0;
+	std::fill(born.begin(), born.end(), -1);
+	std::fill(stage.begin(), stage.end(), glm::vec4(0.0f));
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	for (int s = 0; s < length; s++)
+		glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)s * slots * sizeof(glm::vec4), slots * sizeof(glm::vec4), stage.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TrailBuffer::record(const ParticleData& pd) {
+	head = slice % length;
+	// slots that were in use last time and are free now still need their empty sample
+	int top = 0;
+	for (int i = 0; i < pd.n_alive; i++)
+		top = std::max(top, pd.slot[i] + 1);
+	top = std::min(top, slots);
+	std::fill(stage.begin(), stage.begin() + std::max(top, used), glm::vec4(0.0f));
+	for (int i = 0; i < pd.n_alive; i++) {
+		int s = pd.slot[i];
+		if (s >= slots)
+			continue;
+		if (born[s] < 0 || owner[s] != pd.id[i]) {
+			owner[s] = pd.id[i];
+			born[s] = slice;
+		}
+		int valid = std::min(slice - born[s] + 1, length);
+		stage[s] = glm::vec4(pd.p[i], (float)valid);
+	}
+	slice++;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)head * slots * sizeof(glm::vec4), std::max(top, used) * sizeof(glm::vec4), stage.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	used = top;
+}
+
+void TrailBuffer::draw(int unit) const {
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glBindVertexArray(vao);
+	glDrawArraysInstanced(GL_LINE_STRIP, 0, length, used);
+	glBindVertexArray(0);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,49 @@
+#ifndef TRAILBUFFER_H
+#define TRAILBUFFER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ParticleData.h"
+
+#define TRAIL_MAX_LENGTH 128
+
+// the last length positions of every particle of a generator, kept only on the gpu
+// the history is a ring of slices, a slice is one vec4 per particle slot, record() uploads the
+// newest slice over the oldest and moves head, nothing is shifted and older slices are never
+// uploaded again, the trail vertex shader walks back from head through a buffer texture
+// a particle writes its ParticleData slot, so slots has to be at least the generator capacity,
+// only the slots below the highest one in use are uploaded and drawn
+class TrailBuffer {
+
+public:
+	TrailBuffer(int slots, int length);
+	~TrailBuffer();
+	TrailBuffer(const TrailBuffer&) = delete;
+	TrailBuffer& operator=(const TrailBuffer&) = delete;
+
+	// w of a sample is how many samples of its trail are valid, 0 for a slot without a particle
+	void record(const ParticleData& pd);
+	void reset();
+	// one line strip of length vertices per slot in use, the history is bound to the texture unit
+	void draw(int unit) const;
+
+	int getHead() const { return head; }
+	int getLength() const { return length; }
+	int getSlots() const { return slots; }
+
+private:
+	unsigned int buffer = 0;
+	unsigned int texture = 0;
+	unsigned int vao = 0; // the strips have no attributes but a vertex array has to be bound
+	int slots;
+	int length;
+	int head = 0; // slice written last
+	int slice = 0; // slices recorded since reset
+	int used = 0; // one past the highest slot of the last slice with a particle
+	std::vector<unsigned int> owner; // id of the particle in each slot
+	std::vector<int> born; // slice the owner was first recorded at, -1 when no particle was
+	std::vector<glm::vec4> stage;
+};
+
+#endif
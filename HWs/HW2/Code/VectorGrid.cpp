@@ -0,0 +1,245 @@
+#include "VectorGrid.h"
+#include "MeshLoader.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GRID_AVX2
+#endif
+
+#define GRID_BRICK_SAMPLES (GRID_BRICK + 1) // along one edge, the last ones are shared with the next brick
+
+void VectorGrid::build(const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, const std::vector<glm::vec3>& dense, bool sparse) {
+	bmin = lo;
+	bmax = hi;
+	samples = count;
+	this->sparse = sparse;
+	scale = glm::vec3(count - 1) / glm::max(hi - lo, glm::vec3(1e-30f));
+	bricks.clear();
+	brickCount = glm::ivec3(0);
+
+	if (!sparse) {
+		stride[0] = 1;
+		stride[1] = count.x;
+		stride[2] = count.x * count.y;
+		for (int c = 0; c < 3; c++) {
+			values[c].resize(dense.size());
+			for (size_t i = 0; i < dense.size(); i++)
+				values[c][i] = dense[i][c];
+		}
+		return;
+	}
+
+	const int S = GRID_BRICK_SAMPLES;
+	stride[0] = 1;
+	stride[1] = S;
+	stride[2] = S * S;
+	brickCount = (count - 1 + GRID_BRICK - 1) / GRID_BRICK;
+	bricks.assign((size_t)brickCount.x * brickCount.y * brickCount.z, 0);
+	for (int c = 0; c < 3; c++)
+		values[c].assign(S * S * S, 0.0f);
+
+	// samples past the end of the lattice in the last bricks repeat the boundary
+	auto at = [&](int x, int y, int z) {
+		x = std::min(x, count.x - 1);
+		y = std::min(y, count.y - 1);
+		z = std::min(z, count.z - 1);
+		return dense[x + (size_t)count.x * (y + (size_t)count.y * z)];
+	};
+	for (int bz = 0; bz < brickCount.z; bz++) {
+		for (int by = 0; by < brickCount.y; by++) {
+			for (int bx = 0; bx < brickCount.x; bx++) {
+				int x0 = bx * GRID_BRICK, y0 = by * GRID_BRICK, z0 = bz * GRID_BRICK;
+				bool zero = true;
+				for (int z = 0; z < S && zero; z++)
+					for (int y = 0; y < S && zero; y++)
+						for (int x = 0; x < S && zero; x++)
+							zero = at(x0 + x, y0 + y, z0 + z) == glm::vec3(0.0f);
+				if (zero)
+					continue;
+				int offset = (int)values[0].size();
+				bricks[bx + (size_t)brickCount.x * (by + (size_t)brickCount.y * bz)] = offset;
+				for (int c = 0; c < 3; c++)
+					values[c].resize(offset + S * S * S);
+				for (int z = 0; z < S; z++)
+					for (int y = 0; y < S; y++)
+						for (int x = 0; x < S; x++) {
+							glm::vec3 v = at(x0 + x, y0 + y, z0 + z);
+							int i = offset + x + S * (y + S * z);
+							values[0][i] = v.x;
+							values[1][i] = v.y;
+							values[2][i] = v.z;
+						}
+			}
+		}
+	}
+}
+
+int VectorGrid::cellBase(int x, int y, int z) const {
+	if (!sparse)
+		return x + samples.x * (y + samples.y * z);
+	int brick = (x >> GRID_BRICK_SHIFT) + brickCount.x * ((y >> GRID_BRICK_SHIFT) + brickCount.y * (z >> GRID_BRICK_SHIFT));
+	const int mask = GRID_BRICK - 1;
+	return bricks[brick] + (x & mask) + GRID_BRICK_SAMPLES * ((y & mask) + GRID_BRICK_SAMPLES * (z & mask));
+}
+
+glm::vec3 VectorGrid::denseValue(int x, int y, int z) const {
+	// the last sample of an axis is the far face of the last cell
+	glm::ivec3 cell = glm::min(glm::ivec3(x, y, z), samples - 2);
+	int i = cellBase(cell.x, cell.y, cell.z) + (x - cell.x) * stride[0] + (y - cell.y) * stride[1] + (z - cell.z) * stride[2];
+	return glm::vec3(values[0][i], values[1][i], values[2][i]);
+}
+
+size_t VectorGrid::bytes() const {
+	return 3 * values[0].size() * sizeof(float) + bricks.size() * sizeof(int32_t);
+}
+
+glm::vec3 VectorGrid::sample(const glm::vec3& p) const {
+	glm::vec3 g = glm::clamp((p - bmin) * scale, glm::vec3(0.0f), glm::vec3(samples - 1));
+	glm::ivec3 cell = glm::min(glm::ivec3(g), samples - 2);
+	glm::vec3 t = g - glm::vec3(cell);
+	int base = cellBase(cell.x, cell.y, cell.z);
+	int sx = stride[0], sy = stride[1], sz = stride[2];
+	glm::vec3 r;
+	for (int c = 0; c < 3; c++) {
+		const float* v = values[c].data() + base;
+		float c00 = v[0] + t.x * (v[sx] - v[0]);
+		float c10 = v[sy] + t.x * (v[sy + sx] - v[sy]);
+		float c01 = v[sz] + t.x * (v[sz + sx] - v[sz]);
+		float c11 = v[sz + sy] + t.x * (v[sz + sy + sx] - v[sz + sy]);
+		float c0 = c00 + t.y * (c10 - c00);
+		float c1 = c01 + t.y * (c11 - c01);
+		r[c] = c0 + t.z * (c1 - c0);
+	}
+	return r;
+}
+
+#ifdef GRID_AVX2
+static inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+	return _mm256_fmadd_ps(t, _mm256_sub_ps(b, a), a);
+}
+#endif
+
+void VectorGrid::sample(const glm::vec3* p, int n, glm::vec3* out) const {
+	int i = 0;
+#ifdef GRID_AVX2
+	// eight positions per step, the corners of their cells are fetched with gathers from each
+	// component plane, the cell math is the scalar path done in lanes
+	const float* pf = &p[0].x;
+	const __m256i lane3 = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 lo[3], sc[3], top[3];
+	__m256i last[3];
+	for (int a = 0; a < 3; a++) {
+		lo[a] = _mm256_set1_ps(bmin[a]);
+		sc[a] = _mm256_set1_ps(scale[a]);
+		top[a] = _mm256_set1_ps((float)(samples[a] - 1));
+		last[a] = _mm256_set1_epi32(samples[a] - 2);
+	}
+	const __m256i sx = _mm256_set1_epi32(stride[0]);
+	const __m256i sy = _mm256_set1_epi32(stride[1]);
+	const __m256i sz = _mm256_set1_epi32(stride[2]);
+	const __m256i mask = _mm256_set1_epi32(GRID_BRICK - 1);
+	const __m256i brickSamples = _mm256_set1_epi32(GRID_BRICK_SAMPLES);
+	for (; i + 8 <= n; i += 8) {
+		__m256 t[3];
+		__m256i cell[3];
+		for (int a = 0; a < 3; a++) {
+			__m256 x = _mm256_i32gather_ps(pf + 3 * i + a, lane3, 4);
+			__m256 g = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(x, lo[a]), sc[a]), zero), top[a]);
+			cell[a] = _mm256_min_epi32(_mm256_cvttps_epi32(g), last[a]);
+			t[a] = _mm256_sub_ps(g, _mm256_cvtepi32_ps(cell[a]));
+		}
+
+		__m256i base;
+		if (!sparse) {
+			base = _mm256_add_epi32(cell[0], _mm256_mullo_epi32(_mm256_set1_epi32(samples.x),
+				_mm256_add_epi32(cell[1], _mm256_mullo_epi32(_mm256_set1_epi32(samples.y), cell[2]))));
+		}
+		else {
+			__m256i bx = _mm256_srli_epi32(cell[0], GRID_BRICK_SHIFT);
+			__m256i by = _mm256_srli_epi32(cell[1], GRID_BRICK_SHIFT);
+			__m256i bz = _mm256_srli_epi32(cell[2], GRID_BRICK_SHIFT);
+			__m256i brick = _mm256_add_epi32(bx, _mm256_mullo_epi32(_mm256_set1_epi32(brickCount.x),
+				_mm256_add_epi32(by, _mm256_mullo_epi32(_mm256_set1_epi32(brickCount.y), bz))));
+			__m256i offset = _mm256_i32gather_epi32((const int*)bricks.data(), brick, 4);
+			__m256i local = _mm256_add_epi32(_mm256_and_si256(cell[0], mask), _mm256_mullo_epi32(brickSamples,
+				_mm256_add_epi32(_mm256_and_si256(cell[1], mask), _mm256_mullo_epi32(brickSamples, _mm256_and_si256(cell[2], mask)))));
+			base = _mm256_add_epi32(offset, local);
+		}
+		__m256i b010 = _mm256_add_epi32(base, sy);
+		__m256i b001 = _mm256_add_epi32(base, sz);
+		__m256i b011 = _mm256_add_epi32(b010, sz);
+
+		alignas(32) float r[3][8];
+		for (int c = 0; c < 3; c++) {
+			const float* v = values[c].data();
+			__m256 c00 = lerp8(_mm256_i32gather_ps(v, base, 4), _mm256_i32gather_ps(v, _mm256_add_epi32(base, sx), 4), t[0]);
+			__m256 c10 = lerp8(_mm256_i32gather_ps(v, b010, 4), _mm256_i32gather_ps(v, _mm256_add_epi32(b010, sx), 4), t[0]);
+			__m256 c01 = lerp8(_mm256_i32gather_ps(v, b001, 4), _mm256_i32gather_ps(v, _mm256_add_epi32(b001, sx), 4), t[0]);
+			__m256 c11 = lerp8(_mm256_i32gather_ps(v, b011, 4), _mm256_i32gather_ps(v, _mm256_add_epi32(b011, sx), 4), t[0]);
+			_mm256_store_ps(r[c], lerp8(lerp8(c00, c10, t[1]), lerp8(c01, c11, t[1]), t[2]));
+		}
+		for (int k = 0; k < 8; k++)
+			out[i + k] = glm::vec3(r[0][k], r[1][k], r[2][k]);
+	}
+#endif
+	for (; i < n; i++)
+		out[i] = sample(p[i]);
+}
+
+bool VectorGrid::load(const std::string& path, bool sparse) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		std::cout << "ERROR: Grid File Reading Failed: " << path << std::endl;
+		return false;
+	}
+	GridFileHeader header;
+	bool ok = file.getSize() >= sizeof(header);
+	if (ok) {
+		memcpy(&header, file.getData(), sizeof(header));
+		ok = header.magic == GRID_FILE_MAGIC && header.version == GRID_FILE_VERSION;
+		for (int a = 0; a < 3 && ok; a++)
+			ok = header.samples[a] >= 2 && header.samples[a] <= GRID_MAX_SAMPLES && header.bmin[a] < header.bmax[a];
+	}
+	size_t count = ok ? (size_t)header.samples[0] * header.samples[1] * header.samples[2] : 0;
+	if (!ok || file.getSize() != sizeof(header) + count * sizeof(glm::vec3)) {
+		std::cout << "ERROR: Grid File Invalid: " << path << std::endl;
+		return false;
+	}
+	std::vector<glm::vec3> dense(count);
+	memcpy(dense.data(), file.getData() + sizeof(header), count * sizeof(glm::vec3));
+	build(glm::vec3(header.bmin[0], header.bmin[1], header.bmin[2]), glm::vec3(header.bmax[0], header.bmax[1], header.bmax[2]),
+		glm::ivec3(header.samples[0], header.samples[1], header.samples[2]), dense, sparse);
+	return true;
+}
+
+bool VectorGrid::save(const std::string& path) const {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "ERROR: Grid File Writing Failed: " << path << std::endl;
+		return false;
+	}
+	GridFileHeader header = {};
+	header.magic = GRID_FILE_MAGIC;
+	header.version = GRID_FILE_VERSION;
+	for (int a = 0; a < 3; a++) {
+		header.samples[a] = samples[a];
+		header.bmin[a] = bmin[a];
+		header.bmax[a] = bmax[a];
+	}
+	out.write((const char*)&header, sizeof(header));
+	std::vector<glm::vec3> row(samples.x);
+	for (int z = 0; z < samples.z; z++) {
+		for (int y = 0; y < samples.y; y++) {
+			for (int x = 0; x < samples.x; x++)
+				row[x] = denseValue(x, y, z);
+			out.write((const char*)row.data(), row.size() * sizeof(glm::vec3));
+		}
+	}
+	return (bool)out;
+}
@@ -0,0 +1,77 @@
+#ifndef VECTORGRID_H
+#define VECTORGRID_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Parallel.h"
+
+#define GRID_FILE_MAGIC 0x44524756 // "VGRD"
+#define GRID_FILE_VERSION 1
+#define GRID_BRICK_SHIFT 3
+#define GRID_BRICK (1 << GRID_BRICK_SHIFT) // cells along each edge of a brick in the sparse layout
+#define GRID_MAX_SAMPLES 1024 // along one axis
+
+// on disk: GridFileHeader, then samples.x * samples.y * samples.z vec3 of floats, x fastest
+struct GridFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	int32_t samples[3];
+	float bmin[3];
+	float bmax[3];
+};
+
+// vector samples on a regular lattice spanning [bmin, bmax], read back with trilinear
+// interpolation, positions outside the lattice get the value of the nearest boundary
+// dense layout keeps the samples in one array with x fastest, the sparse layout cuts the cells in
+// bricks of GRID_BRICK^3 that hold their own samples including the shared faces, so a cell never
+// spans two bricks, and bricks that are zero everywhere all point at one shared zero brick
+// either way a cell is a base index plus three strides, so both share one gather kernel
+class VectorGrid {
+
+public:
+	bool load(const std::string& path, bool sparse = false);
+	bool save(const std::string& path) const;
+
+	// evaluates field(position) at every sample on the thread pool
+	template <class F>
+	void bake(const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, bool sparse, const F& field) {
+		std::vector<glm::vec3> dense((size_t)count.x * count.y * count.z);
+		glm::vec3 step = (hi - lo) / glm::vec3(glm::max(count - 1, glm::ivec3(1)));
+		ThreadPool::get().parallelFor(0, count.z, [&](int b, int e, int) {
+			for (int z = b; z < e; z++)
+				for (int y = 0; y < count.y; y++)
+					for (int x = 0; x < count.x; x++)
+						dense[x + (size_t)count.x * (y + (size_t)count.y * z)] = field(lo + step * glm::vec3(x, y, z));
+		});
+		build(lo, hi, count, dense, sparse);
+	}
+
+	glm::vec3 sample(const glm::vec3& p) const;
+	// n positions at once, eight per step with avx2
+	void sample(const glm::vec3* p, int n, glm::vec3* out) const;
+
+	bool empty() const { return values[0].empty(); }
+	bool isSparse() const { return sparse; }
+	size_t bytes() const;
+
+	glm::vec3 bmin = glm::vec3(0.0f);
+	glm::vec3 bmax = glm::vec3(0.0f);
+	glm::ivec3 samples = glm::ivec3(0);
+
+private:
+	void build(const glm::vec3& lo, const glm::vec3& hi, const glm::ivec3& count, const std::vector<glm::vec3>& dense, bool sparse);
+	glm::vec3 denseValue(int x, int y, int z) const; // for save, works on both layouts
+	int cellBase(int x, int y, int z) const;
+
+	std::vector<float> values[3]; // one plane per component
+	std::vector<int32_t> bricks; // sparse only, first sample of every brick, 0 is the zero brick
+	glm::ivec3 brickCount = glm::ivec3(0);
+	int stride[3] = { 0, 0, 0 }; // from a sample to its +x, +y and +z neighbour
+	glm::vec3 scale = glm::vec3(0.0f); // positions to lattice units
+	bool sparse = false;
+};
+
+#endif
@@ -4,6 +4,13 @@
 #include <string>
 #include <chrono>
 #include <random>
+#include <memory>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -17,14 +24,30 @@
 #include <glm/gtc/random.hpp>
 #include <cmath>
 #include "shader.h"
+#include "CameraBuffer.h"
 #include "Sphere.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
-
-#define MAX_PARTICLE_PER_GENERATOR 10000
-#define MAX_PARTICLES 100000
-
-int main();
+#include "MeshBuffer.h"
+#include "Arena.h"
+#include "ParticleData.h"
+#include "ForceField.h"
+#include "MeshLoader.h"
+#include "Collider.h"
+#include "Culling.h"
+#include "Morton.h"
+#include "DepthSort.h"
+#include "TrailBuffer.h"
+#include "SurfaceSampler.h"
+#include "FrameCapture.h"
+#include "GLContext.h"
+#include "CameraPath.h"
+#include "PerfCounter.h"
+#include "Scene.h"
+#include "Profiler.h"
+#include "Trace.h"
+
+int main(int argc, char** argv);
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -48,34 +71,32 @@ float deltaTimeFrame = .0f;
 float lastFrame = .0f;
 bool timeToSimulate = false;
 
-struct particle_gpu {
-    glm::vec3 p;
-    glm::vec3 c;
-};
-
-struct particle_cpu {
-    glm::vec3 v;
-    float m;
-    float LS;
-    float COF;
-    float COR;
-    float age;
-};
-
-struct particleGenerator { //for now this is a directional generator, gonna add polygonal ones in the future put have to refactor etc
-    unsigned int vao;
-    particle_gpu* pgpus;
-    particle_cpu* pcpus;
+// a directional generator emitting from the point p, or a surface generator emitting from a mesh placed at p
+struct particleGenerator {
+    unsigned int vao = 0;
+    std::unique_ptr<VertexBuffer> vb; // no buffer in headless runs
+    std::unique_ptr<IndexBuffer> ib; // back to front draw order of vb when depth sorting
+    std::unique_ptr<TrailBuffer> trail; // null while trails are off
+    Arena storage; // columns of pd and the upload staging, only rewound when the capacity changes
+    ParticleData pd;
+    particle_gpu* pgpus = nullptr; // interleaved upload staging for pd
+    glm::vec3* pPrev = nullptr; // positions before the last integration step, frame scratch
+    int visible = 0; // particles packed into pgpus last frame
     glm::vec3 p; //position
     glm::vec3 v; //velocity
     glm::vec3 d; //direction
     float P; // period
     float t; // time
-    int pnum = 0;
-};
-
-struct collider {
-    glm::vec3* v;
+    // given to every emitted particle
+    float m;
+    float LS;
+    float COF;
+    float COR;
+    int count; // particles per emission
+    float speed; // along the surface normal
+    std::unique_ptr<SurfaceSampler> surface; // null for a point generator
+    uint64_t seed = 0;
+    uint64_t emitted = 0; // surface samples drawn since the reset, numbers the next batch
 };
 
 void generateWireframeCube(float cubeSize, float* vertices) {
@@ -136,42 +157,391 @@ void particleShaderSetup() {
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float))); // color
 }
 
-float hpSign(glm::vec2 p1, glm::vec2 p2, glm::vec2 p3) {
-    return (p1.x - p3.x) * (p2.y - p3.y) - (p2.x - p3.x) * (p1.y - p3.y);
+glm::vec3 speedColor(const glm::vec3& v) {
+    return (1 - (glm::length(v) / 100.0f)) * glm::vec3(.0, .0, 1.0) +
+        (glm::length(v) * glm::vec3(1.0, .0, .0) / 100.0f);
+}
+
+void emitParticle(particleGenerator& gen, float velVariance) {
+    int i = gen.pd.emit();
+    if (i < 0)
+        return;
+    glm::vec3 vgen = gen.v + 3.0f * gen.d;
+    glm::vec3 var = glm::vec3(velVariance, velVariance, velVariance);
+    gen.pd.v[i] = glm::gaussRand(vgen, var - glm::dot(var, vgen));
+    gen.pd.m[i] = gen.m;
+    gen.pd.LS[i] = gen.LS;
+    gen.pd.COF[i] = gen.COF;
+    gen.pd.COR[i] = gen.COR;
+    gen.pd.p[i] = glm::gaussRand(gen.p, glm::vec3(.1, 0.1, 0.1));
+    gen.pd.c[i] = speedColor(gen.pd.v[i]);
+}
+
+// the surface points of the whole batch are sampled on the thread pool first, then handed to
+// the emitted particles, the variance draws stay serial as they share std::rand
+void emitFromSurface(particleGenerator& gen, float velVariance) {
+    int count = std::min(gen.count, gen.pd.n - gen.pd.n_alive);
+    if (count <= 0)
+        return;
+    glm::vec3* points = Arena::frame().alloc<glm::vec3>(count);
+    glm::vec3* normals = Arena::frame().alloc<glm::vec3>(count);
+    gen.surface->sample(gen.seed, gen.emitted, count, points, normals);
+    gen.emitted += count;
+    glm::vec3 var(velVariance);
+    for (int j = 0; j < count; j++) {
+        int i = gen.pd.emit();
+        gen.pd.p[i] = gen.p + points[j];
+        gen.pd.v[i] = gen.v + gen.speed * normals[j] + glm::gaussRand(glm::vec3(0.0f), var);
+        gen.pd.m[i] = gen.m;
+        gen.pd.LS[i] = gen.LS;
+        gen.pd.COF[i] = gen.COF;
+        gen.pd.COR[i] = gen.COR;
+        gen.pd.c[i] = speedColor(gen.pd.v[i]);
+    }
+}
+
+// forces for the awake part of the generator are accumulated by the registry first, then
+// every awake particle is stepped, the positions before the step are kept for the collision pass
+void integrateParticles(particleGenerator& gen, const ForceFieldRegistry& fields, float h, int integrator) {
+    ParticleData& pd = gen.pd;
+    fields.apply(pd, 0, pd.n_awake, h);
+
+    gen.pPrev = Arena::frame().alloc<glm::vec3>(pd.n_awake);
+    for (int i = 0; i < pd.n_awake; i++) {
+        gen.pPrev[i] = pd.p[i];
+        if (integrator == INTEGRATOR_SYMPLECTIC) {
+            pd.v[i] += pd.a[i] * h;
+            pd.p[i] += pd.v[i] * h;
+        }
+        else {
+            pd.p[i] += pd.v[i] * h;
+            pd.v[i] += pd.a[i] * h;
+        }
+    }
+}
+
+// mirrors the part of the step that went dist past the surface, scaled by restitution, and
+// reflects the normal velocity while friction takes from the tangential one
+// returns whether the impact was hard enough to wake sleeping neighbours
+static bool bounce(ParticleData& pd, int i, const glm::vec3& norm, float dist, const SleepParams& sleep) {
+    pd.p[i] -= (1.0f + pd.COR[i]) * dist * norm;
+    glm::vec3 vn = glm::dot(pd.v[i], norm) * norm;
+    glm::vec3 vt = pd.v[i] - vn;
+    float vnl = glm::length(vn);
+    float vtl = glm::length(vt);
+    if (vtl > 0.0f)
+        vt -= vt / vtl * fmin(pd.COF[i] * vnl, vtl);
+    pd.v[i] = -pd.COR[i] * vn + vt;
+    return vnl > sleep.restVelocity;
 }
 
-int main() {
+// tests the path of every awake particle against the colliders and puts resting ones to sleep
+// impacts collects the contact points that are hard enough to wake sleeping neighbours, it has
+// room for one per awake particle, a particle bouncing off both kinds of collider is recorded once
+void collideParticles(particleGenerator& gen, float h, const TriangleCollider& coll, const SdfCollider& sdf,
+    const SleepParams& sleep, glm::vec3* impacts, int& impactCount) {
+    ParticleData& pd = gen.pd;
+    for (int i = 0; i < pd.n_awake; i++) {
+        float f, planeD;
+        glm::vec3 norm;
+        bool contact = coll.intersect(gen.pPrev[i], pd.p[i], f, norm, planeD);
+        bool hard = false;
+        if (contact)
+            hard = bounce(pd, i, norm, glm::dot(pd.p[i], norm) - planeD, sleep);
+
+        // the distance grids only see where the particle ended up, one already on its way out is
+        // put back on the surface without touching its velocity
+        float depth;
+        if (!sdf.empty() && sdf.contact(pd.p[i], depth, norm)) {
+            contact = true;
+            if (glm::dot(pd.v[i], norm) < 0.0f)
+                hard |= bounce(pd, i, norm, depth, sleep);
+            else
+                pd.p[i] -= depth * norm;
+        }
+        if (hard)
+            impacts[impactCount++] = pd.p[i];
 
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // opengl version 3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); //opengil version 3.3
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); //using core profile of opengl
-    //glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        // count slow steps with contact, a slow step in the air between micro bounces keeps the count
+        if (glm::length(pd.v[i]) > sleep.restVelocity)
+            pd.restSteps[i] = 0;
+        else if (contact)
+            pd.restSteps[i]++;
 
-    GLFWwindow* window = glfwCreateWindow(1920, 1080, "LearnOpenGL", NULL, NULL);
-    //glfwSetWindowMonitor(window, glfwGetPrimaryMonitor(), 0, 0, 1920, 1080, GLFW_DONT_CARE);
-    if (window == NULL)
+        pd.c[i] = speedColor(pd.v[i]);
+        pd.age[i] += h;
+    }
+
+    if (sleep.enabled) {
+        // from the back, sleep() swaps with the last awake particle
+        for (int i = pd.n_awake - 1; i >= 0; i--) {
+            if (pd.restSteps[i] >= sleep.restSteps) {
+                pd.sleep(i);
+                pd.c[pd.n_awake] = speedColor(glm::vec3(0.0f));
+            }
+        }
+    }
+}
+
+// interleaves position and color of the live particles for the vertex buffer
+void packParticles(particleGenerator& gen) {
+    for (int i = 0; i < gen.pd.n_alive; i++) {
+        gen.pgpus[i].p = gen.pd.p[i];
+        gen.pgpus[i].c = gen.pd.c[i];
+    }
+    gen.visible = gen.pd.n_alive;
+}
+
+void setupGenerator(particleGenerator& gen, const GeneratorDesc& desc) {
+    gen.storage.reserve(ParticleData::storageBytes(desc.capacity) + arenaBytes<particle_gpu>(desc.capacity));
+    gen.pd.genParticle(desc.capacity, gen.storage);
+    gen.pgpus = gen.storage.alloc<particle_gpu>(desc.capacity);
+    gen.p = desc.p;
+    gen.v = desc.v;
+    gen.d = desc.d;
+    gen.P = desc.period;
+    gen.t = 0.0f;
+    gen.m = desc.mass;
+    gen.LS = desc.lifespan;
+    gen.COF = desc.cof;
+    gen.COR = desc.cor;
+    gen.count = desc.count;
+    gen.speed = desc.speed;
+    gen.surface.reset();
+    if (desc.mesh[0]) {
+        TriangleMesh mesh;
+        if (loadMesh(desc.mesh, mesh)) {
+            gen.surface.reset(new SurfaceSampler());
+            gen.surface->build(mesh);
+            if (gen.surface->empty()) {
+                std::cout << "ERROR: Emitter Mesh Has No Area: " << desc.mesh << std::endl;
+                gen.surface.reset();
+            }
+        }
+    }
+}
+
+void resetGenerators(std::vector<particleGenerator>& gens, const SceneDesc& scene) {
+    for (size_t i = 0; i < gens.size(); i++) {
+        gens[i].pd.reset();
+        gens[i].p = scene.generators[i].p;
+        gens[i].t = 0.0f;
+        gens[i].seed = (uint64_t)scene.seed * gens.size() + i;
+        gens[i].emitted = 0;
+    }
+    std::srand(scene.seed);
+}
+
+// one fixed step of every generator, shared by the window and the headless runs
+// the scratch of the step comes from the frame arena, so it has to run inside a frame
+void simulateStep(std::vector<particleGenerator>& gens, ForceFieldRegistry& fields, const TriangleCollider& coll,
+    const SdfCollider& sdf, const SceneDesc& scene, float h) {
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+        PROFILE_SCOPE("Emit");
+        for (auto& gen : gens) {
+            gen.t += h;
+            if (gen.t > gen.P) {
+                gen.t = 0.0f;
+                if (gen.surface)
+                    emitFromSurface(gen, scene.velVariance);
+                else
+                    for (int k = 0; k < gen.count; k++)
+                        emitParticle(gen, scene.velVariance);
+            }
+            //update generator locations
+            gen.p += gen.v * h;
+        }
     }
-    glfwMakeContextCurrent(window);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    // edited and animated fields wake the particles sleeping inside their region
+    fields.advance(h);
+    for (auto& gen : gens)
+        fields.wakeDirty(gen.pd);
+    fields.clearDirty();
+
+    //integration
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+        PROFILE_SCOPE("Integrate");
+        for (auto& gen : gens)
+            integrateParticles(gen, fields, h, scene.integrator);
+    }
+    int awake = 0;
+    for (auto& gen : gens)
+        awake += gen.pd.n_awake;
+    glm::vec3* impacts = Arena::frame().alloc<glm::vec3>(awake);
+    int impactCount = 0;
+    {
+        PROFILE_SCOPE("Collide");
+        for (auto& gen : gens)
+            collideParticles(gen, h, coll, sdf, scene.sleep, impacts, impactCount);
     }
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    for (auto& gen : gens)
+        gen.pd.wakeNear(impacts, impactCount, scene.sleep.wakeRadius);
+}
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+// the scene from the command line, a .json scene or a collider mesh for the default scene
+bool loadSceneArg(const char* arg, SceneDesc& scene) {
+    scene = defaultScene();
+    if (!arg)
+        return true;
+    std::string path = arg;
+    std::string ext = std::filesystem::path(path).extension().string();
+    if (ext == ".json")
+        return loadScene(path, scene);
+    ColliderDesc coll = {};
+    coll.type = COLLIDER_MESH;
+    std::error_code ec;
+    std::string resolved = std::filesystem::absolute(path, ec).string();
+    if (resolved.size() >= SCENE_MAX_PATH)
+        return false;
+    memcpy(coll.mesh, resolved.c_str(), resolved.size() + 1);
+    scene.colliders = { coll };
+    return true;
+}
 
-    glViewport(0, 0, 1920, 1080);
+// runs the scene without a window, the position checksum is the same for every run of a scene
+int runHeadless(const SceneDesc& scene, int steps, const char* tracePath) {
+    TriangleMesh collMesh;
+    TriangleCollider collider;
+    SdfCollider sdfCollider;
+    buildColliders(scene, collMesh, collider, sdfCollider);
+    ForceFieldRegistry fields;
+    buildFields(scene, fields);
+
+    std::vector<particleGenerator> gens(scene.generators.size());
+    for (size_t i = 0; i < gens.size(); i++)
+        setupGenerator(gens[i], scene.generators[i]);
+    resetGenerators(gens, scene);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Profiler& profiler = Profiler::get();
+    if (tracePath) {
+        // every step is traced, the frame end starts the capture right away
+        Tracer::get().capture(steps, tracePath);
+        Tracer::get().frameEnd();
+    }
+    for (int s = 0; s < steps; s++) {
+        profiler.beginFrame();
+        Arena::frame().reset();
+        simulateStep(gens, fields, collider, sdfCollider, scene, scene.timestep);
+        profiler.endFrame();
+    }
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    double checksum = 0.0;
+    int alive = 0;
+    int awake = 0;
+    for (auto& gen : gens) {
+        for (int i = 0; i < gen.pd.n_alive; i++)
+            checksum += (double)gen.pd.p[i].x + gen.pd.p[i].y + gen.pd.p[i].z;
+        alive += gen.pd.n_alive;
+        awake += gen.pd.n_awake;
+    }
+    printf("steps: %d time: %.3f ms (%.4f ms/step)\n", steps, ms, steps > 0 ? ms / steps : 0.0f);
+    printf("particles: %d awake: %d checksum: %.6f\n", alive, awake, checksum);
+    profiler.printSummary();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+
+    // main [scene.json | collider.obj/.ply] [--headless] [--steps N] [--trace out.json]
+    //      [--capture dir] [--capture-size WxH] [--capture-raw]
+    //      [--backend window|egl|osmesa] [--size WxH] [--bench N] [--camera fixed|orbit|dolly]
+    //      [--depth-sort] [--trails]
+    const char* sceneArg = nullptr;
+    bool headless = false;
+    int headlessSteps = 1000;
+    const char* tracePath = nullptr;
+    bool capturing = false;
+    std::string captureDir = "capture";
+    int captureSize[2] = { 1920, 1080 };
+    int captureFormat = CAPTURE_PNG;
+    int backend = CONTEXT_WINDOW;
+    int size[2] = { 1920, 1080 };
+    int benchFrames = 0; // 0 runs until the window is closed
+    CameraPath cameraPath;
+    bool depthSort = false;
+    bool trails = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+            headlessSteps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturing = true;
+            captureDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--capture-size") == 0 && i + 1 < argc) {
+            // the same range the gui allows
+            if (sscanf(argv[++i], "%dx%d", &captureSize[0], &captureSize[1]) != 2) {
+                std::cout << "ERROR: Invalid Capture Size: " << argv[i] << std::endl;
+                return -1;
+            }
+            for (int& c : captureSize)
+                c = std::min(std::max(c, 16), CAPTURE_MAX_SIZE);
+        }
+        else if (strcmp(argv[i], "--capture-raw") == 0)
+            captureFormat = CAPTURE_RAW;
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            backend = GLContext::parseBackend(argv[++i]);
+            if (backend < 0) {
+                std::cout << "ERROR: Unknown Backend: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &size[0], &size[1]) != 2 || size[0] <= 0 || size[1] <= 0) {
+                std::cout << "ERROR: Invalid Size: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+            benchFrames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--camera") == 0 && i + 1 < argc) {
+            cameraPath.type = CameraPath::parse(argv[++i]);
+            if (cameraPath.type < 0) {
+                std::cout << "ERROR: Unknown Camera Path: " << argv[i] << std::endl;
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--depth-sort") == 0)
+            depthSort = true;
+        else if (strcmp(argv[i], "--trails") == 0)
+            trails = true;
+        else
+            sceneArg = argv[i];
+    }
+    SceneDesc scene;
+    if (!loadSceneArg(sceneArg, scene)) {
+        if (headless)
+            return -1;
+        std::cout << "ERROR: falling back to the default scene" << std::endl;
+        scene = defaultScene();
+    }
+    if (headless)
+        return runHeadless(scene, headlessSteps, tracePath);
+    // without a display there is nothing to close, the offscreen backends always run a benchmark
+    if (backend != CONTEXT_WINDOW && benchFrames <= 0)
+        benchFrames = 600;
+
+    std::unique_ptr<GLContext> context = GLContext::create(backend, size[0], size[1], "LearnOpenGL");
+    if (!context)
+        return -1;
+    GLFWwindow* window = context->window();
+    if (window) {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
+
+    glViewport(0, 0, size[0], size[1]);
 
     //TODO generate particles, at this point these are just state vector
     
@@ -188,55 +558,45 @@ int main() {
         coneVertices[3 * i + 2] = glm::vec3(std::cos((i + 1) * pi * 2.0 / n )* coneR, std::sin((i + 1) * pi * 2.0 / n)* coneR, 0.0);
     }
     printf("%d",GL_MAX_ELEMENTS_VERTICES);
-    unsigned int coneVao;
-    glGenVertexArrays(1, &coneVao);
-
-    glBindVertexArray(coneVao);
-    VertexBuffer cvb(coneVertices, sizeof(coneVertices));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-
-
-    particleGenerator pgen1;
-    glGenVertexArrays(1, &pgen1.vao);
-    pgen1.pgpus = new particle_gpu[MAX_PARTICLE_PER_GENERATOR];
-    pgen1.pcpus = new particle_cpu[MAX_PARTICLE_PER_GENERATOR];
-    pgen1.p = glm::vec3(10.0,10.0,10.0);
-    pgen1.v = glm::vec3(0.0, -1.0, 0.0);
-    pgen1.d = glm::vec3(1.0, 1.0, 1.0);
-    pgen1.P = .2;
-    pgen1.t = 0.0f;
-
-    glBindVertexArray(pgen1.vao);
-    VertexBuffer pgen1vb(&pgen1.pgpus[0],sizeof(particle_gpu));
-    particleShaderSetup();
-
-    particleGenerator pgen2;
-    glGenVertexArrays(1, &pgen2.vao);
-    pgen2.pgpus = new particle_gpu[MAX_PARTICLE_PER_GENERATOR];
-    pgen2.pcpus = new particle_cpu[MAX_PARTICLE_PER_GENERATOR];
-    pgen2.p = glm::vec3(-10.0, -10.0, -10.0);
-    pgen2.v = glm::vec3(0.0, 1.0, 0.0);
-    pgen2.d = glm::vec3(-1.0, -1.0, -1.0);
-    pgen2.P = 1.0;
-    pgen2.t = 0.0;
-
-    glBindVertexArray(pgen2.vao);
-    VertexBuffer pgen2vb(&pgen2.pgpus[0], sizeof(particle_gpu));
-    particleShaderSetup();
+    MeshBuffer cone;
+    cone.AddAttribute(0, 3, coneVertices, sizeof(coneVertices));
+
+
+    std::vector<particleGenerator> gens(scene.generators.size());
+    for (size_t i = 0; i < gens.size(); i++) {
+        setupGenerator(gens[i], scene.generators[i]);
+        glGenVertexArrays(1, &gens[i].vao);
+        glBindVertexArray(gens[i].vao);
+        // storage for the whole capacity up front, per frame uploads only write the visible part
+        gens[i].vb.reset(new VertexBuffer(NULL, sizeof(particle_gpu) * scene.generators[i].capacity));
+        particleShaderSetup();
+        gens[i].ib.reset(new IndexBuffer(NULL, scene.generators[i].capacity));
+    }
+    resetGenerators(gens, scene);
 
     // add colliders
-    // for not a simple triangle is enough i think :D
-    glm::vec3 tri[3] = {glm::vec3(0.0, 0.0, 0.0),
-                        glm::vec3(0.0, 10.0, 10.0),
-                        glm::vec3(0.0, -10.0, 10.0) };
-    glm::vec3 norm = glm::normalize(glm::cross(tri[0] - tri[1], tri[0] - tri[2]));
-    unsigned int collVao;
-    glGenVertexArrays(1, &collVao);
-    glBindVertexArray(collVao);
-    VertexBuffer colvbo(tri,sizeof(tri));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    TriangleMesh collMesh;
+    TriangleCollider collider;
+    SdfCollider sdfCollider;
+    buildColliders(scene, collMesh, collider, sdfCollider);
+
+    // the camera path circles whatever the scene has in it, colliders and generators
+    glm::vec3 sceneMin(FLT_MAX), sceneMax(-FLT_MAX);
+    for (const glm::vec3& p : collMesh.positions) {
+        sceneMin = glm::min(sceneMin, p);
+        sceneMax = glm::max(sceneMax, p);
+    }
+    for (const auto& gen : gens) {
+        sceneMin = glm::min(sceneMin, gen.p - glm::vec3(5.0f));
+        sceneMax = glm::max(sceneMax, gen.p + glm::vec3(5.0f));
+    }
+    if (sceneMin.x <= sceneMax.x)
+        cameraPath.fit(sceneMin, sceneMax);
+
+    MeshBuffer collMeshBuffer;
+    collMeshBuffer.AddAttribute(0, 3, collMesh.positions.data(), (unsigned int)(collMesh.positions.size() * sizeof(glm::vec3)));
+    collMeshBuffer.AddAttribute(1, 3, collMesh.normals.data(), (unsigned int)(collMesh.normals.size() * sizeof(glm::vec3)));
+    collMeshBuffer.SetIndices(collMesh.indices.data(), (unsigned int)collMesh.indices.size());
 
 
     //trying to render an icosphere
@@ -248,6 +608,21 @@ int main() {
     Shader particleShader("../../../HWs/HW2/Code/shaders/vertParticle.glsl", "../../../HWs/HW2/Code/shaders/fragParticle.glsl");
     Shader coneShader("../../../HWs/HW2/Code/shaders/vertCone.glsl", "../../../HWs/HW2/Code/shaders/fragCone.glsl");
     Shader collShader("../../../HWs/HW2/Code/shaders/vertColl.glsl", "../../../HWs/HW2/Code/shaders/fragColl.glsl");
+    Shader trailShader("../../../HWs/HW2/Code/shaders/vertTrail.glsl", "../../../HWs/HW2/Code/shaders/fragTrail.glsl");
+
+    // the camera is uploaded once per frame into a buffer all programs read
+    CameraBuffer camera;
+    for (Shader* s : { &sperspective, &fperspective, &particleShader, &coneShader, &collShader, &trailShader })
+        s->bindBlock(CAMERA_BLOCK, CAMERA_BINDING);
+
+    // uniform locations are resolved once, the draw loop only sets values
+    Uniform<glm::mat4> coneModel = coneShader.uniform<glm::mat4>("model");
+    Uniform<glm::mat4> collModel = collShader.uniform<glm::mat4>("model");
+    Uniform<int> trailHistory = trailShader.uniform<int>("history");
+    Uniform<int> trailHead = trailShader.uniform<int>("head");
+    Uniform<int> trailLengthU = trailShader.uniform<int>("trailLength");
+    Uniform<int> trailSlots = trailShader.uniform<int>("slots");
+    Uniform<glm::vec3> trailColorU = trailShader.uniform<glm::vec3>("trailColor");
 
     float pointSize = 4.0f;
     float lineSize = 6.0f;
@@ -260,19 +635,23 @@ int main() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     int width, height;
-    float h = 0.01f;
+    float& h = scene.timestep;
     float f;
     float t = 0.0f;
     float t_max = 120.0f;
 
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    ImGui::StyleColorsDark();
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 330");
-
-    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    // the gui is left out of benchmarks, it would be most of what a small scene draws
+    bool gui = window && benchFrames == 0;
+    if (gui) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO(); (void)io;
+        ImGui::StyleColorsDark();
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init("#version 330");
+
+        io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    }
 
     float timestep = h;
     bool stepSim = false;
@@ -281,133 +660,319 @@ int main() {
     std::chrono::steady_clock::time_point t_sim = std::chrono::steady_clock::now();
 
     
-    // Lorenz Params
-    float sigma = 10.0f;
-    float rho = 28.0f;
-    float beta = 8.0f / 3.0f;
-    float g = 0.0f;
-    float lorenzFac = 0.0f;
-    float velVariance = 0.5f;
+
+    bool frustumCulling = true;
+    Frustum frustum;
+    ParticleCuller culler;
+
+    // back to front order for the alpha blending, off by default as the blend is only wrong where particles overlap
+    DepthSorter depthSorter;
+
+    // the last trailLength positions of every particle drawn as line strips, one slice recorded per step
+    int trailLength = 32;
+    glm::vec3 trailColor = glm::vec3(0.4f, 0.7f, 1.0f);
+    if (trails) {
+        for (size_t i = 0; i < gens.size(); i++)
+            gens[i].trail.reset(new TrailBuffer(scene.generators[i].capacity, trailLength));
+    }
+
+    // the scene is drawn offscreen at the capture size and read back a few frames later
+    std::unique_ptr<FrameCapture> capture;
+
+    SleepParams& sleep = scene.sleep;
+
+    // z-order resorting of the particle columns, misses of the passes after it are measured
+    MortonSorter mortonSorter;
+    bool mortonSort = false;
+    int sortEvery = 60;
+    int simSteps = 0;
+    float sortMs = 0.0f;
+    CacheMissCounter missCounter;
+    float updateMisses = 0.0f;
+    float cullMisses = 0.0f;
+
+    ForceFieldRegistry fields;
+    buildFields(scene, fields);
+    // the gravity slider drives the first uniform field of the scene
+    UniformField* gravity = nullptr;
+    for (auto& field : fields.fields)
+        if (!gravity)
+            gravity = dynamic_cast<UniformField*>(field.get());
+    float g = gravity ? -gravity->g.z : 0.0f;
     particleShader.use();
 
-    while (!glfwWindowShouldClose(window))
+    Profiler& profiler = Profiler::get();
+    profiler.initGpu();
+
+    // a benchmark steps the simulation once per frame with the camera on its path, so every run
+    // draws the same frames, each frame waits for the gpu so the frame time includes the draw
+    int frameIndex = 0;
+    if (benchFrames > 0)
+        timeToSimulate = true;
+    std::chrono::steady_clock::time_point benchStart = std::chrono::steady_clock::now();
+
+    while (!context->closing() && (benchFrames <= 0 || frameIndex < benchFrames))
     {
-        // time handling for input, should not interfere with this
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTimeFrame = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        processInput(window);
+        profiler.beginFrame();
+        Arena::frame().reset();
+        if (window) {
+            // time handling for input, should not interfere with this
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTimeFrame = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+        }
+        if (benchFrames > 0)
+            cameraPath.frame(frameIndex, camPos, camFront);
+
+        if (capturing && !capture) {
+            capture.reset(new FrameCapture(captureSize[0], captureSize[1], captureDir, captureFormat));
+            // the reason was printed, recording stays off until it is started again
+            if (!capture->valid()) {
+                capture.reset();
+                capturing = false;
+            }
+        }
+        else if (!capturing && capture)
+            capture.reset();
+        if (capture)
+            capture->begin();
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         //start of imgui init stuff
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        
+        if (gui) {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+        }
         //end of imgui init stuff
-        particleShader.use();
         glm::mat4 view = glm::lookAt(camPos, camPos + camFront, camUp);
-        particleShader.setMat4("view", view);
 
-        glfwGetWindowSize(window, &width, &height);
+        context->getSize(width, height);
+        if (capture) {
+            width = capture->getWidth();
+            height = capture->getHeight();
+        }
 
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.01f, 100000.0f);
-        particleShader.setMat4("projection", projection);
-        
-        glBindVertexArray(pgen1.vao);
-        glDrawArrays(GL_POINTS, 0, pgen1.pnum);
-
-        glBindVertexArray(pgen2.vao);
-        glDrawArrays(GL_POINTS, 0, pgen2.pnum);
-
-        coneShader.use();
-        coneShader.setMat4("view", view);
-        coneShader.setMat4("projection", projection);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, pgen1.p);
-        model = glm::rotate(model, acos(glm::dot(glm::vec3(0.0, 0.0, -1.0), glm::normalize(pgen1.d))), glm::cross(glm::vec3(0.0, 0.0, -1.0), glm::normalize(pgen1.d)));
-        coneShader.setMat4("model", model);
-        glBindVertexArray(coneVao);
-        glDrawArrays(GL_TRIANGLES, 0, 96);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, pgen2.p);
-        model = glm::rotate(model, acos(glm::dot(glm::vec3(0.0, 0.0, -1.0), glm::normalize(pgen2.d))), glm::cross(glm::vec3(0.0, 0.0, -1.0), glm::normalize(pgen2.d)));
-        coneShader.setMat4("model", model);
-        glBindVertexArray(coneVao);
-        glDrawArrays(GL_TRIANGLES, 0, 96);
-        
-        collShader.use();
-        collShader.setMat4("view", view);
-        collShader.setMat4("projection", projection);
-        model = glm::mat4(1.0f);
-        collShader.setMat4("model", model);
-        glBindVertexArray(collVao);
-        glDrawArrays(GL_TRIANGLES, 0 , 3);
-
-        glBindVertexArray(0);
-        // all drawings done lets do some imgui stuff
+        camera.update(view, projection, camPos, (float)width, (float)height, 0.01f, 100000.0f);
 
-        ImGui::Begin("Particle Generator Settings");
-        ImGui::Text("PG1 # particles: %d", pgen1.pnum);
-        ImGui::DragFloat("PG1 Period", &pgen1.P, 0.001);
-        ImGui::DragFloat3("PG1 Direction", glm::value_ptr(pgen1.d), 0.05);
-        ImGui::DragFloat3("PG1 Velocity", glm::value_ptr(pgen1.v), 0.05);
-        ImGui::Text("PG2 # particles: %d", pgen2.pnum);
-        ImGui::DragFloat("PG2 Period", &pgen2.P, 0.001);
-        ImGui::DragFloat3("PG2 Direction", glm::value_ptr(pgen2.d), 0.05);
-        ImGui::DragFloat3("PG2 Velocity", glm::value_ptr(pgen2.v), 0.05);
-        ImGui::Text("Total particles: %d", pgen1.pnum + pgen2.pnum);
-        ImGui::End();
-
-        ImGui::Begin("Particle Settings");
-        ImGui::DragFloat("Particle Velocity Variance", &velVariance, 0.1);
-        ImGui::End();
-
-        ImGui::Begin("Render Setting");
-        bool sliderPS = ImGui::SliderFloat("Point Size", &pointSize, .01f, 10.0f);
-        bool sliderLS = ImGui::SliderFloat("Line Size", &lineSize, .01f, 10.0f);
-        ImGui::End();
-
-        ImGui::Begin("Simulation Setting");
-        if (ImGui::Button("Start/Pause Simulation")) {
-            timeToSimulate = !timeToSimulate;
-            stepSim = false;
+        // only what is inside the view is packed and uploaded
+        {
+            PROFILE_SCOPE("Pack");
+            if (frustumCulling) {
+                frustum.extract(projection * view);
+                missCounter.start();
+                for (auto& gen : gens)
+                    gen.visible = culler.cull(frustum, gen.pd, gen.pgpus);
+                cullMisses = 0.9f * cullMisses + 0.1f * (float)missCounter.read();
+            }
+            else {
+                for (auto& gen : gens)
+                    packParticles(gen);
+            }
         }
-        if (ImGui::Button("Step Simulation")) {
-            stepSim = true;
+        // the upload stays in storage order and an index buffer gives the draw order, so the
+        // particles are not moved, only 4 bytes per particle more go to the gpu
+        // each generator is its own draw, so particles are only ordered within their generator
+        uint32_t** drawOrder = Arena::frame().alloc<uint32_t*>(gens.size());
+        if (depthSort) {
+            PROFILE_SCOPE("Depth Sort");
+            for (size_t i = 0; i < gens.size(); i++) {
+                drawOrder[i] = Arena::frame().alloc<uint32_t>(gens[i].visible);
+                depthSorter.order(view, gens[i].pgpus, gens[i].visible, drawOrder[i]);
+            }
         }
-        if (ImGui::Button("Reset")) {
-            t = 0;
-            t_sim = std::chrono::steady_clock::now();
-            delete pgen1.pgpus;
-            delete pgen2.pgpus;
-            pgen1.pnum = 0;
-            pgen2.pnum = 0;
-            pgen1.pgpus = new particle_gpu[MAX_PARTICLE_PER_GENERATOR];
-            pgen1.pcpus = new particle_cpu[MAX_PARTICLE_PER_GENERATOR];
-
-            pgen2.pgpus = new particle_gpu[MAX_PARTICLE_PER_GENERATOR];
-            pgen2.pcpus = new particle_cpu[MAX_PARTICLE_PER_GENERATOR];
+        {
+            PROFILE_GPU_SCOPE("Upload");
+            for (size_t i = 0; i < gens.size(); i++) {
+                gens[i].vb->UpdateData(&gens[i].pgpus[0], sizeof(particle_gpu) * gens[i].visible);
+                if (depthSort) {
+                    glBindVertexArray(gens[i].vao);
+                    gens[i].ib->UpdateData(drawOrder[i], gens[i].visible);
+                }
+            }
+            glBindVertexArray(0);
         }
-        ImGui::Text("Integration");
-        ImGui::SliderFloat("Timestep", &h, .005f, 0.5f);
-        ImGui::Text("Lorenz Parameters");
-        
-        // Lorenz GUI
-        ImGui::DragFloat("Rho", &rho, 0.005f);
-        ImGui::DragFloat("Beta", &beta, 0.005f);
-        ImGui::DragFloat("Sigma", &sigma, 0.005f);
-        ImGui::DragFloat("Lorenz Factor", &lorenzFac, 0.005f);
-        ImGui::Text("Initial Conditions");
-        
-        ImGui::Text("World Settings");
-        ImGui::DragFloat("Gravity", &g, 0.005f);
 
-        ImGui::End();
+        {
+            PROFILE_GPU_SCOPE("Draw");
+            particleShader.use();
+            for (auto& gen : gens) {
+                glBindVertexArray(gen.vao);
+                if (depthSort)
+                    glDrawElements(GL_POINTS, gen.visible, GL_UNSIGNED_INT, 0);
+                else
+                    glDrawArrays(GL_POINTS, 0, gen.visible);
+            }
+
+            if (trails) {
+                trailShader.use();
+                trailHistory.set(0);
+                trailColorU.set(trailColor);
+                for (auto& gen : gens) {
+                    trailHead.set(gen.trail->getHead());
+                    trailLengthU.set(gen.trail->getLength());
+                    trailSlots.set(gen.trail->getSlots());
+                    gen.trail->draw(0);
+                }
+            }
+
+            coneShader.use();
+
+            glm::mat4 model;
+            for (auto& gen : gens) {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, gen.p);
+                model = glm::rotate(model, acos(glm::dot(glm::vec3(0.0, 0.0, -1.0), glm::normalize(gen.d))), glm::cross(glm::vec3(0.0, 0.0, -1.0), glm::normalize(gen.d)));
+                coneModel.set(model);
+                cone.Bind();
+                glDrawArrays(GL_TRIANGLES, 0, cone.getCount());
+            }
+
+            collShader.use();
+            collModel.set(glm::mat4(1.0f));
+            collMeshBuffer.Bind();
+            glDrawElements(GL_TRIANGLES, collMeshBuffer.getCount(), GL_UNSIGNED_INT, 0);
+
+            glBindVertexArray(0);
+        }
+        if (capture) {
+            PROFILE_GPU_SCOPE("Capture");
+            capture->end();
+        }
+        // all drawings done lets do some imgui stuff
+
+        bool sliderPS = false;
+        bool sliderLS = false;
+        if (gui) {
+            ImGui::Begin("Particle Generator Settings");
+            int totalAlive = 0;
+            int totalVisible = 0;
+            for (int i = 0; i < (int)gens.size(); i++) {
+                ImGui::PushID(i);
+                ImGui::Text("PG%d # particles: %d", i + 1, gens[i].pd.n_alive);
+                ImGui::DragFloat("Period", &gens[i].P, 0.001);
+                ImGui::DragFloat3("Direction", glm::value_ptr(gens[i].d), 0.05);
+                ImGui::DragFloat3("Velocity", glm::value_ptr(gens[i].v), 0.05);
+                ImGui::DragInt("Count", &gens[i].count, 1.0f, 1, gens[i].pd.n);
+                if (gens[i].surface)
+                    ImGui::DragFloat("Speed", &gens[i].speed, 0.05f);
+                ImGui::PopID();
+                totalAlive += gens[i].pd.n_alive;
+                totalVisible += gens[i].visible;
+            }
+            ImGui::Text("Total particles: %d", totalAlive);
+            ImGui::Text("Visible particles: %d", totalVisible);
+            ImGui::End();
+
+            ImGui::Begin("Particle Settings");
+            ImGui::DragFloat("Particle Velocity Variance", &scene.velVariance, 0.1);
+            ImGui::End();
+
+            ImGui::Begin("Render Setting");
+            sliderPS = ImGui::SliderFloat("Point Size", &pointSize, .01f, 10.0f);
+            sliderLS = ImGui::SliderFloat("Line Size", &lineSize, .01f, 10.0f);
+            ImGui::Checkbox("Frustum Culling", &frustumCulling);
+            ImGui::Checkbox("Depth Sort", &depthSort);
+            bool trailsChanged = ImGui::Checkbox("Trails", &trails);
+            // the buffers are rebuilt once the slider is let go, not on every frame of the drag
+            ImGui::SliderInt("Trail Length", &trailLength, 2, TRAIL_MAX_LENGTH);
+            trailsChanged |= ImGui::IsItemDeactivatedAfterEdit();
+            ImGui::ColorEdit3("Trail Color", glm::value_ptr(trailColor));
+            if (trailsChanged) {
+                for (size_t i = 0; i < gens.size(); i++)
+                    gens[i].trail.reset(trails ? new TrailBuffer(scene.generators[i].capacity, trailLength) : nullptr);
+            }
+            ImGui::Text("Capture");
+            if (ImGui::Checkbox("Record Frames", &capturing) && !capturing && capture)
+                std::cout << "captured " << capture->getCaptured() << " frames, " << capture->getDropped() << " dropped" << std::endl;
+            if (!capture) {
+                ImGui::DragInt2("Capture Size", captureSize, 1.0f, 16, CAPTURE_MAX_SIZE);
+                ImGui::RadioButton("PNG", &captureFormat, CAPTURE_PNG);
+                ImGui::SameLine();
+                ImGui::RadioButton("Raw RGB", &captureFormat, CAPTURE_RAW);
+            }
+            else
+                ImGui::Text("Frames: %lld written: %lld dropped: %lld", capture->getCaptured(), capture->getWritten(), capture->getDropped());
+            ImGui::End();
+
+            ImGui::Begin("Simulation Setting");
+            if (ImGui::Button("Start/Pause Simulation")) {
+                timeToSimulate = !timeToSimulate;
+                stepSim = false;
+            }
+            if (ImGui::Button("Step Simulation")) {
+                stepSim = true;
+            }
+            if (ImGui::Button("Reset")) {
+                t = 0;
+                t_sim = std::chrono::steady_clock::now();
+                resetGenerators(gens, scene);
+                for (auto& gen : gens)
+                    if (gen.trail)
+                        gen.trail->reset();
+            }
+            ImGui::Text("Integration");
+            ImGui::SliderFloat("Timestep", &h, .005f, 0.5f);
+            ImGui::RadioButton("Euler", &scene.integrator, INTEGRATOR_EULER);
+            ImGui::SameLine();
+            ImGui::RadioButton("Symplectic Euler", &scene.integrator, INTEGRATOR_SYMPLECTIC);
+            ImGui::Text("Initial Conditions");
+        
+            ImGui::Text("World Settings");
+            if (gravity && ImGui::DragFloat("Gravity", &g, 0.005f)) {
+                gravity->g = glm::vec3(0.0f, 0.0f, -g);
+                fields.markDirty(gravity);
+            }
+            ImGui::Text("Sleeping");
+            if (ImGui::Checkbox("Sleep Resting Particles", &sleep.enabled) && !sleep.enabled) {
+                for (auto& gen : gens)
+                    gen.pd.wakeAll();
+            }
+            ImGui::DragFloat("Rest Velocity", &sleep.restVelocity, 0.001f);
+            ImGui::SliderInt("Rest Steps", &sleep.restSteps, 1, 240);
+            ImGui::DragFloat("Wake Radius", &sleep.wakeRadius, 0.01f);
+            ImGui::Text("Memory Order");
+            ImGui::Checkbox("Morton Sort", &mortonSort);
+            ImGui::Checkbox("63 Bit Codes", &mortonSorter.wide);
+            ImGui::SliderInt("Sort Every N Steps", &sortEvery, 1, 600);
+            ImGui::Text("Last sort: %.3f ms", sortMs);
+            if (missCounter.available())
+                ImGui::Text("Cache misses, update: %.0f cull: %.0f", updateMisses, cullMisses);
+            else
+                ImGui::Text("Cache miss counters unavailable");
+            int sleeping = 0;
+            for (auto& gen : gens)
+                sleeping += gen.pd.n_alive - gen.pd.n_awake;
+            ImGui::Text("Sleeping particles: %d", sleeping);
+
+            ImGui::End();
+
+            ImGui::Begin("Force Fields");
+            fields.gui();
+            if (ImGui::Button("Add Wind"))
+                fields.add<WindField>(glm::vec3(1.0f, 0.0f, 0.0f), 1.0f);
+            if (ImGui::Button("Add Drag"))
+                fields.add<DragField>(0.1f);
+            if (ImGui::Button("Add Vortex"))
+                fields.add<VortexField>(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 10.0f)->setRegion(glm::vec3(0.0f), glm::vec3(10.0f));
+            if (ImGui::Button("Add Attractor"))
+                fields.add<PointAttractor>(glm::vec3(0.0f), 10.0f)->setRegion(glm::vec3(0.0f), glm::vec3(10.0f));
+            if (ImGui::Button("Add Lorenz Grid")) {
+                LorenzField lorenz(10.0f, 28.0f, 8.0f / 3.0f);
+                GridField* grid = fields.add<GridField>();
+                grid->grid.bake(glm::vec3(-30.0f, -30.0f, -10.0f), glm::vec3(30.0f, 30.0f, 60.0f), glm::ivec3(64), false,
+                    [&](const glm::vec3& p) { return lorenz.flow(p); });
+                grid->bmin = grid->grid.bmin;
+                grid->bmax = grid->grid.bmax;
+            }
+            if (ImGui::Button("Add Curl Noise"))
+                fields.add<CurlNoiseField>(4.0f, 5.0f, 1.0f, scene.seed)->factor = 1.0f;
+            ImGui::End();
+        }
 
         //TODO: Simulation Part
         // first determine whether it is time to simulate by checking t and now
@@ -415,107 +980,28 @@ int main() {
         //printf("Second Passed from last sim: %f\n ,simTime in sim: %f\n", secPassed, t);
 
         if ((timeToSimulate || stepSim)) {//secPassed.count() >= h  &&
-            pgen1.t += deltaTimeFrame;
-            pgen2.t += deltaTimeFrame;
-            if (pgen1.t > pgen1.P && pgen1.pnum < MAX_PARTICLE_PER_GENERATOR) {
-                pgen1.t = 0.0f;
-                glm::vec3 vgen = pgen1.v + 3.0f * pgen1.d;
-                glm::vec3 var = glm::vec3(velVariance, velVariance, velVariance);
-                glm::vec3 vgenc = glm::gaussRand(vgen, var-glm::dot(var,vgen));
-                pgen1.pcpus[pgen1.pnum] = {
-                    vgenc,
-                    0.1,
-                    120.0,
-                    0.1,
-                    0.1,
-                    0.0
-                    };
-                pgen1.pgpus[pgen1.pnum] = {
-                    glm::gaussRand(pgen1.p,glm::vec3(.1,0.1,0.1)),   // position
-                    (1-(glm::length(pgen1.pcpus[pgen1.pnum].v) / 100.0f))*glm::vec3(.0,.0,1.0)+
-                    (glm::length(pgen1.pcpus[pgen1.pnum].v) * glm::vec3(1.0,.0,.0)/100.0f)};
-                pgen1.pnum += 1;
+            // fixed steps of the scene timestep so window and headless runs of a scene agree
+            if (mortonSort && simSteps % sortEvery == 0) {
+                PROFILE_SCOPE("Sort");
+                std::chrono::steady_clock::time_point sortStart = std::chrono::steady_clock::now();
+                for (auto& gen : gens)
+                    mortonSorter.sort(gen.pd);
+                sortMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
             }
+            simSteps++;
 
-            if (pgen2.t > pgen2.P && pgen2.pnum < MAX_PARTICLE_PER_GENERATOR) {
-                pgen2.t = 0.0f;
-                glm::vec3 vgen = pgen2.v + 3.0f*pgen2.d;
-                glm::vec3 var = glm::vec3(velVariance, velVariance, velVariance);
-                glm::vec3 vgenc = glm::gaussRand(vgen, var - glm::dot(var, vgen));
-                pgen2.pcpus[pgen2.pnum] = {
-                    vgenc,
-                    0.1,
-                    120.0,
-                    0.1,
-                    0.1,
-                    0.0
-                };
-                pgen2.pgpus[pgen2.pnum] = {
-                    glm::gaussRand(pgen2.p,glm::vec3(.1,0.1,0.1)),   // position
-                    (1 - (glm::length(pgen2.pcpus[pgen2.pnum].v) / 100.0f))* glm::vec3(.0,.0,1.0) +
-                    (glm::length(pgen2.pcpus[pgen2.pnum].v) * glm::vec3(1.0,.0,.0) / 100.0f) };
-                pgen2.pnum += 1;
-            }
-            //update generator locations
-            pgen1.p += pgen1.v * deltaTimeFrame;
-            pgen2.p += pgen2.v * deltaTimeFrame;
-
-            //integration
-            
-            for (int i = 0; i < pgen1.pnum; i++) {
-                glm::vec3 velocity;
-                velocity.x = sigma * (pgen1.pgpus[i].p.y - pgen1.pgpus[i].p.x);
-                velocity.y = pgen1.pgpus[i].p.x * (rho - pgen1.pgpus[i].p.z) - pgen1.pgpus[i].p.y;
-                velocity.z = pgen1.pgpus[i].p.x * pgen1.pgpus[i].p.y - beta * pgen1.pgpus[i].p.z;
-                glm::vec3 p_prev = pgen1.pgpus[i].p;
-                float d = glm::dot(pgen1.pgpus[i].p - tri[0], norm);
-                pgen1.pgpus[i].p += pgen1.pcpus[i].v * deltaTimeFrame;
-                float dn = glm::dot(pgen1.pgpus[i].p - tri[0], norm);
-                pgen1.pcpus[i].v += g * glm::vec3(0.0, 0.0, -1.0) * deltaTimeFrame;
-                pgen1.pcpus[i].v = (1 - lorenzFac * 0.01f) * pgen1.pcpus[i].v + lorenzFac * 0.01f * velocity;
-                if (signbit(d) != signbit(dn)) {
-                    printf("coll level 1\n");
-                    //collision may happened need to check projections
-                    glm::vec3 collP = p_prev + pgen1.pcpus[i].v * deltaTimeFrame * (abs(d) / (abs(d) + abs(dn)));
-                    //for xy
-                    float e1 = hpSign(glm::vec2(collP.y, collP.z), glm::vec2(tri[0].y, tri[0].z), glm::vec2(tri[1].y, tri[1].z));
-                    float e2 = hpSign(glm::vec2(collP.y, collP.z), glm::vec2(tri[1].y, tri[1].z), glm::vec2(tri[2].y, tri[2].z));
-                    float e3 = hpSign(glm::vec2(collP.y, collP.z), glm::vec2(tri[2].y, tri[2].z), glm::vec2(tri[0].y, tri[0].z));
-
-                    if (signbit(e1) == signbit(e2) && signbit(e2) == signbit(e3)) {
-                        printf("coll level 2\n");
-                        printf("coll happened\n");
-                        pgen1.pgpus[i].p -= 2.0f*glm::dot(pgen1.pgpus[i].p,norm)*norm;
-                        glm::vec3 vn = glm::dot(pgen1.pcpus[i].v, norm) * norm;
-
-                        glm::vec3 vt = pgen1.pcpus[i].v - vn;
-                        pgen1.pcpus[i].v = -vn+vt;
-                    }
-                }
-                
-                pgen1.pgpus[i].c =
-                    (1 - (glm::length(pgen1.pcpus[i].v) / 100.0f)) * glm::vec3(.0, .0, 1.0) +
-                    (glm::length(pgen1.pcpus[i].v) * glm::vec3(1.0, .0, .0) / 100.0f);
-            }
-            
-            for (int i = 0; i < pgen2.pnum; i++) {
-                glm::vec3 velocity;
-                velocity.x = sigma * (pgen2.pgpus[i].p.y - pgen2.pgpus[i].p.x);
-                velocity.y = pgen2.pgpus[i].p.x * (rho - pgen2.pgpus[i].p.z) - pgen2.pgpus[i].p.y;
-                velocity.z = pgen2.pgpus[i].p.x * pgen2.pgpus[i].p.y - beta * pgen2.pgpus[i].p.z;
-                pgen2.pgpus[i].p += pgen2.pcpus[i].v * deltaTimeFrame;
-                pgen2.pcpus[i].v += g * glm::vec3(0.0, 0.0, -1.0) * deltaTimeFrame;
-                pgen2.pcpus[i].v = (1 - lorenzFac*0.01f) * pgen2.pcpus[i].v + lorenzFac * 0.01f * velocity;
-                pgen2.pgpus[i].c =
-                    (1 - (glm::length(pgen2.pcpus[i].v) / 100.0f)) * glm::vec3(.0, .0, 1.0) +
-                    (glm::length(pgen2.pcpus[i].v) * glm::vec3(1.0, .0, .0) / 100.0f);
-            }
+            missCounter.start();
+            simulateStep(gens, fields, collider, sdfCollider, scene, h);
+            updateMisses = 0.9f * updateMisses + 0.1f * (float)missCounter.read();
 
-            pgen1vb.UpdateData(&pgen1.pgpus[0], sizeof(particle_gpu) * pgen1.pnum);
-            pgen2vb.UpdateData(&pgen2.pgpus[0], sizeof(particle_gpu) * pgen2.pnum);
+            if (trails) {
+                PROFILE_GPU_SCOPE("Trails");
+                for (auto& gen : gens)
+                    gen.trail->record(gen.pd);
+            }
 
             stepSim = false;
-            t += deltaTimeFrame;
+            t += h;
             t_sim = std::chrono::steady_clock::now();
         }
 
@@ -526,23 +1012,39 @@ int main() {
             glLineWidth(lineSize);
         }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (gui) {
+            profiler.gui();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            PROFILE_GPU_SCOPE("ImGui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        context->present();
+        if (benchFrames > 0)
+            glFinish();
+        profiler.endFrame();
+        frameIndex++;
     }
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (benchFrames > 0) {
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - benchStart).count();
+        int alive = 0;
+        for (auto& gen : gens)
+            alive += gen.pd.n_alive;
+        printf("backend: %s size: %dx%d renderer: %s\n", GLContext::backendName(context->getBackend()), width, height, (const char*)glGetString(GL_RENDERER));
+        printf("frames: %d time: %.3f ms (%.2f fps) particles: %d\n", frameIndex, ms, frameIndex > 0 ? 1000.0f * frameIndex / ms : 0.0f, alive);
+        profiler.printSummary();
+    }
 
-    delete pgen1.pgpus;
-    delete pgen1.pcpus;
-    delete pgen2.pgpus;
-    delete pgen2.pcpus;
+    capture.reset();
+    profiler.shutdownGpu();
 
-    glfwTerminate();
+    if (gui) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     return 0;
 }
@@ -60,17 +60,58 @@ Shader::Shader(const char* vertexPath, const char* fragPath) {
     glAttachShader(ID, fragShader);
     glLinkProgram(ID);
 
-    glGetShaderiv(ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
 
     if (!success) {
-        glGetShaderInfoLog(ID, 512, NULL, errLog);
+        glGetProgramInfoLog(ID, 512, NULL, errLog);
         std::cout << "ERROR: Shader Program Linking Failed\n" << errLog << std::endl;
     }
+    else {
+        reflect();
+    }
     
     glDeleteShader(vertexShader);
     glDeleteShader(fragShader);
 }
 
+// active uniforms are queried once after linking, the driver is not asked again per set
+void Shader::reflect() {
+    int count = 0;
+    int maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::string name(maxLength, '\0');
+    for (int i = 0; i < count; i++) {
+        GLsizei length = 0;
+        UniformInfo info;
+        glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &info.size, &info.type, &name[0]);
+        std::string key = name.substr(0, length);
+        info.location = glGetUniformLocation(ID, key.c_str());
+        // uniform block members have no location
+        if (info.location < 0)
+            continue;
+        // arrays are reported as name[0], they are set through their plain name
+        if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+            key.resize(key.size() - 3);
+        uniforms[key] = info;
+    }
+}
+
+GLint Shader::location(const std::string& name) const {
+    auto it = uniforms.find(name);
+    return it == uniforms.end() ? -1 : it->second.location;
+}
+
+bool Shader::typeMatches(GLenum actual, GLenum expected) {
+    if (actual == expected)
+        return true;
+    // samplers take their texture unit as an int, bools may be set from an int too
+    if (expected == GL_INT)
+        return actual == GL_BOOL || (actual >= GL_SAMPLER_1D && actual <= GL_SAMPLER_2D_SHADOW)
+            || actual == GL_SAMPLER_2D_ARRAY || actual == GL_SAMPLER_BUFFER;
+    return false;
+}
+
 Shader::~Shader() {
     glDeleteProgram(ID);
 }
@@ -79,15 +120,21 @@ void Shader::use() {
     glUseProgram(ID);
 }
 
+void Shader::bindBlock(const char* name, unsigned int binding) const {
+    GLuint index = glGetUniformBlockIndex(ID, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, binding);
+}
+
 void Shader::setBool(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(location(name), (int)value);
 }
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(location(name), value);
 }
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(location(name), value);
 }
-void Shader::setMat4(const std::string& name, glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
+    glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
 }
\ No newline at end of file
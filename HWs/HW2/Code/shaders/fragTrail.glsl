@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in float fAge;
+
+uniform vec3 trailColor;
+
+void main()
+{
+	FragColor = vec4(trailColor, 1.0f - fAge);
+}
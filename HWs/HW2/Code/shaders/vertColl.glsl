@@ -3,8 +3,15 @@
 layout (location = 0) in vec3 aPos;
 //layout (location = 1) in vec3 aCol;
 
-uniform mat4 view;
-uniform mat4 projection;
+// shared by all programs, see CameraBuffer.h
+layout (std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition; // xyz
+	vec4 viewport; // width, height, near, far
+};
+
 uniform mat4 model;
 
 out vec3 fragPos;
@@ -13,5 +20,5 @@ out vec3 fragPos;
 void main() {
 	fragPos = vec3(model * vec4(aPos, 1.0f));
 	//fragCol = aCol;
-	gl_Position = projection * view * vec4(fragPos, 1.0f);
+	gl_Position = viewProjection * vec4(fragPos, 1.0f);
 }
\ No newline at end of file
@@ -3,8 +3,14 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 
-uniform mat4 view;
-uniform mat4 projection;
+// shared by all programs, see CameraBuffer.h
+layout (std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition; // xyz
+	vec4 viewport; // width, height, near, far
+};
 
 out vec3 fColor;
 out vec3 fragPos;
@@ -12,5 +18,5 @@ out vec3 fragPos;
 void main() {
 	fragPos = aPos;
 	fColor = aColor;
-	gl_Position = projection * view * vec4(fragPos, 1.0f);
+	gl_Position = viewProjection * vec4(fragPos, 1.0f);
 }
\ No newline at end of file
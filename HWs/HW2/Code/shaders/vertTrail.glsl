@@ -0,0 +1,31 @@
+#version 330 core
+
+// shared by all programs, see CameraBuffer.h
+layout (std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition; // xyz
+	vec4 viewport; // width, height, near, far
+};
+
+// see TrailBuffer.h, slice major, one vec4 per slot, xyz position and w the valid samples
+uniform samplerBuffer history;
+uniform int head;
+uniform int trailLength;
+uniform int slots;
+
+out float fAge;
+
+// one instance per slot, vertex k of the strip is k slices back from head, past the valid
+// samples it repeats the oldest one so the rest of the strip has no length
+void main() {
+	int slot = gl_InstanceID;
+	int valid = int(texelFetch(history, head * slots + slot).w);
+	int back = min(gl_VertexID, max(valid - 1, 0));
+	int slice = (head - back + trailLength) % trailLength;
+	vec3 p = texelFetch(history, slice * slots + slot).xyz;
+	fAge = float(back) / float(trailLength);
+	// slots without a particle are put outside the clip volume
+	gl_Position = valid > 0 ? viewProjection * vec4(p, 1.0f) : vec4(2.0f, 2.0f, 2.0f, 1.0f);
+}